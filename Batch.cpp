@@ -0,0 +1,444 @@
+/*********************************************************************
+ ** Program Filename: Batch.cpp, Batch class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Batch class implementation, runs a Game of Life
+ **   simulation without a terminal: no screen output and no pauses,
+ **   only the final state and the time taken.
+ ** Input: seed pattern file or pattern from a library, checkpoint
+ **   file to resume from or fill of a random soup, location, number of
+ **   generations, rule
+ ** Output: summary of the run, any cycle the pattern settles into,
+ **   final live cells in Life 1.06 format, checkpoint files,
+ **   statistics of each generation, PGM, PNG or GIF pictures
+ *********************************************************************/
+
+#include "Batch.hpp"
+#include "Soup.hpp"
+#include <iostream> // header file for input and output stream objects
+#include <fstream>  // header file for file streams
+#include <cstdio>   // header file for snprintf
+#include <chrono>   // header file for clocks
+
+
+/*********************************************************************
+ ** Function:  Batch
+ ** Description:  Batch class constructor
+ ** Parameters: Engine to simulate with, visible grid dimensions for
+ **   the bounded engines and number of threads.
+ ** Pre-Conditions: none
+ ** Post-Conditions:  The engine is created.
+ *********************************************************************/
+
+Batch::Batch(Backend b, int ncol, int nrow, int nthreads) {
+    engine = Engine::create(b, ncol, nrow, nthreads);
+    hide = Grid(1, 1).getHide();
+    cols = ncol;
+    rows = nrow;
+    checkpointEvery = 0;
+    exportEvery = 0;
+    patternSet = false;
+    soupFill = -1;
+    soupSeed = 1;
+}
+
+
+/*********************************************************************
+ ** Function:  ~Batch
+ ** Description:  Batch class destructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions:  The engine is deallocated.
+ *********************************************************************/
+
+Batch::~Batch() {
+    delete engine;
+}
+
+
+// make the engine follow a rule; false, after printing the reason,
+// if the rule cannot be read or the engine cannot run it
+bool Batch::useRule(std::string name) {
+    Rule rule;
+    if (!rule.parse(name)) {
+        std::cerr << rule.getError() << std::endl;
+        return false;
+    }
+    if (!engine->setRule(rule)) {
+        std::cerr << "The " << engine->getName() << " engine cannot run ";
+        std::cerr << rule.getName() << "; try --backend=bool" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: setRule
+ ** Description: Choose the rule to run, instead of the one named in
+ **   the seed pattern or checkpoint file.
+ ** Parameters: Rule string, or empty to use the file's rule.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Later runs and restores use the rule.
+ *********************************************************************/
+
+void Batch::setRule(std::string name) {
+    ruleName = name;
+}
+
+
+/*********************************************************************
+ ** Function: setBoundary
+ ** Description: Choose the edges of the grid: the hidden margin of a
+ **   plane, dead cells, or wrapping around as a torus or Klein bottle.
+ ** Parameters: Boundary.
+ ** Pre-Conditions: Called before any cells are restored or seeded.
+ ** Post-Conditions: Returns false, after printing the reason, if the
+ **   engine has no edges to choose.
+ *********************************************************************/
+
+bool Batch::setBoundary(Boundary b) {
+    if (!engine->setBoundary(b)) {
+        std::cerr << "The " << engine->getName() << " engine has no edges";
+        std::cerr << "; try --backend=packed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// step k generations per pass over memory; false, after printing the
+// reason, if the engine steps one at a time
+bool Batch::setBlock(int k) {
+    if (!engine->setBlock(k)) {
+        std::cerr << "The " << engine->getName() << " engine steps one";
+        std::cerr << " generation per pass; try --backend=packed";
+        std::cerr << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: restore
+ ** Description: Resume a simulation from a checkpoint file.
+ ** Parameters: Checkpoint file and whether to check the checksum of
+ **   all its cells, rather than only of its header.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The engine holds the checkpoint's cells and
+ **   generation, and follows its rule unless another was chosen.
+ **   Returns false, after printing the reason, if the file could not
+ **   be restored.
+ *********************************************************************/
+
+bool Batch::restore(std::string fileName, bool verify) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    if (!snapshot.read(fileName, verify)) {
+        std::cerr << snapshot.getError() << std::endl;
+        return false;
+    }
+    if (!useRule(ruleName.empty() ? snapshot.getRule() : ruleName)) {
+        return false;
+    }
+    if (!engine->loadState(snapshot)) {
+        std::cerr << snapshot.getError() << std::endl;
+        return false;
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "restored generation: " << engine->getGeneration();
+    std::cout << " (" << seconds << " seconds)" << std::endl;
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: setCheckpoint
+ ** Description: Save checkpoints while running.
+ ** Parameters: Checkpoint file and number of generations between
+ **   checkpoints (0 to save only at the end).
+ ** Pre-Conditions: none
+ ** Post-Conditions: Later runs save the cells to the file, replacing
+ **   it each time, on a background thread.
+ *********************************************************************/
+
+void Batch::setCheckpoint(std::string fileName, long long every) {
+    checkpointFile = fileName;
+    checkpointEvery = every;
+}
+
+
+/*********************************************************************
+ ** Function: setCycleAction
+ ** Description: Choose what a run does when its board repeats.
+ ** Parameters: Action: look only with engines that keep their hash up
+ **   to date (auto), do not look (off), stop the run (stop), or skip
+ **   ahead whole periods to the last generation (skip).
+ ** Pre-Conditions: none
+ ** Post-Conditions: Later runs report any cycle found.
+ *********************************************************************/
+
+void Batch::setCycleAction(CycleAction action) {
+    cycles.setAction(action);
+}
+
+
+/*********************************************************************
+ ** Function: setHistory
+ ** Description: Write the statistics of each generation as it is run.
+ ** Parameters: File or named pipe to write to, or empty for none.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Later runs step one generation at a time and write
+ **   a line of comma separated values for each: the generation,
+ **   population, births, deaths and the screen coordinates of the box
+ **   around the live cells.  Values not known are left empty.
+ *********************************************************************/
+
+void Batch::setHistory(std::string fileName) {
+    historyFile = fileName;
+}
+
+
+/*********************************************************************
+ ** Function: setExport
+ ** Description: Export pictures of the visible cells while running.
+ ** Parameters: File, ending in .pgm or .png for a file per picture
+ **   or .gif for an animated GIF; generations between pictures; cells
+ **   per side of a pixel, pixels per side of a pixel and, for a GIF,
+ **   hundredths of a second per picture.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Later runs export the first generation and every
+ **   multiple of the generations between pictures.  Returns false,
+ **   after printing the reason, if the pictures cannot be written.
+ *********************************************************************/
+
+bool Batch::setExport(std::string fileName, long long every, int scale,
+                      int zoom, int delay) {
+    if (!exporter.open(fileName, hide + 1, hide + 1, cols, rows, scale, zoom,
+                       delay)) {
+        std::cerr << exporter.getError() << std::endl;
+        return false;
+    }
+    exportEvery = every;
+    return true;
+}
+
+// write the statistics of the current generation as a line of the
+// history, in screen coordinates
+void Batch::writeStats(std::ostream &out) {
+    CellStats stats = engine->getStats();
+    char line[160];
+    int n = snprintf(line, sizeof(line), "%lld,%lld,", engine->getGeneration(),
+                     stats.population);
+    if (stats.births >= 0) {
+        n += snprintf(line + n, sizeof(line) - n, "%lld,%lld", stats.births,
+                      stats.deaths);
+    } else {
+        n += snprintf(line + n, sizeof(line) - n, ",");
+    }
+    if (!stats.isEmpty()) {
+        n += snprintf(line + n, sizeof(line) - n, ",%lld,%lld,%lld,%lld\n",
+                      stats.minX - hide, stats.minY - hide,
+                      stats.maxX - hide, stats.maxY - hide);
+    } else {
+        n += snprintf(line + n, sizeof(line) - n, ",,,,\n");
+    }
+    out.write(line, n);
+}
+
+// start runs without a seed pattern file from a pattern already read,
+// such as one from a PatternLibrary
+void Batch::setPattern(const Seed &seed) {
+    pattern = seed;
+    patternSet = true;
+}
+
+// start runs without a seed pattern from a random soup filling the
+// visible grid, each cell live with chance fill
+void Batch::setSoup(double fill, uint64_t seed) {
+    soupFill = fill;
+    soupSeed = seed;
+}
+
+
+/*********************************************************************
+ ** Function: run
+ ** Description: Load a seed pattern, run it for a number of
+ **   generations under the chosen rule, the seed's or Conway's Life,
+ **   and report the result.
+ ** Parameters: Seed pattern file (none if empty, to start from the
+ **   pattern or soup if one was set, or else to continue from the
+ **   engine's current cells), number of generations, screen
+ **   coordinates to center the pattern at and the file to write the
+ **   final live cells to (none if empty).
+ ** Pre-Conditions: none
+ ** Post-Conditions: A summary is printed to standard output, with
+ **   the period and first generation of the cycle the pattern settled
+ **   into if cycles were looked for.  Returns
+ **   the program exit status: 0 on success, 1 if a file could not be
+ **   read or written or the rule cannot be run.
+ *********************************************************************/
+
+int Batch::run(std::string seedFile, long long gens, long long x,
+               long long y, std::string outFile) {
+    if (!seedFile.empty() || patternSet) {
+        Seed seed = pattern;
+        if (!seedFile.empty() && !seed.readPath(seedFile)) {
+            std::cerr << seed.getError() << std::endl;
+            return 1;
+        }
+        std::string name = ruleName.empty() ? seed.getRule() : ruleName;
+        if (!useRule(name.empty() ? "B3/S23" : name)) {
+            return 1;
+        }
+        engine->clear();
+        engine->loadSeed(seed, x + hide, y + hide);
+    } else if (soupFill >= 0) {
+        if (!useRule(ruleName.empty() ? "B3/S23" : ruleName)) {
+            return 1;
+        }
+        engine->clear();
+        engine->loadSoup(Soup(soupSeed, soupFill), hide + 1, hide + 1,
+                         cols, rows);
+    }
+
+    // write the statistics of each generation, if asked to
+    std::ofstream history;
+    if (!historyFile.empty()) {
+        history.open(historyFile.c_str());
+        if (!history) {
+            std::cerr << "Could not create " << historyFile << std::endl;
+            return 1;
+        }
+        history << "generation,population,births,deaths,";
+        history << "min_x,min_y,max_x,max_y" << std::endl;
+        writeStats(history);
+    }
+    if (exporter.isOpen()) {
+        exporter.capture(*engine);
+    }
+
+    // step, handing a copy of the cells to the checkpoint writer and
+    // exporter every so often; the simulation only waits while it is
+    // copied
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    cycles.clear();
+    for (long long done = 0; done < gens && !cycles.isStopped(); ) {
+        long long n = gens - done;
+        if (!checkpointFile.empty() && checkpointEvery > 0 &&
+            n > checkpointEvery) {
+            n = checkpointEvery;
+        }
+        if (exporter.isOpen() && n > exportEvery - done % exportEvery) {
+            n = exportEvery - done % exportEvery;
+        }
+        if (!historyFile.empty()) {
+            n = 1;
+        }
+        long long stepped = cycles.advance(*engine, n);
+        done += stepped;
+        if (!historyFile.empty() && stepped > 0) {
+            writeStats(history);
+        }
+        if (exporter.isOpen() && stepped > 0 && done % exportEvery == 0) {
+            exporter.capture(*engine);
+        }
+        if (!checkpointFile.empty() && done < gens && !cycles.isStopped()) {
+            engine->saveState(snapshot);
+            snapshot.writeAsync(checkpointFile);
+        }
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    if (!historyFile.empty()) {
+        history.close();
+        if (history.fail()) {
+            std::cerr << "Could not write " << historyFile << std::endl;
+            return 1;
+        }
+    }
+    long long frames = exporter.getFrames();
+    if (exporter.isOpen() && !exporter.finish()) {
+        std::cerr << exporter.getError() << std::endl;
+        return 1;
+    }
+    if (!checkpointFile.empty()) {
+        engine->saveState(snapshot);
+        if (!snapshot.write(checkpointFile) || !snapshot.finish()) {
+            std::cerr << snapshot.getError() << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "engine: " << engine->getName() << std::endl;
+    std::cout << "rule: " << engine->getRule().getName() << std::endl;
+    if (engine->getBoundary() != PLANE_BOUNDARY) {
+        std::cout << "boundary: " << Engine::boundaryName(engine->getBoundary());
+        std::cout << std::endl;
+    }
+    std::cout << "generations: " << engine->getGeneration() << std::endl;
+    std::cout << "population: " << engine->getPopulation() << std::endl;
+    if (cycles.isWatching(*engine)) {
+        std::cout << "cycle: " << cycles.describe() << std::endl;
+    }
+    if (frames > 0) {
+        std::cout << "pictures: " << frames << std::endl;
+    }
+    std::cout << "seconds: " << seconds << std::endl;
+    if (seconds > 0) {
+        std::cout << "generations/second: " << gens / seconds << std::endl;
+    }
+
+    if (!outFile.empty() && !writeCells(outFile)) {
+        std::cerr << "Could not write " << outFile << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// output file and buffered text of the cells written so far
+struct CellWriter {
+    std::ofstream *file;    // output file
+    std::string text;       // lines not yet written
+    long long offset;       // engine to screen coordinate offset
+};
+
+// append a live cell to the output, writing out full buffers
+static void writeCell(void *context, long long x, long long y) {
+    CellWriter *out = static_cast<CellWriter *>(context);
+    char line[48];
+    int n = snprintf(line, sizeof(line), "%lld %lld\n",
+                     x - out->offset, y - out->offset);
+    out->text.append(line, n);
+    if (out->text.size() > (1 << 20)) {
+        out->file->write(out->text.data(), out->text.size());
+        out->text.clear();
+    }
+}
+
+
+/*********************************************************************
+ ** Function: writeCells
+ ** Description: Write the live cells to a Life 1.06 format file in
+ **   screen coordinates, so it can be read back as a seed.
+ ** Parameters: File name.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false if the file could not be written.
+ *********************************************************************/
+
+bool Batch::writeCells(std::string fileName) {
+    std::ofstream file(fileName.c_str());
+    if (!file) {
+        return false;
+    }
+    file << "#Life 1.06" << std::endl;
+    CellWriter out;
+    out.file = &file;
+    out.offset = hide;
+    engine->forEachCell(writeCell, &out);
+    file.write(out.text.data(), out.text.size());
+    file.close();
+    return !file.fail();
+}
@@ -0,0 +1,69 @@
+/*********************************************************************
+ ** Program Filename: Batch.hpp, Batch class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Batch class specification, runs a Game of Life
+ **   simulation without a terminal: no screen output and no pauses,
+ **   only the final state and the time taken.  A run that
+ **   settles into a still life or oscillator can stop there or skip
+ **   ahead whole periods.  Each generation's population, births,
+ **   deaths and bounding box can be written to a file as it is run,
+ **   and pictures of the board exported every so many generations.
+ ** Input: seed pattern file or pattern from a library, checkpoint
+ **   file to resume from or fill of a random soup, location, number of
+ **   generations, rule
+ ** Output: summary of the run, any cycle the pattern settles into,
+ **   final live cells in Life 1.06 format, checkpoint files,
+ **   statistics of each generation, PGM, PNG or GIF pictures
+ *********************************************************************/
+
+#ifndef Batch_hpp
+#define Batch_hpp
+
+#include <string>   // header file for string objects
+#include <ostream>  // header file for output streams
+#include "Engine.hpp"
+#include "Seed.hpp"
+#include "Snapshot.hpp"
+#include "CycleDetector.hpp"
+#include "Exporter.hpp"
+
+class Batch {
+private:
+    Engine *engine;         // engine running the simulation
+    int hide;               // offset from screen to engine coordinates
+    int cols, rows;         // visible grid dimensions
+    Snapshot snapshot;      // copy of the cells being checkpointed
+    std::string checkpointFile; // checkpoint file, empty for none
+    long long checkpointEvery;  // generations between checkpoints
+    std::string ruleName;   // rule to run, empty for the file's rule
+    CycleDetector cycles;   // watches the run for a repeating board
+    std::string historyFile;    // file of each generation's statistics
+    Exporter exporter;      // writes pictures of the board
+    long long exportEvery;  // generations between pictures
+    Seed pattern;           // pattern to start from, if set
+    bool patternSet;        // true if runs start from the pattern
+    double soupFill;        // fill of a soup to start from, or -1
+    uint64_t soupSeed;      // random number seed of the soup
+    bool useRule(std::string);  // make the engine follow a rule
+    void writeStats(std::ostream &);    // write a generation's statistics
+    Batch(const Batch &);               // not copyable
+    Batch &operator=(const Batch &);    // not assignable
+public:
+    Batch(Backend, int, int, int);  // constructor
+    ~Batch();                       // destructor
+    void setRule(std::string);      // run a rule instead of the file's
+    bool setBoundary(Boundary);     // choose the edges of the grid
+    bool setBlock(int);             // generations per pass over memory
+    bool restore(std::string, bool);    // resume from a checkpoint
+    void setPattern(const Seed &);      // start from a pattern read
+    void setSoup(double, uint64_t);     // start from a random soup
+    void setCheckpoint(std::string, long long); // save checkpoints
+    void setCycleAction(CycleAction);   // choose what a cycle does
+    void setHistory(std::string);       // write statistics as it runs
+    bool setExport(std::string, long long, int, int, int); // pictures
+    int run(std::string, long long, long long, long long, std::string);
+    bool writeCells(std::string);   // write live cells to a file
+};
+
+#endif /* Batch_hpp */
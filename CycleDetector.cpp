@@ -0,0 +1,230 @@
+/*********************************************************************
+ ** Program Filename: CycleDetector.cpp, CycleDetector class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: CycleDetector class implementation, watches a
+ **   simulation for a board it has seen before, then stops the run or
+ **   skips ahead whole periods.
+ ** Input: engine to step, number of generations, action on a cycle
+ ** Output: period and first generation of the cycle, if any
+ *********************************************************************/
+
+#include "CycleDetector.hpp"
+
+
+/*********************************************************************
+ ** Function:  CycleDetector
+ ** Description:  CycleDetector class constructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions:  No generations have been seen; cycles are looked
+ **   for with engines that keep their hash up to date, and skipped.
+ *********************************************************************/
+
+CycleDetector::CycleDetector() {
+    action = CYCLE_AUTO;
+    window = 1 << 16;
+    clear();
+}
+
+
+/*********************************************************************
+ ** Function: parseAction
+ ** Description: Convert the name of an action to take on a cycle.
+ ** Parameters: Name (auto, off, stop or skip) and the action to store
+ **   the result in.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false if the name is not recognized.
+ *********************************************************************/
+
+bool CycleDetector::parseAction(const std::string &name, CycleAction &a) {
+    if (name == "auto") {
+        a = CYCLE_AUTO;
+    } else if (name == "off") {
+        a = CYCLE_OFF;
+    } else if (name == "stop") {
+        a = CYCLE_STOP;
+    } else if (name == "skip") {
+        a = CYCLE_SKIP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// choose what to do once a cycle is found
+void CycleDetector::setAction(CycleAction a) {
+    action = a;
+}
+
+// set the number of generations kept in the table, the longest period
+// that can be found
+void CycleDetector::setWindow(size_t n) {
+    window = n < 1 ? 1 : n;
+}
+
+// forget every generation seen and any cycle found
+void CycleDetector::clear() {
+    seen.clear();
+    order.clear();
+    period = 0;
+    onset = 0;
+    extinct = false;
+    stopped = false;
+    candidate = 0;
+}
+
+// true if cycles are looked for when stepping an engine
+bool CycleDetector::isWatching(Engine &engine) {
+    return action == CYCLE_STOP || action == CYCLE_SKIP ||
+           (action == CYCLE_AUTO && engine.tracksHash());
+}
+
+
+/*********************************************************************
+ ** Function: watch
+ ** Description: Add the engine's current generation to the table.
+ ** Parameters: The engine.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns true if the board is empty, or if it
+ **   confirms a repeat: a board whose hash is in the table is only a
+ **   candidate, and the cycle is found, with its period and first
+ **   generation set, when the same hash and population are seen again
+ **   a period later.  Otherwise the candidate is dropped as two boards
+ **   sharing a hash.  The oldest generation is dropped once the table
+ **   holds the window's worth.
+ *********************************************************************/
+
+bool CycleDetector::watch(Engine &engine) {
+    uint64_t hash = engine.getHash();
+    long long generation = engine.getGeneration();
+
+    // an empty board hashes to zero; anything else almost never does
+    if (hash == 0 && engine.getPopulation() == 0) {
+        period = 1;
+        onset = generation;
+        extinct = true;
+        return true;
+    }
+
+    // confirm or drop a repeat seen a period ago
+    if (candidate > 0 && generation == confirmAt) {
+        if (hash == candidateHash &&
+            engine.getPopulation() == candidatePopulation) {
+            period = candidate;
+            onset = candidateOnset;
+            return true;
+        }
+        candidate = 0;
+    }
+    std::unordered_map<uint64_t, long long>::iterator it = seen.find(hash);
+    if (it != seen.end()) {
+        if (candidate == 0) {
+            candidate = generation - it->second;
+            candidateOnset = it->second;
+            confirmAt = generation + candidate;
+            candidateHash = hash;
+            candidatePopulation = engine.getPopulation();
+        }
+        return false;
+    }
+    seen[hash] = generation;
+    order.push_back(hash);
+    if (order.size() > window) {
+        seen.erase(order.front());
+        order.pop_front();
+    }
+    return false;
+}
+
+
+/*********************************************************************
+ ** Function: advance
+ ** Description: Step an engine, watching each generation for a cycle.
+ ** Parameters: The engine and number of generations.
+ ** Pre-Conditions: The detector was cleared when the engine's cells
+ **   were last replaced.
+ ** Post-Conditions: Returns the number of generations the engine
+ **   advanced.  This is n unless a cycle stops the run, which then
+ **   stays stopped, a period after the repeat that confirmed the
+ **   cycle.  When skipping, once a cycle is found only the
+ **   generations left over after whole periods are stepped, and the
+ **   generation count is set to where n generations would have taken
+ **   it; the cells are the same as if every one had been stepped.
+ *********************************************************************/
+
+long long CycleDetector::advance(Engine &engine, long long n) {
+    if (n <= 0 || stopped) {
+        return 0;
+    }
+    if (!isWatching(engine)) {
+        engine.step(n);
+        return n;
+    }
+    if (period == 0 && seen.empty() && watch(engine)) {
+        stopped = action == CYCLE_STOP;
+        if (stopped) {
+            return 0;
+        }
+    }
+    for (long long i = 0; i < n; i++) {
+        if (period > 0) {
+            long long end = engine.getGeneration() + n - i;
+            engine.step((n - i) % period);
+            engine.setGeneration(end);
+            return n;
+        }
+        engine.step(1);
+        if (watch(engine) && action == CYCLE_STOP) {
+            stopped = true;
+            return i + 1;
+        }
+    }
+    return n;
+}
+
+// true once a cycle has been found
+bool CycleDetector::isFound() {
+    return period > 0;
+}
+
+// true if a cycle was found and ended the run
+bool CycleDetector::isStopped() {
+    return stopped;
+}
+
+// period of the cycle found: 1 for a still life or empty board, 0 if
+// none was found
+long long CycleDetector::getPeriod() {
+    return period;
+}
+
+// first generation of the cycle found
+long long CycleDetector::getOnset() {
+    return onset;
+}
+
+
+/*********************************************************************
+ ** Function: describe
+ ** Description: Describe the cycle found, for run output.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns, for example, "extinct at generation 57",
+ **   "still life from generation 300", "period 2 from generation 12"
+ **   or "none found".
+ *********************************************************************/
+
+std::string CycleDetector::describe() {
+    if (period == 0) {
+        return "none found";
+    }
+    std::string from = " generation " + std::to_string(onset);
+    if (extinct) {
+        return "extinct at" + from;
+    }
+    if (period == 1) {
+        return "still life from" + from;
+    }
+    return "period " + std::to_string(period) + " from" + from;
+}
@@ -0,0 +1,67 @@
+/*********************************************************************
+ ** Program Filename: CycleDetector.hpp, CycleDetector class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: CycleDetector class specification, watches a
+ **   simulation for a board it has seen before.  The hash of each
+ **   generation's cells goes into a history table; a hash seen again
+ **   is taken for a cycle only once the same hash and population come
+ **   round again a period later, since two boards can share a hash.
+ **   The pattern has then died out, settled into a still life or
+ **   become an oscillator, whose period and first generation are
+ **   known.  The run can then stop, or skip ahead to the generation it
+ **   was asked for by stepping only what is left over after whole
+ **   periods.
+ ** Input: engine to step, number of generations, action on a cycle
+ ** Output: period and first generation of the cycle, if any
+ *********************************************************************/
+
+#ifndef CycleDetector_hpp
+#define CycleDetector_hpp
+
+#include <stdint.h>         // header file for fixed width integer types
+#include <cstddef>          // header file for size_t
+#include <string>           // header file for string objects
+#include <deque>            // header file for double ended queues
+#include <unordered_map>    // header file for hash tables
+#include "Engine.hpp"
+
+// what to do once a cycle is found: nothing (do not look for one),
+// stop the run, or skip whole periods; AUTO skips with engines that
+// keep their hash up to date and does not look with the others
+enum CycleAction { CYCLE_AUTO, CYCLE_OFF, CYCLE_STOP, CYCLE_SKIP };
+
+class CycleDetector {
+private:
+    CycleAction action;     // what to do once a cycle is found
+    std::unordered_map<uint64_t, long long> seen; // generation of a hash
+    std::deque<uint64_t> order; // hashes in the table, oldest first
+    size_t window;          // most generations kept in the table
+    long long period;       // period of the cycle, 0 until one is found
+    long long onset;        // first generation of the cycle
+    bool extinct;           // the cycle is an empty board
+    long long candidate;    // period of a repeat not yet confirmed, or 0
+    long long candidateOnset;       // generation first repeated
+    long long confirmAt;            // generation to confirm it at
+    uint64_t candidateHash;         // hash of the repeated board
+    long long candidatePopulation;  // its number of live cells
+    bool stopped;           // a cycle ended the run
+    bool watch(Engine &);   // add a generation, true if it repeats
+    CycleDetector(const CycleDetector &);               // not copyable
+    CycleDetector &operator=(const CycleDetector &);    // not assignable
+public:
+    CycleDetector();                        // constructor
+    static bool parseAction(const std::string &, CycleAction &); // by name
+    void setAction(CycleAction);            // choose what a cycle does
+    void setWindow(size_t);                 // set longest period found
+    void clear();                           // forget the generations seen
+    long long advance(Engine &, long long); // step, watching for a cycle
+    bool isWatching(Engine &);              // true if looking for cycles
+    bool isFound();                         // true once a cycle is found
+    bool isStopped();                       // true if a cycle ended the run
+    long long getPeriod();                  // get period, 1 for still lifes
+    long long getOnset();                   // get first generation of cycle
+    std::string describe();                 // describe the cycle found
+};
+
+#endif /* CycleDetector_hpp */
@@ -0,0 +1,511 @@
+/*********************************************************************
+ ** Program Filename: DomainEngine.cpp, DomainEngine class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Simulation engine that splits a bit-packed grid into
+ **   bands of rows, each stepped by a process of its own (a rank).
+ **   The ranks share one memory mapping with this process: it holds
+ **   the commands this process gives them, their answers, the cells
+ **   passed in and out, and the edge rows each rank gives its
+ **   neighbors before every time step, as the ghost rows of the
+ **   neighbors' bands.  Each rank maps the whole grid, so cells keep
+ **   their indices and hashes, but only ever touches its own band.
+ ** Input: grid dimensions, number of ranks, seed pattern, number of
+ **   generations
+ ** Output: cell states, generation count, population
+ *********************************************************************/
+
+#include "DomainEngine.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+// round a number of bytes up to whole cache lines
+static size_t wholeLines(size_t bytes) {
+    return (bytes + 63) / 64 * 64;
+}
+
+
+/*********************************************************************
+ ** Function: DomainEngine
+ ** Description: DomainEngine class constructor
+ ** Parameters: Visible grid dimensions and number of ranks.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The ranks are running, each waiting for a command,
+ **   with a dead grid.  There are at most as many ranks as the grid
+ **   has bands (one per 32 rows), and at least one.  A rank is killed
+ **   if this process dies.
+ *********************************************************************/
+
+DomainEngine::DomainEngine(int ncol, int nrow, int nranks)
+    : shape(ncol, nrow) {
+    ranks = std::max(1, std::min(nranks, shape.getMaxBands()));
+    stride = shape.getStride();
+    transferWords = std::max(static_cast<size_t>(TRANSFER),
+                             static_cast<size_t>(stride));
+    start = 0;
+    tick = 0;
+    rowsFirst = 0;
+    rowsLast = -1;
+
+    // lay out the shared memory: commands, answers, two time steps of
+    // edge rows and wrapped rows, then the transfer area
+    size_t header = wholeLines(sizeof(Shared));
+    size_t answers = wholeLines(ranks * sizeof(Result));
+    size_t rowWords = static_cast<size_t>(stride);
+    mappedLength = header + answers +
+                   ((4*ranks + 4) * rowWords + transferWords) * sizeof(uint64_t);
+    mapping = mmap(0, mappedLength, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    char *base = static_cast<char *>(mapping);
+    shared = static_cast<Shared *>(mapping);
+    results = static_cast<Result *>(static_cast<void *>(base + header));
+    edges = static_cast<uint64_t *>(static_cast<void *>(base + header +
+                                                        answers));
+    wraps = edges + 4*ranks*rowWords;
+    transfer = wraps + 4*rowWords;
+
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_barrier_init(&shared->command, &attr, ranks + 1);
+    pthread_barrier_init(&shared->exchange, &attr, ranks);
+    pthread_barrierattr_destroy(&attr);
+
+    // start the ranks; if one cannot be started, stop the others
+    pid_t parent = getpid();
+    for (int k = 0; k < ranks; k++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            if (getppid() == parent) {
+                serve(k);
+            }
+            _exit(0);
+        }
+        if (pid < 0) {
+            for (size_t c = 0; c < children.size(); c++) {
+                kill(children[c], SIGKILL);
+                waitpid(children[c], 0, 0);
+            }
+            munmap(mapping, mappedLength);
+            throw std::bad_alloc();
+        }
+        children.push_back(pid);
+    }
+}
+
+
+/*********************************************************************
+ ** Function: ~DomainEngine
+ ** Description: DomainEngine class destructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: The ranks have exited and the shared memory is
+ **   unmapped.
+ *********************************************************************/
+
+DomainEngine::~DomainEngine() {
+    run(QUIT, 0, 0);
+    for (size_t c = 0; c < children.size(); c++) {
+        waitpid(children[c], 0, 0);
+    }
+    pthread_barrier_destroy(&shared->command);
+    pthread_barrier_destroy(&shared->exchange);
+    munmap(mapping, mappedLength);
+}
+
+// name of the engine
+const char *DomainEngine::getName() {
+    return "domain";
+}
+
+// number of rank processes
+int DomainEngine::getRanks() {
+    return ranks;
+}
+
+// give every rank a command and wait until all of them have carried
+// it out.  Anything but a read may change the cells, so the rows kept
+// from the last read are dropped.
+void DomainEngine::run(Command op, long long first, long long last) {
+    shared->op = op;
+    shared->first = first;
+    shared->last = last;
+    if (op != READ) {
+        rowsLast = rowsFirst - 1;
+    }
+    pthread_barrier_wait(&shared->command);
+    if (op != QUIT) {
+        pthread_barrier_wait(&shared->command);
+    }
+}
+
+// send the cells set since the last command to the ranks, as many at
+// a time as the transfer area holds
+void DomainEngine::flush() {
+    size_t most = transferWords / 3 * 3;
+    for (size_t n = 0; n < pending.size(); n += most) {
+        size_t count = std::min(most, pending.size() - n);
+        for (size_t i = 0; i < count; i++) {
+            transfer[i] = static_cast<uint64_t>(pending[n + i]);
+        }
+        run(WRITE, count / 3, 0);
+    }
+    pending.clear();
+}
+
+// words of a row, read from the ranks along with the rows after it
+// unless the last read holds it
+const uint64_t *DomainEngine::fetchRow(int j) {
+    if (j < rowsFirst || j > rowsLast) {
+        int last = std::min(shape.getRows() - 1, j - 1 +
+                            static_cast<int>(transferWords / stride));
+        run(READ, j, last);
+        rows.assign(transfer, transfer + static_cast<size_t>(last - j + 1) *
+                                         stride);
+        rowsFirst = j;
+        rowsLast = last;
+    }
+    return &rows[static_cast<size_t>(j - rowsFirst) * stride];
+}
+
+// true if a cell index lies on the cells stepped, which on the plane
+// leaves out only the outer ring of the grid; on a torus or Klein
+// bottle the index is wrapped onto the visible cells first
+bool DomainEngine::inside(long long &x, long long &y) {
+    if (boundary != PLANE_BOUNDARY) {
+        return placeCell(x, y, shape.getEdge(), shape.getSizeX(),
+                         shape.getSizeY());
+    }
+    int edge = shape.getEdge();
+    return x >= edge && y >= edge &&
+           x < shape.getSizeX() + 2*(shape.getHide()+1) - edge &&
+           y < shape.getSizeY() + 2*(shape.getHide()+1) - edge;
+}
+
+// kill all cells and restart at time step zero
+void DomainEngine::clear() {
+    pending.clear();
+    run(CLEAR, 0, 0);
+    start = 0;
+    tick = 0;
+}
+
+// follow a rule; the kernels run only two-state rules
+bool DomainEngine::setRule(const Rule &r) {
+    Rule next = r;
+    std::string name = next.getName();
+    if (!shape.setRule(next) || name.size() >= sizeof(shared->rule)) {
+        return false;
+    }
+    flush();
+    strcpy(shared->rule, name.c_str());
+    run(RULE, 0, 0);
+    rule = next;
+    return true;
+}
+
+// choose the edges of the grid, killing any cells outside the visible
+// ones unless it is the plane
+bool DomainEngine::setBoundary(Boundary b) {
+    flush();
+    boundary = b;
+    shape.setBoundary(b);
+    run(BOUNDARY, b, 0);
+    return true;
+}
+
+// set a cell of the current time step; cells off the grid are ignored.
+// Cells are sent to the ranks in batches, before the next command.
+void DomainEngine::setCell(long long x, long long y, bool s) {
+    if (inside(x, y)) {
+        pending.push_back(x);
+        pending.push_back(y);
+        pending.push_back(s);
+        if (pending.size() >= transferWords / 3 * 3) {
+            flush();
+        }
+    }
+}
+
+// fill a rectangle with a soup, each rank filling the rows of its band,
+// when it lies within the stepped cells; one at a time, wrapping or
+// clipping as setCell does, when it does not
+void DomainEngine::loadSoup(const Soup &soup, long long x, long long y,
+                            long long w, long long h) {
+    int edge = shape.getEdge();
+    long long nx = shape.getSizeX() + 2*(shape.getHide()+1);
+    long long ny = shape.getSizeY() + 2*(shape.getHide()+1);
+    if (x < edge || y < edge || x + w > nx - edge || y + h > ny - edge) {
+        Engine::loadSoup(soup, x, y, w, h);
+        return;
+    }
+    ScopedTimer timer(SEED_TIMER);
+    flush();
+    shared->soup = soup;
+    shared->box[0] = static_cast<int>(x);
+    shared->box[1] = static_cast<int>(y);
+    shared->box[2] = static_cast<int>(w);
+    shared->box[3] = static_cast<int>(h);
+    run(SOUP, 0, 0);
+}
+
+// get a cell of the current time step; cells off the grid are dead
+bool DomainEngine::getCell(long long x, long long y) {
+    if (!inside(x, y)) {
+        return false;
+    }
+    flush();
+    const uint64_t *row = fetchRow(static_cast<int>(y));
+    return (row[x >> 6] >> (x & 63)) & 1;
+}
+
+// advance n time steps: all at once, or one at a time when tracing so
+// each generation is reported
+void DomainEngine::step(long long n) {
+    flush();
+    if (n <= 0) {
+        return;
+    }
+    if (!Trace::isEnabled()) {
+        run(STEP, n, 0);
+        tick += n;
+        return;
+    }
+    for (long long t = 0; t < n; t++) {
+        run(STEP, 1, 0);
+        tick++;
+        Trace::endGeneration(getGeneration());
+    }
+}
+
+// number of time steps run since the last clear
+long long DomainEngine::getGeneration() {
+    return start + tick;
+}
+
+// set the generation count, keeping the cells
+void DomainEngine::setGeneration(long long n) {
+    start = n - tick;
+}
+
+// number of live cells, the sum of the bands'
+long long DomainEngine::getPopulation() {
+    flush();
+    run(POPULATION, 0, 0);
+    long long n = 0;
+    for (int k = 0; k < ranks; k++) {
+        n += results[k].population;
+    }
+    return n;
+}
+
+// hash of the cells: the bands hash their tiles as the packed grid
+// does, so the hash is the XOR of theirs
+uint64_t DomainEngine::getHash() {
+    flush();
+    run(HASH, 0, 0);
+    uint64_t hash = 0;
+    for (int k = 0; k < ranks; k++) {
+        hash ^= results[k].hash;
+    }
+    return hash;
+}
+
+// the ranks update their hashes as they step
+bool DomainEngine::tracksHash() {
+    return true;
+}
+
+// statistics of the cells, the sum of the bands'
+CellStats DomainEngine::getStats() {
+    flush();
+    run(STATS, 0, 0);
+    CellStats stats;
+    stats.clear();
+    for (int k = 0; k < ranks; k++) {
+        stats.add(results[k].stats);
+    }
+    return stats;
+}
+
+// call a function with the coordinates of every live cell, reading
+// the rows from the ranks a transfer area at a time
+void DomainEngine::forEachCell(CellFunction fn, void *context) {
+    flush();
+    for (int j = 0; j < shape.getRows(); j++) {
+        const uint64_t *row = fetchRow(j);
+        for (int w = 0; w < stride; w++) {
+            for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+                fn(context, 64LL*w + __builtin_ctzll(bits), j);
+            }
+        }
+    }
+}
+
+// edge row of band k for time step parity p: its first row (side 0)
+// or its last (side 1)
+uint64_t *DomainEngine::edgeRow(int p, int k, int side) {
+    return edges + (static_cast<size_t>(p*ranks + k)*2 + side) * stride;
+}
+
+
+/*********************************************************************
+ ** Function: serve
+ ** Description: Body of a rank process: carry out commands on a band
+ **   of the grid until told to quit.
+ ** Parameters: Number of the rank, from the top.
+ ** Pre-Conditions: Runs in a process of its own, forked by the
+ **   constructor.
+ ** Post-Conditions: Each command's answer is in the rank's result, or
+ **   its rows in the transfer area, when this process and the ranks
+ **   next meet at the command barrier.
+ *********************************************************************/
+
+void DomainEngine::serve(int k) {
+    PackedGrid even(shape.getSizeX(), shape.getSizeY());
+    PackedGrid odd(shape.getSizeX(), shape.getSizeY());
+    even.setBand(k, ranks);
+    odd.setBand(k, ranks);
+    int t = 0;
+    for (;;) {
+        pthread_barrier_wait(&shared->command);
+        PackedGrid *now = t % 2 == 0 ? &even : &odd;
+        int first = now->getFirstRow(), last = now->getLastRow();
+        switch (shared->op) {
+            case QUIT:
+                return;
+            case CLEAR:
+                even.clearGrid();
+                odd.clearGrid();
+                t = 0;
+                break;
+            case RULE: {
+                Rule r;
+                r.parse(shared->rule);
+                even.setRule(r);
+                odd.setRule(r);
+                break;
+            }
+            case BOUNDARY:
+                even.setBoundary(static_cast<Boundary>(shared->first));
+                odd.setBoundary(static_cast<Boundary>(shared->first));
+                break;
+            case WRITE:
+                for (long long i = 0; i < shared->first; i++) {
+                    int x = static_cast<int>(transfer[3*i]);
+                    int y = static_cast<int>(transfer[3*i + 1]);
+                    if (y >= first && y <= last) {
+                        now->setState(x, y, transfer[3*i + 2] != 0);
+                    }
+                }
+                break;
+            case SOUP:
+                now->fillSoup(shared->soup, shared->box[0], shared->box[1],
+                              shared->box[2], shared->box[3]);
+                break;
+            case READ: {
+                // rows wrapped from the other end are not cells
+                int e = now->getEdge(), ny = now->getRows();
+                bool wrapped = now->getBoundary() != PLANE_BOUNDARY;
+                for (long long j = std::max<long long>(first, shared->first);
+                     j <= std::min<long long>(last, shared->last); j++) {
+                    uint64_t *out = transfer + (j - shared->first) * stride;
+                    const uint64_t *row = now->getRow(static_cast<int>(j));
+                    if (wrapped && (j < e || j > ny - 1 - e)) {
+                        std::fill(out, out + stride, uint64_t(0));
+                    } else {
+                        std::copy(row, row + stride, out);
+                    }
+                }
+                break;
+            }
+            case STEP:
+                for (long long n = 0; n < shared->first; n++) {
+                    PackedGrid *future = now == &even ? &odd : &even;
+                    stepBand(k, now, future, t % 2);
+                    now = future;
+                    t++;
+                }
+                break;
+            case POPULATION:
+                results[k].population = now->countLive();
+                break;
+            case HASH:
+                results[k].hash = now->getHash();
+                break;
+            case STATS:
+                results[k].stats = now->getStats();
+                break;
+        }
+        pthread_barrier_wait(&shared->command);
+    }
+}
+
+
+/*********************************************************************
+ ** Function: stepBand
+ ** Description: Advance a rank's band one time step.
+ ** Parameters: Number of the rank, its grids for this and the next
+ **   time step, and the parity of the time step.
+ ** Pre-Conditions: Every rank steps its band at the same time.
+ ** Post-Conditions: The band gives its first and last rows to its
+ **   neighbors, and on a torus or Klein bottle the top and bottom
+ **   visible rows to the bands that wrap them, then takes theirs as
+ **   the rows just outside it and steps.  The rows are copied into
+ **   both grids, so each is compared with the last time step's and
+ **   only the tiles next to changed cells are stepped.  The edge rows
+ **   alternate between two sets by parity, so a rank still reading
+ **   one time step's rows is never overwritten by a faster one.
+ *********************************************************************/
+
+void DomainEngine::stepBand(int k, PackedGrid *now, PackedGrid *future,
+                            int p) {
+    int first = now->getFirstRow(), last = now->getLastRow();
+    int y0 = now->getEdge(), y1 = now->getRows() - 1 - y0;
+    Boundary b = now->getBoundary();
+    bool wrap = ranks > 1 && (b == TORUS_BOUNDARY || b == KLEIN_BOUNDARY);
+    bool klein = b == KLEIN_BOUNDARY;
+    uint64_t *top = wraps + (2*p)*static_cast<size_t>(stride);
+    uint64_t *bottom = top + stride;
+
+    now->fillHalo();
+    std::copy(now->getRow(first), now->getRow(first) + stride,
+              edgeRow(p, k, 0));
+    std::copy(now->getRow(last), now->getRow(last) + stride,
+              edgeRow(p, k, 1));
+    if (wrap && y0 >= first && y0 <= last) {
+        std::copy(now->getRow(y0), now->getRow(y0) + stride, top);
+    }
+    if (wrap && y1 >= first && y1 <= last) {
+        std::copy(now->getRow(y1), now->getRow(y1) + stride, bottom);
+    }
+    pthread_barrier_wait(&shared->exchange);
+
+    PackedGrid *grids[2] = { now, future };
+    for (int g = 0; g < 2; g++) {
+        if (k > 0) {
+            grids[g]->copyRow(first - 1, edgeRow(p, k - 1, 1), false);
+        }
+        if (k < ranks - 1) {
+            grids[g]->copyRow(last + 1, edgeRow(p, k + 1, 0), false);
+        }
+        if (wrap && y0 - 1 >= first && y0 - 1 <= last) {
+            grids[g]->copyRow(y0 - 1, bottom, klein);
+        }
+        if (wrap && y1 + 1 >= first && y1 + 1 <= last) {
+            grids[g]->copyRow(y1 + 1, top, klein);
+        }
+    }
+    now->calcNext(*future);
+}
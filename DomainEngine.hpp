@@ -0,0 +1,96 @@
+/*********************************************************************
+ ** Program Filename: DomainEngine.hpp, DomainEngine class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Simulation engine that splits a bit-packed grid into
+ **   bands of rows, each stepped by a process of its own (a rank).
+ **   The ranks share one memory mapping with this process: it holds
+ **   the commands this process gives them, their answers, the cells
+ **   passed in and out, and the edge rows each rank gives its
+ **   neighbors before every time step, as the ghost rows of the
+ **   neighbors' bands.  Each rank maps the whole grid, so cells keep
+ **   their indices and hashes, but only ever touches its own band.
+ ** Input: grid dimensions, number of ranks, seed pattern, number of
+ **   generations
+ ** Output: cell states, generation count, population
+ *********************************************************************/
+
+#ifndef DomainEngine_hpp
+#define DomainEngine_hpp
+
+#include <vector>           // header file for vector objects
+#include <stdint.h>         // header file for fixed width integer types
+#include <sys/types.h>      // header file for process ids
+#include <pthread.h>        // header file for process shared barriers
+#include "Engine.hpp"
+#include "PackedGrid.hpp"
+#include "Soup.hpp"
+
+class DomainEngine : public Engine {
+public:
+    static const int TRANSFER = 1 << 20;    // words of cells passed at once
+private:
+    enum Command { QUIT, CLEAR, RULE, BOUNDARY, WRITE, SOUP, READ, STEP,
+                   POPULATION, HASH, STATS };
+    struct Shared {
+        pthread_barrier_t command;  // this process and the ranks
+        pthread_barrier_t exchange; // the ranks, between time steps
+        int op;                     // command given
+        long long first, last;      // its arguments
+        char rule[64];              // rule to follow
+        Soup soup;                  // soup to fill a rectangle with
+        int box[4];                 // the rectangle: x, y, width, height
+    };
+    struct Result {
+        long long population;       // live cells of the band
+        uint64_t hash;              // hash of the band
+        CellStats stats;            // statistics of the band
+    };
+    PackedGrid shape;               // layout of the grid, never stepped
+    int ranks;                      // processes stepping the grid
+    int stride;                     // words per row
+    size_t transferWords;           // words of the transfer area
+    std::vector<pid_t> children;    // process of each rank
+    void *mapping;                  // memory shared with the ranks
+    size_t mappedLength;            // bytes of the shared memory
+    Shared *shared;                 // commands
+    Result *results;                // answer of each rank
+    uint64_t *edges;                // first and last rows of each band
+    uint64_t *wraps;                // rows a torus or Klein bottle wraps
+    uint64_t *transfer;             // cells or rows passed in or out
+    long long start;                // generation of time step zero
+    long long tick;                 // current time step
+    std::vector<long long> pending; // cells to set: x, y and state
+    std::vector<uint64_t> rows;     // rows last read from the ranks
+    int rowsFirst, rowsLast;        // which rows those are
+    void run(Command, long long, long long); // give every rank a command
+    void flush();                   // send the cells waiting to be set
+    const uint64_t *fetchRow(int);  // words of a row, read if need be
+    bool inside(long long &, long long &); // true if a cell is on the grid
+    uint64_t *edgeRow(int, int, int); // edge row of a band and time step
+    void serve(int);                // body of a rank
+    void stepBand(int, PackedGrid *, PackedGrid *, int); // step a band
+    DomainEngine(const DomainEngine &);             // not copyable
+    DomainEngine &operator=(const DomainEngine &);  // not assignable
+public:
+    DomainEngine(int,int,int);      // constructor
+    ~DomainEngine();                // destructor
+    const char *getName();
+    void clear();
+    bool setRule(const Rule &);
+    bool setBoundary(Boundary);
+    void setCell(long long, long long, bool);
+    void loadSoup(const Soup &, long long, long long, long long, long long);
+    bool getCell(long long, long long);
+    void step(long long);
+    long long getGeneration();
+    void setGeneration(long long);
+    long long getPopulation();
+    void forEachCell(CellFunction, void *);
+    uint64_t getHash();
+    bool tracksHash();
+    CellStats getStats();
+    int getRanks();                 // get number of rank processes
+};
+
+#endif /* DomainEngine_hpp */
@@ -0,0 +1,383 @@
+/*********************************************************************
+ ** Program Filename: Engine.cpp, Engine class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Default implementations shared by the simulation
+ **   engines, written in terms of setCell and getCell.
+ ** Input: seed pattern, display window
+ ** Output: cell states
+ *********************************************************************/
+
+#include "Engine.hpp"
+#include "GridEngine.hpp"
+#include "PackedEngine.hpp"
+#include "HashLife.hpp"
+#include "Universe.hpp"
+#include "DomainEngine.hpp"
+#include "Snapshot.hpp"
+#include "Soup.hpp"
+#include "Kernel.hpp"
+#include "Trace.hpp"
+
+
+/*********************************************************************
+ ** Function: create
+ ** Description: Make a simulation engine.
+ ** Parameters: Engine choice, visible grid dimensions (used by the
+ **   bounded engines) and number of threads (used by the packed grid
+ **   and universe, and as the number of processes of the domain
+ **   engine).
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns a new engine, to be deleted by the caller.
+ *********************************************************************/
+
+Engine *Engine::create(Backend b, int ncol, int nrow, int nthreads) {
+    switch (b) {
+        case BOOL_BACKEND:
+            return new GridEngine(ncol, nrow);
+        case PACKED_BACKEND:
+            return new PackedEngine(ncol, nrow, nthreads);
+        case HASHLIFE_BACKEND:
+            return new HashLife();
+        case DOMAIN_BACKEND:
+            return new DomainEngine(ncol, nrow, nthreads);
+        default:
+            return new Universe(nthreads);
+    }
+}
+
+
+/*********************************************************************
+ ** Function: parseBackend
+ ** Description: Convert an engine name to an engine choice.
+ ** Parameters: Engine name and the choice to store the result in.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false if the name is not recognized.
+ *********************************************************************/
+
+bool Engine::parseBackend(const std::string &name, Backend &b) {
+    if (name == "bool") {
+        b = BOOL_BACKEND;
+    } else if (name == "packed") {
+        b = PACKED_BACKEND;
+    } else if (name == "hashlife") {
+        b = HASHLIFE_BACKEND;
+    } else if (name == "universe") {
+        b = UNIVERSE_BACKEND;
+    } else if (name == "domain") {
+        b = DOMAIN_BACKEND;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: parseBoundary
+ ** Description: Convert the name of a grid's edges to a choice.
+ ** Parameters: Name (plane, dead, torus or klein) and the choice to
+ **   store the result in.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false if the name is not recognized.
+ *********************************************************************/
+
+bool Engine::parseBoundary(const std::string &name, Boundary &b) {
+    if (name == "plane") {
+        b = PLANE_BOUNDARY;
+    } else if (name == "dead") {
+        b = DEAD_BOUNDARY;
+    } else if (name == "torus") {
+        b = TORUS_BOUNDARY;
+    } else if (name == "klein") {
+        b = KLEIN_BOUNDARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// name of a grid's edges, as parseBoundary reads it
+const char *Engine::boundaryName(Boundary b) {
+    switch (b) {
+    case DEAD_BOUNDARY:
+        return "dead";
+    case TORUS_BOUNDARY:
+        return "torus";
+    case KLEIN_BOUNDARY:
+        return "klein";
+    default:
+        return "plane";
+    }
+}
+
+
+/*********************************************************************
+ ** Function: isBounded
+ ** Description: Tell whether the engine simulates a finite grid.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns true unless the engine's universe grows
+ **   without limit.
+ *********************************************************************/
+
+bool Engine::isBounded() {
+    return true;
+}
+
+
+// get the rule the cells follow
+Rule Engine::getRule() {
+    return rule;
+}
+
+// choose the edges of a bounded grid; an unbounded universe is a plane
+// and has no others
+bool Engine::setBoundary(Boundary b) {
+    return b == PLANE_BOUNDARY;
+}
+
+// get the edges of the grid
+Boundary Engine::getBoundary() {
+    return boundary;
+}
+
+// choose how many generations to step per pass over the cells; only
+// an engine that can step several at once accepts more than one
+bool Engine::setBlock(int k) {
+    return k == 1;
+}
+
+
+/*********************************************************************
+ ** Function: placeCell
+ ** Description: Move cell coordinates onto the stepped cells of a
+ **   bounded grid that is not a plane.
+ ** Parameters: The x and y coordinates, the index of the first stepped
+ **   row and column, and the number of stepped columns and rows.
+ ** Pre-Conditions: The width and height are positive.
+ ** Post-Conditions: On a torus the coordinates are wrapped around; on
+ **   a Klein bottle each time around vertically also mirrors x.
+ **   Returns false if the cell is off a grid with dead edges.
+ *********************************************************************/
+
+bool Engine::placeCell(long long &x, long long &y, long long first,
+                       long long width, long long height) {
+    if (boundary == TORUS_BOUNDARY || boundary == KLEIN_BOUNDARY) {
+        long long turns = (y - first) >= 0 ? (y - first) / height
+                                           : -((first - y - 1) / height) - 1;
+        y -= turns * height;
+        if (boundary == KLEIN_BOUNDARY && (turns & 1)) {
+            x = 2*first + width - 1 - x;
+        }
+        x = first + ((x - first) % width + width) % width;
+    }
+    return x >= first && x < first + width && y >= first && y < first + height;
+}
+
+// set a cell to any state of the rule; engines without dying states
+// keep only whether it is live
+void Engine::setCellState(long long x, long long y, int state) {
+    setCell(x, y, state == 1);
+}
+
+
+/*********************************************************************
+ ** Function: loadSeed
+ ** Description: Apply a seed pattern centered at a location.
+ ** Parameters: A seed object and the x and y coordinates of the
+ **   pattern's origin.
+ ** Pre-Conditions: The seed must have read its coordinates.
+ ** Post-Conditions: The live (and any dying) cells of the pattern are
+ **   set.
+ *********************************************************************/
+
+void Engine::loadSeed(Seed &seed, long long x, long long y) {
+    ScopedTimer timer(SEED_TIMER);
+    for (int i = 0; i < seed.getLength(); i++) {
+        setCellState(x + seed.getX(i), y + seed.getY(i), seed.getState(i));
+    }
+}
+
+
+/*********************************************************************
+ ** Function: loadSoup
+ ** Description: Fill a rectangle with a random soup.
+ ** Parameters: The soup, the x and y coordinates of the rectangle's
+ **   top left cell, which is cell 0, 0 of the soup, and its width and
+ **   height.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Each cell of the rectangle is live if the soup's
+ **   cell is, and dead otherwise.  This version sets the cells one at
+ **   a time, only where they change; the grid engines override it to
+ **   write whole words of the soup into their grids.
+ *********************************************************************/
+
+void Engine::loadSoup(const Soup &soup, long long x, long long y,
+                      long long w, long long h) {
+    ScopedTimer timer(SEED_TIMER);
+    for (long long j = 0; j < h; j++) {
+        uint64_t row = soup.rowKey(j);
+        for (long long k = 0; 64*k < w; k++) {
+            uint64_t bits = soup.getWord(row, k);
+            for (long long i = 64*k; i < w && i < 64*k + 64; i++) {
+                bool s = (bits >> (i & 63)) & 1;
+                if (s || getCell(x + i, y + j)) {
+                    setCell(x + i, y + j, s);
+                }
+            }
+        }
+    }
+}
+
+
+/*********************************************************************
+ ** Function: exportWindow
+ ** Description: Copy a rectangle of cells into the visible portion of
+ **   a grid, for display.
+ ** Parameters: The grid to fill and the coordinates of the cell shown
+ **   in the top left corner of its visible portion.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The visible cells of the grid hold the engine's
+ **   cells; hidden cells of the grid are left alone.
+ *********************************************************************/
+
+void Engine::exportWindow(Grid &window, long long x0, long long y0) {
+    int h = window.getHide();
+    for (int j = 0; j < window.getSizeY(); j++) {
+        for (int i = 0; i < window.getSizeX(); i++) {
+            window.setState(h + 1 + i, h + 1 + j, getCell(x0 + i, y0 + j));
+        }
+    }
+}
+
+// add the hash of a live cell to a board hash
+static void addCellHash(void *context, long long x, long long y) {
+    *static_cast<uint64_t *>(context) ^=
+        hashCells<uint64_t>(static_cast<uint64_t>(x) * 0xD6E8FEB86659FD93ULL +
+                            static_cast<uint64_t>(y), 1);
+}
+
+
+/*********************************************************************
+ ** Function: getHash
+ ** Description: Hash the live cells, so a board that repeats an
+ **   earlier one can be recognized without keeping a copy of it.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns a hash of the positions of the live cells,
+ **   zero for an empty board.  This version visits every live cell;
+ **   engines that keep their hash up to date as they step override it.
+ *********************************************************************/
+
+uint64_t Engine::getHash() {
+    uint64_t hash = 0;
+    forEachCell(addCellHash, &hash);
+    return hash;
+}
+
+// true if the engine updates its hash as it steps, so getHash is
+// cheap enough to call every generation
+bool Engine::tracksHash() {
+    return false;
+}
+
+// add a live cell to a generation's statistics
+static void addCellStats(void *context, long long x, long long y) {
+    CellStats *stats = static_cast<CellStats *>(context);
+    stats->population++;
+    stats->addCell(x, y);
+}
+
+
+/*********************************************************************
+ ** Function: getStats
+ ** Description: Get the statistics of the current generation.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the population and the box around the
+ **   live cells.  This version visits every live cell and does not
+ **   know the births and deaths, which are -1; engines that gather
+ **   their statistics as they step override it.
+ *********************************************************************/
+
+CellStats Engine::getStats() {
+    CellStats stats;
+    stats.clear();
+    forEachCell(addCellStats, &stats);
+    stats.births = -1;
+    stats.deaths = -1;
+    return stats;
+}
+
+// add a live cell to a snapshot
+static void addSnapshotCell(void *context, long long x, long long y) {
+    static_cast<Snapshot *>(context)->addCell(x, y);
+}
+
+
+/*********************************************************************
+ ** Function: saveState
+ ** Description: Copy the live cells, generation and rule to a
+ **   snapshot, as 64 x 64 cell tiles.
+ ** Parameters: The snapshot.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The snapshot holds the current generation.
+ *********************************************************************/
+
+void Engine::saveState(Snapshot &snapshot) {
+    snapshot.setSparse(getGeneration());
+    snapshot.setRule(rule.getName());
+    forEachCell(addSnapshotCell, &snapshot);
+}
+
+
+/*********************************************************************
+ ** Function: loadState
+ ** Description: Replace the cells and generation with those of a
+ **   snapshot, setting one cell at a time.
+ ** Parameters: The snapshot, dense or sparse.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The engine holds the snapshot's generation; a
+ **   bounded engine drops cells outside its grid.  Returns false,
+ **   leaving the engine empty, if a dense snapshot's rows do not fit
+ **   its words.
+ *********************************************************************/
+
+bool Engine::loadState(Snapshot &snapshot) {
+    clear();
+    setGeneration(snapshot.getGeneration());
+    const uint64_t *words = snapshot.getWords();
+    size_t count = snapshot.getWordCount();
+    if (snapshot.getKind() == Snapshot::DENSE) {
+        // the grid's rows, after the padding words before them
+        size_t stride = snapshot.getStride();
+        size_t rows = snapshot.getRows();
+        if (snapshot.getStride() <= 0 || snapshot.getRows() < 0 ||
+            count < stride * rows || (count - stride * rows) % 2 != 0) {
+            return false;
+        }
+        size_t pad = (count - stride * rows) / 2;
+        for (size_t w = pad; w + pad < count; w++) {
+            for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+                long long j = (w - pad) / stride;
+                long long i = 64*((w - pad) % stride) + __builtin_ctzll(bits);
+                setCell(i, j, 1);
+            }
+        }
+    } else {
+        // tiles of their x and y tile numbers, then their rows
+        const int T = Snapshot::TILE;
+        for (size_t t = 0; t + 2 + T <= count; t += 2 + T) {
+            long long x0 = static_cast<long long>(words[t]) * T;
+            long long y0 = static_cast<long long>(words[t + 1]) * T;
+            for (int r = 0; r < T; r++) {
+                for (uint64_t bits = words[t + 2 + r]; bits != 0;
+                     bits &= bits - 1) {
+                    setCell(x0 + __builtin_ctzll(bits), y0 + r, 1);
+                }
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,74 @@
+/*********************************************************************
+ ** Program Filename: Engine.hpp, Engine class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Common interface of the Game of Life simulation
+ **   engines, so the game can step a bool grid, a bit-packed grid or
+ **   a HashLife quadtree the same way.  Cells are addressed with the
+ **   same (x, y) indices as Grid, hidden cells included.
+ ** Input: rule, seed pattern, cell states, number of generations to run
+ ** Output: cell states, generation count, population, display window
+ *********************************************************************/
+
+#ifndef Engine_hpp
+#define Engine_hpp
+
+#include <string>   // header file for string objects
+#include <stdint.h> // header file for fixed width integer types
+#include "Grid.hpp"
+#include "Seed.hpp"
+#include "Rule.hpp"
+
+// simulation engine choices
+enum Backend { BOOL_BACKEND, PACKED_BACKEND, HASHLIFE_BACKEND,
+               UNIVERSE_BACKEND, DOMAIN_BACKEND };
+
+class Snapshot;
+class Soup;
+
+// called with the coordinates of each live cell
+typedef void (*CellFunction)(void *context, long long x, long long y);
+
+class Engine {
+protected:
+    Rule rule;                                      // rule the cells follow
+    Boundary boundary;                              // edges of the grid
+    bool placeCell(long long &, long long &, long long, long long,
+                   long long);                      // wrap onto the grid
+public:
+    static Engine *create(Backend, int, int, int); // make an engine
+    static bool parseBackend(const std::string &, Backend &); // by name
+    static bool parseBoundary(const std::string &, Boundary &); // by name
+    static const char *boundaryName(Boundary);      // name of the edges
+    Engine() : boundary(PLANE_BOUNDARY) {}          // constructor
+    virtual ~Engine() {}                            // destructor
+    virtual const char *getName() = 0;              // name of the engine
+    virtual bool isBounded();                       // true if finite
+    virtual void clear() = 0;                       // kill all cells
+    virtual bool setRule(const Rule &) = 0;         // false if unsupported
+    Rule getRule();                                 // rule the cells follow
+    virtual bool setBoundary(Boundary);             // false if unsupported
+    Boundary getBoundary();                         // edges of the grid
+    virtual bool setBlock(int);                     // generations stepped
+                                                    // per pass over memory
+    virtual void setCell(long long, long long, bool) = 0; // set a cell
+    virtual void setCellState(long long, long long, int); // set any state
+    virtual bool getCell(long long, long long) = 0; // get a cell
+    virtual void step(long long) = 0;               // run n generations
+    virtual long long getGeneration() = 0;          // generations run
+    virtual void setGeneration(long long) = 0;      // set generation count
+    virtual long long getPopulation() = 0;          // number of live cells
+    virtual void loadSeed(Seed &, long long, long long); // apply a pattern
+    virtual void loadSoup(const Soup &, long long, long long, long long,
+                          long long);               // fill a rectangle
+    virtual void exportWindow(Grid &, long long, long long); // fill a grid
+    virtual void forEachCell(CellFunction, void *) = 0; // visit live cells
+    virtual uint64_t getHash();                     // hash of the cells
+    virtual bool tracksHash();                      // true if hash is cheap
+    virtual CellStats getStats();                   // population, births,
+                                                    // deaths and box
+    virtual void saveState(Snapshot &);             // copy cells out
+    virtual bool loadState(Snapshot &);             // replace the cells
+};
+
+#endif /* Engine_hpp */
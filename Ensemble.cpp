@@ -0,0 +1,689 @@
+/*********************************************************************
+ ** Program Filename: Ensemble.cpp, Ensemble class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Ensemble class implementation, runs a soup search:
+ **   many small random soups run until their boards repeat, with a
+ **   census of the objects they leave.
+ ** Input: engine, board size and edges, rule, soup size and fill,
+ **   random number seed, number of soups
+ ** Output: census of the objects left by the soups, lifetimes, soups
+ **   searched per hour
+ *********************************************************************/
+
+#include "Ensemble.hpp"
+#include "Soup.hpp"
+#include <iostream>     // header file for input and output stream objects
+#include <fstream>      // header file for file streams
+#include <algorithm>    // header file for sort
+#include <chrono>       // header file for clocks
+
+// soups run per batch of tasks given to the threads
+static const long long SOUPS_PER_BATCH = 1 << 16;
+
+// phases of a settled board merged to find its objects, enough for the
+// common oscillators; cells that come near each other in any of them
+// belong to the same object
+static const long long MERGED_PHASES = 16;
+
+// longest period looked for when an object is run on its own
+static const long long LONGEST_PERIOD = 4096;
+
+// digits of the extended Wechsler format, one per 5 cell column
+static const char DIGITS[] = "0123456789abcdefghijklmnopqrstuv";
+
+
+/*********************************************************************
+ ** Function:  Ensemble
+ ** Description:  Ensemble class constructor
+ ** Parameters: Engine to run the soups with, board dimensions and
+ **   number of threads, below 1 for one per hardware thread.
+ ** Pre-Conditions: none
+ ** Post-Conditions:  Each thread has a board of its own.  The soups are
+ **   16 x 16, half filled, from random number seed 1, and are given up
+ **   on after 100000 generations.
+ *********************************************************************/
+
+Ensemble::Ensemble(Backend b, int ncol, int nrow, int nthreads)
+    : pool(nthreads) {
+    width = ncol;
+    height = nrow;
+    origin = Grid(1, 1).getHide() + 1;
+    soupSize = 16;
+    density = 0.5;
+    rng = 1;
+    maxGens = 100000;
+    first = 0;
+    for (int i = 0; i < pool.getThreads(); i++) {
+        Worker *w = new Worker;
+        w->engine = Engine::create(b, ncol, nrow, 1);
+        w->cycles.setAction(CYCLE_STOP);
+        workers.push_back(w);
+    }
+}
+
+
+/*********************************************************************
+ ** Function:  ~Ensemble
+ ** Description:  Ensemble class destructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions:  The boards are deallocated.
+ *********************************************************************/
+
+Ensemble::~Ensemble() {
+    for (size_t i = 0; i < workers.size(); i++) {
+        delete workers[i]->engine;
+        delete workers[i];
+    }
+}
+
+// choose the rule; false if the engine cannot run it or it has dying
+// states, which the census does not count
+bool Ensemble::setRule(const Rule &r) {
+    rule = r;
+    if (rule.getStates() != 2) {
+        return false;
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        if (!workers[i]->engine->setRule(rule)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// choose the edges of the boards; false unless a torus or dead edges,
+// since objects must neither leave the board nor be mirrored
+bool Ensemble::setBoundary(Boundary b) {
+    if (b != TORUS_BOUNDARY && b != DEAD_BOUNDARY) {
+        return false;
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        if (!workers[i]->engine->setBoundary(b)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// choose the width and height of the soups, their fill and the random
+// number seed they are filled from
+void Ensemble::setSoup(int size, double fill, uint64_t seed) {
+    soupSize = size;
+    density = fill;
+    rng = seed;
+}
+
+// choose the generations a soup runs before it is given up on
+void Ensemble::setMaxGens(long long n) {
+    maxGens = n;
+}
+
+// run soup number first+task on the worker's board
+void Ensemble::runTask(void *context, int task, int worker) {
+    Ensemble *e = static_cast<Ensemble *>(context);
+    e->runSoup(*e->workers[worker], e->first + task);
+}
+
+
+/*********************************************************************
+ ** Function: runSoup
+ ** Description: Fill the middle of a board with a random soup and run
+ **   it until the board repeats.
+ ** Parameters: The worker whose board to use and the soup's number.
+ ** Pre-Conditions: The rule and boundary have been set.
+ ** Post-Conditions: The soup's lifetime, and the objects it left if it
+ **   settled without dying out, are added to the worker's census.
+ *********************************************************************/
+
+void Ensemble::runSoup(Worker &w, long long soup) {
+    Engine *engine = w.engine;
+    engine->clear();
+
+    // each soup is its own stream of the seed's random numbers
+    int size = std::min(soupSize, std::min(width, height));
+    long long x0 = origin + (width - size) / 2;
+    long long y0 = origin + (height - size) / 2;
+    engine->loadSoup(Soup(rng, density, soup), x0, y0, size, size);
+
+    w.cycles.clear();
+    w.cycles.advance(*engine, maxGens);
+    Census &c = w.census;
+    c.soups++;
+    if (!w.cycles.isFound()) {
+        c.unsettled++;
+        return;
+    }
+    long long onset = w.cycles.getOnset();
+    c.lifetime += onset;
+    c.longest = std::max(c.longest, onset);
+    size_t bucket = 0;
+    while ((2LL << bucket) <= onset) {
+        bucket++;
+    }
+    if (c.lifetimes.size() <= bucket) {
+        c.lifetimes.resize(bucket + 1, 0);
+    }
+    c.lifetimes[bucket]++;
+    if (engine->getPopulation() == 0) {
+        c.extinct++;
+        return;
+    }
+    takeCensus(w, w.cycles.getPeriod());
+}
+
+// board being copied and the mark its live cells get
+struct BoardReader {
+    char *live;         // a byte per cell of the board
+    long long origin;   // engine coordinates of the board's corner
+    int width;          // board width
+    char mark;          // bits to set for a live cell
+};
+
+// mark a live cell of the board being copied
+static void markCell(void *context, long long x, long long y) {
+    BoardReader *r = static_cast<BoardReader *>(context);
+    r->live[(y - r->origin) * r->width + (x - r->origin)] |= r->mark;
+}
+
+// copy the live cells of the worker's board: the first phase of a
+// settled board is marked 3, later ones add 2
+void Ensemble::readBoard(Worker &w, bool firstPhase) {
+    if (firstPhase) {
+        w.live.assign(static_cast<size_t>(width) * height, 0);
+    }
+    BoardReader r;
+    r.live = &w.live[0];
+    r.origin = origin;
+    r.width = width;
+    r.mark = firstPhase ? 3 : 2;
+    w.engine->forEachCell(markCell, &r);
+}
+
+
+/*********************************************************************
+ ** Function: takeCensus
+ ** Description: Split a settled board into objects and count them.
+ ** Parameters: The worker whose board it is and the board's period.
+ ** Pre-Conditions: The board has just repeated.
+ ** Post-Conditions: Cells within two of each other in any of the
+ **   first phases of the board, close enough to share a neighbor, are
+ **   gathered into a group.  A group whose touching parts each repeat
+ **   on their own, and step together as they do apart, is counted as
+ **   those parts (two blocks side by side are two blocks); otherwise
+ **   it is counted as one object (the four parts of a pulsar).  The
+ **   board is left stepped on.
+ *********************************************************************/
+
+void Ensemble::takeCensus(Worker &w, long long period) {
+    readBoard(w, true);
+    long long phases = std::min(period, MERGED_PHASES);
+    for (long long t = 1; t < phases; t++) {
+        w.engine->step(1);
+        readBoard(w, false);
+    }
+    bool wrap = w.engine->getBoundary() == TORUS_BOUNDARY;
+    w.seen.assign(w.live.size(), 0);
+
+    // gather each group, following it around the edges of a torus with
+    // coordinates that keep going
+    std::vector<Cell> queue, whole;
+    std::vector<std::vector<Cell> > parts, objects;
+    std::vector<std::string> names;
+    for (size_t k = 0; k < w.live.size(); k++) {
+        if (!(w.live[k] & 2) || w.seen[k]) {
+            continue;
+        }
+        Cell start = { static_cast<long long>(k % width),
+                       static_cast<long long>(k / width) };
+        w.seen[k] = 1;
+        queue.assign(1, start);
+        for (size_t q = 0; q < queue.size(); q++) {
+            Cell c = queue[q];
+            long long i = ((c.x % width) + width) % width;
+            long long j = ((c.y % height) + height) % height;
+            for (int dy = -2; dy <= 2; dy++) {
+                for (int dx = -2; dx <= 2; dx++) {
+                    long long ni = i + dx, nj = j + dy;
+                    if (wrap) {
+                        ni = (ni + width) % width;
+                        nj = (nj + height) % height;
+                    } else if (ni < 0 || ni >= width || nj < 0 ||
+                               nj >= height) {
+                        continue;
+                    }
+                    size_t n = static_cast<size_t>(nj*width + ni);
+                    if ((w.live[n] & 2) && !w.seen[n]) {
+                        w.seen[n] = 1;
+                        Cell next = { c.x + dx, c.y + dy };
+                        queue.push_back(next);
+                    }
+                }
+            }
+        }
+
+        // the group's touching parts, with only their first phase's cells
+        split(queue, parts);
+        objects.clear();
+        whole.clear();
+        for (size_t p = 0; p < parts.size(); p++) {
+            std::vector<Cell> cells;
+            for (size_t q = 0; q < parts[p].size(); q++) {
+                Cell c = parts[p][q];
+                long long i = ((c.x % width) + width) % width;
+                long long j = ((c.y % height) + height) % height;
+                if (w.live[j*width + i] & 1) {
+                    cells.push_back(c);
+                }
+            }
+            if (!cells.empty()) {
+                objects.push_back(cells);
+                whole.insert(whole.end(), cells.begin(), cells.end());
+            }
+        }
+        if (objects.empty()) {
+            continue;
+        }
+        names.clear();
+        bool apart = objects.size() > 1;
+        for (size_t p = 0; p < objects.size() && apart; p++) {
+            names.push_back(classify(objects[p], period));
+            apart = names.back().compare(0, 2, "zz") != 0;
+        }
+        if (apart && stepsApart(objects, whole, phases)) {
+            for (size_t p = 0; p < names.size(); p++) {
+                w.census.objects[names[p]]++;
+            }
+        } else {
+            w.census.objects[classify(whole, period)]++;
+        }
+    }
+}
+
+
+/*********************************************************************
+ ** Function: split
+ ** Description: Split cells into parts that touch, side or corner.
+ ** Parameters: The cells and the list to put the parts in.
+ ** Pre-Conditions: There is at least one cell.
+ ** Post-Conditions: Each cell is in exactly one part.
+ *********************************************************************/
+
+void Ensemble::split(const std::vector<Cell> &cells,
+                     std::vector<std::vector<Cell> > &parts) {
+    Cell low = cells[0], high = cells[0];
+    for (size_t k = 1; k < cells.size(); k++) {
+        low.x = std::min(low.x, cells[k].x);
+        low.y = std::min(low.y, cells[k].y);
+        high.x = std::max(high.x, cells[k].x);
+        high.y = std::max(high.y, cells[k].y);
+    }
+
+    // part each cell is in plus 1, 0 for none yet, with a dead margin
+    long long w = high.x - low.x + 3, h = high.y - low.y + 3;
+    std::vector<int> part(static_cast<size_t>(w * h), -1);
+    for (size_t k = 0; k < cells.size(); k++) {
+        part[(cells[k].y - low.y + 1) * w + (cells[k].x - low.x + 1)] = 0;
+    }
+    parts.clear();
+    for (size_t k = 0; k < cells.size(); k++) {
+        long long at = (cells[k].y - low.y + 1) * w + (cells[k].x - low.x + 1);
+        if (part[at] != 0) {
+            continue;
+        }
+        int n = static_cast<int>(parts.size()) + 1;
+        part[at] = n;
+        parts.push_back(std::vector<Cell>(1, cells[k]));
+        std::vector<Cell> &found = parts.back();
+        for (size_t q = 0; q < found.size(); q++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    Cell c = { found[q].x + dx, found[q].y + dy };
+                    long long i = (c.y - low.y + 1) * w + (c.x - low.x + 1);
+                    if (part[i] == 0) {
+                        part[i] = n;
+                        found.push_back(c);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// true if objects stepped on their own end up, together, where they
+// do when stepped as one pattern, for a number of generations
+bool Ensemble::stepsApart(std::vector<std::vector<Cell> > objects,
+                          std::vector<Cell> whole, long long phases) {
+    for (long long t = 0; t < phases; t++) {
+        whole = stepCells(whole);
+        std::vector<Cell> apart;
+        for (size_t p = 0; p < objects.size(); p++) {
+            objects[p] = stepCells(objects[p]);
+            if (objects[p].empty()) {
+                return false;
+            }
+            apart.insert(apart.end(), objects[p].begin(), objects[p].end());
+        }
+        std::sort(whole.begin(), whole.end(), before);
+        std::sort(apart.begin(), apart.end(), before);
+        if (apart.size() != whole.size() || whole.empty() ||
+            !std::equal(apart.begin(), apart.end(), whole.begin(), same)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// true if a cell comes before another, row by row
+bool Ensemble::before(const Cell &a, const Cell &b) {
+    return a.y < b.y || (a.y == b.y && a.x < b.x);
+}
+
+// true if two cells are the same
+bool Ensemble::same(const Cell &a, const Cell &b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+// move cells so the corner of the smallest rectangle holding them is
+// at 0, 0 and sort them row by row; returns where the corner was
+Ensemble::Cell Ensemble::normalize(std::vector<Cell> &cells) {
+    Cell corner = cells[0];
+    for (size_t k = 1; k < cells.size(); k++) {
+        corner.x = std::min(corner.x, cells[k].x);
+        corner.y = std::min(corner.y, cells[k].y);
+    }
+    for (size_t k = 0; k < cells.size(); k++) {
+        cells[k].x -= corner.x;
+        cells[k].y -= corner.y;
+    }
+    std::sort(cells.begin(), cells.end(), before);
+    return corner;
+}
+
+
+/*********************************************************************
+ ** Function: stepCells
+ ** Description: Step an object on its own, on an empty plane.
+ ** Parameters: Its live cells.
+ ** Pre-Conditions: There is at least one cell.
+ ** Post-Conditions: Returns the live cells one generation later, row
+ **   by row.
+ *********************************************************************/
+
+std::vector<Ensemble::Cell> Ensemble::stepCells(const std::vector<Cell> &cells) {
+    Cell low = cells[0], high = cells[0];
+    for (size_t k = 1; k < cells.size(); k++) {
+        low.x = std::min(low.x, cells[k].x);
+        low.y = std::min(low.y, cells[k].y);
+        high.x = std::max(high.x, cells[k].x);
+        high.y = std::max(high.y, cells[k].y);
+    }
+
+    // a margin of two dead cells around the object: one for cells
+    // that may be born, one so every neighbor can be read
+    long long w = high.x - low.x + 5, h = high.y - low.y + 5;
+    std::vector<char> grid(static_cast<size_t>(w * h), 0);
+    for (size_t k = 0; k < cells.size(); k++) {
+        grid[(cells[k].y - low.y + 2) * w + (cells[k].x - low.x + 2)] = 1;
+    }
+    Neighborhood n = rule.getNeighborhood();
+    std::vector<Cell> next;
+    for (long long j = 1; j < h - 1; j++) {
+        for (long long i = 1; i < w - 1; i++) {
+            const char *c = &grid[j*w + i];
+            int count = c[-1] + c[1] + c[-w] + c[w];
+            if (n != VON_NEUMANN) {
+                count += c[-w-1] + c[w+1];
+            }
+            if (n == MOORE) {
+                count += c[-w+1] + c[w-1];
+            }
+            if (rule.next(*c, count) == 1) {
+                Cell live = { i - 2 + low.x, j - 2 + low.y };
+                next.push_back(live);
+            }
+        }
+    }
+    return next;
+}
+
+
+/*********************************************************************
+ ** Function: encode
+ ** Description: Write an object's cells in the extended Wechsler
+ **   format.
+ ** Parameters: Its live cells, moved to 0, 0 by normalize.
+ ** Pre-Conditions: There is at least one cell.
+ ** Post-Conditions: Returns the rows in strips of five, each strip
+ **   a digit per column (bit r for a live cell in its row r), strips
+ **   separated by z.  Runs of zero digits are shortened: w for two,
+ **   x for three, y and a digit for four or more; zeros at the end of
+ **   a strip are left out.
+ *********************************************************************/
+
+std::string Ensemble::encode(const std::vector<Cell> &cells) {
+    long long w = 0, h = 0;
+    for (size_t k = 0; k < cells.size(); k++) {
+        w = std::max(w, cells[k].x + 1);
+        h = std::max(h, cells[k].y + 1);
+    }
+    long long strips = (h + 4) / 5;
+    std::vector<int> columns(static_cast<size_t>(w * strips), 0);
+    for (size_t k = 0; k < cells.size(); k++) {
+        columns[(cells[k].y / 5) * w + cells[k].x] |= 1 << (cells[k].y % 5);
+    }
+    std::string code;
+    for (long long s = 0; s < strips; s++) {
+        if (s > 0) {
+            code += 'z';
+        }
+        long long zeros = 0;
+        for (long long i = 0; i < w; i++) {
+            int v = columns[s*w + i];
+            if (v == 0) {
+                zeros++;
+                continue;
+            }
+            for (; zeros > 0; zeros -= std::min(zeros, 35LL)) {
+                if (zeros == 1) {
+                    code += '0';
+                } else if (zeros == 2) {
+                    code += 'w';
+                } else if (zeros == 3) {
+                    code += 'x';
+                } else {
+                    code += 'y';
+                    code += DIGITS[std::min(zeros, 35LL) - 4];
+                }
+            }
+            code += DIGITS[v];
+        }
+    }
+    return code;
+}
+
+
+/*********************************************************************
+ ** Function: classify
+ ** Description: Name an object found on a settled board.
+ ** Parameters: Its live cells and the board's period.
+ ** Pre-Conditions: There is at least one cell.
+ ** Post-Conditions: The object is run on its own until it repeats,
+ **   perhaps moved, within the board's period.  Returns xs and its
+ **   number of cells for a still life, xp and its period for an
+ **   oscillator, xq and its period for a spaceship, or zz for an
+ **   object that does not repeat on its own, then _ and the shortest
+ **   (then first in order) Wechsler code of any of its phases turned
+ **   or reflected any way that keeps the neighborhood the same.
+ *********************************************************************/
+
+std::string Ensemble::classify(const std::vector<Cell> &object,
+                               long long period) {
+    std::vector<std::vector<Cell> > phases(1, object);
+    std::vector<Cell> cells(object);
+    Cell corner = normalize(cells);
+    long long limit = std::min(period, LONGEST_PERIOD);
+    long long found = 0;
+    bool moved = false;
+    std::vector<Cell> now = phases[0];
+    for (long long t = 1; t <= limit && found == 0; t++) {
+        now = stepCells(now);
+        if (now.empty() || now.size() > 4*cells.size() + 64) {
+            break;
+        }
+        std::vector<Cell> shape = now;
+        Cell at = normalize(shape);
+        if (shape.size() == cells.size() &&
+            std::equal(shape.begin(), shape.end(), cells.begin(), same)) {
+            found = t;
+            moved = at.x != corner.x || at.y != corner.y;
+        } else {
+            phases.push_back(now);
+        }
+    }
+
+    // x' = a x + b y, y' = c x + d y; a hexagonal neighborhood keeps
+    // only the first four
+    static const int turns[8][4] = {
+        { 1, 0, 0, 1 }, { -1, 0, 0, -1 }, { 0, 1, 1, 0 }, { 0, -1, -1, 0 },
+        { -1, 0, 0, 1 }, { 1, 0, 0, -1 }, { 0, -1, 1, 0 }, { 0, 1, -1, 0 }
+    };
+    int nturns = rule.getNeighborhood() == HEXAGONAL ? 4 : 8;
+    std::string best;
+    for (size_t p = 0; p < (found > 0 ? phases.size() : 1); p++) {
+        for (int t = 0; t < nturns; t++) {
+            std::vector<Cell> turned(phases[p]);
+            for (size_t k = 0; k < turned.size(); k++) {
+                Cell c = phases[p][k];
+                turned[k].x = turns[t][0]*c.x + turns[t][1]*c.y;
+                turned[k].y = turns[t][2]*c.x + turns[t][3]*c.y;
+            }
+            normalize(turned);
+            std::string code = encode(turned);
+            if (best.empty() || code.size() < best.size() ||
+                (code.size() == best.size() && code < best)) {
+                best = code;
+            }
+        }
+    }
+    if (found == 0) {
+        return "zz_" + best;
+    }
+    if (found == 1) {
+        return "xs" + std::to_string(cells.size()) + "_" + best;
+    }
+    return (moved ? "xq" : "xp") + std::to_string(found) + "_" + best;
+}
+
+
+/*********************************************************************
+ ** Function: run
+ ** Description: Run a number of soups on all threads and report what
+ **   they left.
+ ** Parameters: Number of soups and a file to write the census to as
+ **   comma separated values (none if empty).
+ ** Pre-Conditions: The rule and boundary have been set.
+ ** Post-Conditions: A summary is printed to standard output: soups
+ **   run, how many settled, died out or were given up on, their
+ **   lifetimes, the time taken and the census, most common objects
+ **   first.  Returns the program exit status: 0 on success, 1 if the
+ **   census could not be written.
+ *********************************************************************/
+
+int Ensemble::run(long long nsoups, std::string outFile) {
+    for (size_t i = 0; i < workers.size(); i++) {
+        Census &c = workers[i]->census;
+        c.objects.clear();
+        c.lifetimes.clear();
+        c.soups = c.unsettled = c.extinct = c.lifetime = c.longest = 0;
+    }
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (first = 0; first < nsoups; first += SOUPS_PER_BATCH) {
+        long long n = std::min(SOUPS_PER_BATCH, nsoups - first);
+        pool.run(static_cast<int>(n), runTask, this);
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    // add up the workers' censuses
+    Census total = workers[0]->census;
+    for (size_t i = 1; i < workers.size(); i++) {
+        Census &c = workers[i]->census;
+        std::map<std::string, long long>::iterator it;
+        for (it = c.objects.begin(); it != c.objects.end(); ++it) {
+            total.objects[it->first] += it->second;
+        }
+        if (total.lifetimes.size() < c.lifetimes.size()) {
+            total.lifetimes.resize(c.lifetimes.size(), 0);
+        }
+        for (size_t k = 0; k < c.lifetimes.size(); k++) {
+            total.lifetimes[k] += c.lifetimes[k];
+        }
+        total.soups += c.soups;
+        total.unsettled += c.unsettled;
+        total.extinct += c.extinct;
+        total.lifetime += c.lifetime;
+        total.longest = std::max(total.longest, c.longest);
+    }
+    long long settled = total.soups - total.unsettled;
+
+    Engine *engine = workers[0]->engine;
+    std::cout << "engine: " << engine->getName() << std::endl;
+    std::cout << "rule: " << rule.getName() << std::endl;
+    std::cout << "boundary: " << Engine::boundaryName(engine->getBoundary());
+    std::cout << std::endl;
+    std::cout << "board: " << width << " x " << height << std::endl;
+    std::cout << "soups: " << total.soups << " (" << soupSize << " x ";
+    std::cout << soupSize << ", density " << density << ", rng " << rng;
+    std::cout << ")" << std::endl;
+    std::cout << "threads: " << workers.size() << std::endl;
+    std::cout << "settled: " << settled << std::endl;
+    std::cout << "extinct: " << total.extinct << std::endl;
+    std::cout << "unsettled after " << maxGens << " generations: ";
+    std::cout << total.unsettled << std::endl;
+    if (settled > 0) {
+        std::cout << "lifetime mean: ";
+        std::cout << static_cast<double>(total.lifetime) / settled;
+        std::cout << std::endl;
+        std::cout << "lifetime max: " << total.longest << std::endl;
+        std::cout << "lifetimes:" << std::endl;
+        for (size_t k = 0; k < total.lifetimes.size(); k++) {
+            std::cout << "    " << (k == 0 ? 0 : 1LL << k) << "-";
+            std::cout << (2LL << k) - 1 << " " << total.lifetimes[k];
+            std::cout << std::endl;
+        }
+    }
+    std::cout << "seconds: " << seconds << std::endl;
+    if (seconds > 0) {
+        std::cout << "soups/hour: " << total.soups * 3600 / seconds;
+        std::cout << std::endl;
+    }
+
+    // most common objects first
+    std::vector<std::pair<long long, std::string> > counts;
+    std::map<std::string, long long>::iterator it;
+    for (it = total.objects.begin(); it != total.objects.end(); ++it) {
+        counts.push_back(std::make_pair(-it->second, it->first));
+    }
+    std::sort(counts.begin(), counts.end());
+    std::cout << "census:" << std::endl;
+    for (size_t k = 0; k < counts.size(); k++) {
+        std::cout << "    " << counts[k].second << " " << -counts[k].first;
+        std::cout << std::endl;
+    }
+
+    if (!outFile.empty()) {
+        std::ofstream out(outFile.c_str());
+        out << "object,count" << std::endl;
+        for (size_t k = 0; k < counts.size(); k++) {
+            out << counts[k].second << "," << -counts[k].first << std::endl;
+        }
+        if (!out) {
+            std::cerr << "Could not write " << outFile << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
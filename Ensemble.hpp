@@ -0,0 +1,91 @@
+/*********************************************************************
+ ** Program Filename: Ensemble.hpp, Ensemble class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Ensemble class specification, runs a soup search:
+ **   many small random soups, each on its own bounded board, run until
+ **   the board repeats.  Each worker thread keeps one board and steps
+ **   its soups one after another, so the threads never wait on each
+ **   other.  Soup n is stream n of the random number seed's Soup, so a
+ **   search gives the same results on any number of threads.  A settled board is split into objects,
+ **   which are named in the extended Wechsler format (xs4_33 for a
+ **   block, xp2_7 for a blinker, xq4_153 for a glider) and counted in
+ **   a census, along with how long the soups lived.
+ ** Input: engine, board size and edges, rule, soup size and fill,
+ **   random number seed, number of soups
+ ** Output: census of the objects left by the soups, lifetimes, soups
+ **   searched per hour
+ *********************************************************************/
+
+#ifndef Ensemble_hpp
+#define Ensemble_hpp
+
+#include <stdint.h>         // header file for fixed width integer types
+#include <string>           // header file for string objects
+#include <vector>           // header file for vector objects
+#include <map>              // header file for ordered maps
+#include "Engine.hpp"
+#include "ThreadPool.hpp"
+#include "CycleDetector.hpp"
+
+class Ensemble {
+private:
+    struct Cell {
+        long long x, y;     // x and y coordinates
+    };
+    struct Census {
+        std::map<std::string, long long> objects; // count of each object
+        std::vector<long long> lifetimes;   // soups settling in each
+                                            // power of two generations
+        long long soups;        // soups run
+        long long unsettled;    // soups still changing at the limit
+        long long extinct;      // soups that died out
+        long long lifetime;     // generations before settling, summed
+        long long longest;      // most generations before settling
+    };
+    struct Worker {
+        Engine *engine;         // board the worker's soups run on
+        CycleDetector cycles;   // watches a soup for a repeating board
+        Census census;          // results of the worker's soups
+        std::vector<char> live; // cells of a settled board
+        std::vector<char> seen; // cells already put in an object
+    };
+    std::vector<Worker *> workers;  // one per thread
+    ThreadPool pool;        // threads running the soups
+    Rule rule;              // rule the soups follow
+    int width, height;      // board dimensions
+    long long origin;       // engine coordinates of the board's corner
+    int soupSize;           // width and height of a soup
+    double density;         // fill of a soup
+    uint64_t rng;           // random number seed
+    long long maxGens;      // generations before a soup is given up on
+    long long first;        // number of the first soup of a batch
+    static bool before(const Cell &, const Cell &); // order cells by row
+    static bool same(const Cell &, const Cell &);   // true if equal
+    static Cell normalize(std::vector<Cell> &);     // move to 0, 0 and sort
+    static void runTask(void *, int, int);  // run one soup of a batch
+    void runSoup(Worker &, long long);      // run a soup, count results
+    void takeCensus(Worker &, long long);   // count a settled board's
+                                            // objects
+    void readBoard(Worker &, bool);         // copy the cells of a board
+    static void split(const std::vector<Cell> &,
+                      std::vector<std::vector<Cell> > &); // touching parts
+    bool stepsApart(std::vector<std::vector<Cell> >, std::vector<Cell>,
+                    long long);             // true if objects don't interact
+    std::string classify(const std::vector<Cell> &, long long); // name it
+    std::vector<Cell> stepCells(const std::vector<Cell> &); // step object
+    std::string encode(const std::vector<Cell> &);  // Wechsler code
+    Ensemble(const Ensemble &);             // not copyable
+    Ensemble &operator=(const Ensemble &);  // not assignable
+public:
+    Ensemble(Backend, int, int, int);   // constructor
+    ~Ensemble();                        // destructor
+    bool setRule(const Rule &);         // choose the rule, false if it
+                                        // cannot be run or counted
+    bool setBoundary(Boundary);         // choose the edges of the boards
+    void setSoup(int, double, uint64_t);    // choose the soups
+    void setMaxGens(long long);         // choose when to give up
+    int run(long long, std::string);    // search soups, print census
+};
+
+#endif /* Ensemble_hpp */
@@ -0,0 +1,670 @@
+/*********************************************************************
+ ** Program Filename: Exporter.cpp, Exporter class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Exporter class implementation, writes pictures of a
+ **   simulation as it runs, encoded on a background thread.  PNG files
+ **   are compressed with fixed Huffman codes and GIF files with LZW, so
+ **   no library is needed.
+ ** Input: engine, region of the board, cells per pixel, pixels per
+ **   cell, frame delay
+ ** Output: PGM, PNG or GIF files
+ *********************************************************************/
+
+#include "Exporter.hpp"
+#include "Trace.hpp"
+#include <cstdio>   // header file for snprintf
+#include <cstring>  // header file for memcpy
+#include <algorithm> // header file for min and max
+
+// first length and number of extra bits of each deflate length code
+static const int LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51,
+    59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const int LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4,
+    4, 5, 5, 5, 5, 0
+};
+
+// first distance and number of extra bits of each deflate distance code
+static const int DISTANCE_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+    513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const int DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10,
+    10, 11, 11, 12, 12, 13, 13
+};
+
+static const int WINDOW = 32768;        // farthest deflate match
+static const int MAX_MATCH = 258;       // longest deflate match
+static const int HASH_BITS = 15;        // bits of the match hash
+static const int GIF_CLEAR = 256;       // LZW code that resets the table
+static const int GIF_END = 257;         // LZW code that ends the data
+static const int GIF_CODES = 4095;      // LZW codes before a reset
+static const int GIF_TABLE = 8192;      // slots of the LZW hash table
+
+// big endian and little endian numbers appended to bytes
+static void putBig(std::vector<unsigned char> &b, uint32_t v) {
+    b.push_back(v >> 24);
+    b.push_back(v >> 16);
+    b.push_back(v >> 8);
+    b.push_back(v);
+}
+static void putLittle(std::vector<unsigned char> &b, int v) {
+    b.push_back(v & 0xFF);
+    b.push_back((v >> 8) & 0xFF);
+}
+
+
+/*********************************************************************
+ ** Function:  Exporter
+ ** Description:  Exporter class constructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions:  Nothing is exported until open is called.
+ *********************************************************************/
+
+Exporter::Exporter() {
+    format = PGM_FORMAT;
+    x0 = y0 = 0;
+    width = height = 0;
+    scale = zoom = 1;
+    delay = 10;
+    pixelsX = pixelsY = 0;
+    frames = 0;
+    stop = false;
+    failed = false;
+    bits = 0;
+    bitCount = 0;
+    for (int q = 0; q < QUEUE; q++) {
+        spare.push_back(q);
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crcTable[n] = c;
+    }
+}
+
+
+/*********************************************************************
+ ** Function:  ~Exporter
+ ** Description:  Exporter class destructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions:  The frames captured are encoded and the encoder
+ **   thread is stopped.
+ *********************************************************************/
+
+Exporter::~Exporter() {
+    finish();
+}
+
+
+/*********************************************************************
+ ** Function: open
+ ** Description: Start exporting pictures of a region of the board.
+ ** Parameters: File, whose extension (.pgm, .png or .gif) chooses the
+ **   format; engine coordinates of the region's top left cell, its
+ **   width and height in cells; cells per side of a pixel, pixels per
+ **   side of a pixel and, for a GIF, hundredths of a second per frame.
+ **   PGM and PNG frames go to files named after the file with the
+ **   generation added, e.g. life-00000100.png.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false, with the reason in getError, if the
+ **   format is unknown, the picture too large or a GIF could not be
+ **   created.
+ *********************************************************************/
+
+bool Exporter::open(const std::string &file, long long x, long long y,
+                    int ncol, int nrow, int cells, int pixels, int cs) {
+    finish();
+    error.clear();
+    failed = false;
+    frames = 0;
+    size_t dot = file.rfind('.');
+    std::string extension = dot == std::string::npos ? "" : file.substr(dot);
+    if (extension == ".pgm") {
+        format = PGM_FORMAT;
+    } else if (extension == ".png") {
+        format = PNG_FORMAT;
+    } else if (extension == ".gif") {
+        format = GIF_FORMAT;
+    } else {
+        error = file + ": export files must end in .pgm, .png or .gif";
+        return false;
+    }
+    if (ncol < 1 || nrow < 1 || cells < 1 || pixels < 1) {
+        error = "Export sizes must be positive";
+        return false;
+    }
+    long long px = (static_cast<long long>(ncol) + cells - 1) / cells * pixels;
+    long long py = (static_cast<long long>(nrow) + cells - 1) / cells * pixels;
+    if (px > 65535 || py > 65535 || px * py > (1LL << 30)) {
+        error = "Export pictures are too large; give more cells per pixel";
+        return false;
+    }
+    fileName = file;
+    x0 = x;
+    y0 = y;
+    width = ncol;
+    height = nrow;
+    scale = cells;
+    zoom = pixels;
+    delay = cs;
+    pixelsX = static_cast<int>(px);
+    pixelsY = static_cast<int>(py);
+
+    // an animated GIF holds every frame, with a gray palette, and
+    // loops forever
+    if (format == GIF_FORMAT) {
+        gif.open(fileName.c_str(), std::ios::binary);
+        if (!gif) {
+            error = "Could not create " + fileName;
+            return false;
+        }
+        out.clear();
+        out.insert(out.end(), "GIF89a", "GIF89a" + 6);
+        putLittle(out, pixelsX);
+        putLittle(out, pixelsY);
+        out.push_back(0xF7);
+        out.push_back(0);
+        out.push_back(0);
+        for (int g = 0; g < 256; g++) {
+            out.insert(out.end(), 3, static_cast<unsigned char>(g));
+        }
+        static const unsigned char LOOP[19] = {
+            0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2',
+            '.', '0', 0x03, 0x01, 0x00, 0x00, 0x00
+        };
+        out.insert(out.end(), LOOP, LOOP + sizeof(LOOP));
+        gif.write(reinterpret_cast<const char *>(out.data()), out.size());
+    }
+    stop = false;
+    encoder = std::thread(&Exporter::loop, this);
+    return true;
+}
+
+// true while frames are being exported
+bool Exporter::isOpen() {
+    return encoder.joinable();
+}
+
+
+/*********************************************************************
+ ** Function: capture
+ ** Description: Queue a picture of the engine's current cells.
+ ** Parameters: The engine.
+ ** Pre-Conditions: open succeeded.
+ ** Post-Conditions: The cells are copied to a snapshot for the encoder
+ **   thread, waiting first for a snapshot to be free if every one is
+ **   still queued.
+ *********************************************************************/
+
+void Exporter::capture(Engine &engine) {
+    ScopedTimer timer(CAPTURE_TIMER);
+    int slot;
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (spare.empty()) {
+            signal.wait(guard);
+        }
+        slot = spare.back();
+        spare.pop_back();
+    }
+    engine.saveState(slots[slot]);
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        waiting.push_back(slot);
+        frames++;
+    }
+    signal.notify_all();
+}
+
+// body of the encoder thread: encode each snapshot queued, then
+// hand its slot back
+void Exporter::loop() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        while (!stop && waiting.empty()) {
+            signal.wait(guard);
+        }
+        if (waiting.empty()) {
+            return;
+        }
+        int slot = waiting.front();
+        waiting.pop_front();
+        bool skip = failed;
+        guard.unlock();
+        bool ok = true;
+        if (!skip) {
+            ScopedTimer timer(ENCODE_TIMER);
+            Snapshot &snapshot = slots[slot];
+            render(snapshot);
+            if (format == PGM_FORMAT) {
+                ok = writePgm(frameName(snapshot.getGeneration()));
+            } else if (format == PNG_FORMAT) {
+                ok = writePng(frameName(snapshot.getGeneration()));
+            } else {
+                ok = writeGif();
+            }
+        }
+        guard.lock();
+        if (!ok && !failed) {
+            failed = true;
+            error = "Could not write " + (format == GIF_FORMAT ? fileName :
+                    frameName(slots[slot].getGeneration()));
+        }
+        spare.push_back(slot);
+        signal.notify_all();
+    }
+}
+
+
+/*********************************************************************
+ ** Function: finish
+ ** Description: Encode the frames still queued and close the files.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: The encoder thread is stopped.  Returns false,
+ **   with the reason in getError, if any frame could not be written.
+ *********************************************************************/
+
+bool Exporter::finish() {
+    if (!encoder.joinable()) {
+        return !failed;
+    }
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        stop = true;
+    }
+    signal.notify_all();
+    encoder.join();
+    if (format == GIF_FORMAT) {
+        gif.put(0x3B);
+        gif.close();
+        if (gif.fail() && !failed) {
+            failed = true;
+            error = "Could not write " + fileName;
+        }
+    }
+    return !failed;
+}
+
+// number of frames captured since open
+long long Exporter::getFrames() {
+    std::unique_lock<std::mutex> guard(lock);
+    return frames;
+}
+
+// what went wrong first
+std::string Exporter::getError() {
+    std::unique_lock<std::mutex> guard(lock);
+    return error;
+}
+
+// file of the frame of a generation: the export file with the
+// generation before its extension
+std::string Exporter::frameName(long long generation) {
+    char number[32];
+    snprintf(number, sizeof(number), "-%08lld", generation);
+    size_t dot = fileName.rfind('.');
+    return fileName.substr(0, dot) + number + fileName.substr(dot);
+}
+
+// add a live cell in engine coordinates to the pixel it falls in
+inline void Exporter::addCell(long long x, long long y) {
+    if (x >= x0 && x < x0 + width && y >= y0 && y < y0 + height) {
+        sums[((y - y0) / scale) * (pixelsX / zoom) + (x - x0) / scale]++;
+    }
+}
+
+
+/*********************************************************************
+ ** Function: render
+ ** Description: Shade the picture of a snapshot's cells.
+ ** Parameters: The snapshot, dense or sparse.
+ ** Pre-Conditions: open succeeded.
+ ** Post-Conditions: image holds a byte per pixel of the picture, from
+ **   0 where no cell is alive to 255 where every cell is, each pixel
+ **   repeated zoom times across and down.
+ *********************************************************************/
+
+void Exporter::render(Snapshot &snapshot) {
+    int sx = pixelsX / zoom, sy = pixelsY / zoom;
+    sums.assign(static_cast<size_t>(sx) * sy, 0);
+    const uint64_t *words = snapshot.getWords();
+    size_t count = snapshot.getWordCount();
+    if (snapshot.getKind() == Snapshot::DENSE) {
+        // only the rows and words of the region, after the padding
+        // words before the rows
+        long long stride = snapshot.getStride();
+        long long pad = (count - stride * snapshot.getRows()) / 2;
+        long long j0 = std::max(y0, 0LL);
+        long long j1 = std::min<long long>(y0 + height, snapshot.getRows());
+        long long w0 = std::max(x0, 0LL) / 64;
+        long long w1 = std::min((x0 + width + 63) / 64, stride);
+        for (long long j = j0; j < j1; j++) {
+            const uint64_t *row = words + pad + j * stride;
+            for (long long w = w0; w < w1; w++) {
+                for (uint64_t b = row[w]; b != 0; b &= b - 1) {
+                    addCell(64*w + __builtin_ctzll(b), j);
+                }
+            }
+        }
+    } else {
+        // tiles of their x and y tile numbers, then their rows
+        const int T = Snapshot::TILE;
+        for (size_t t = 0; t + 2 + T <= count; t += 2 + T) {
+            long long tx = static_cast<long long>(words[t]) * T;
+            long long ty = static_cast<long long>(words[t + 1]) * T;
+            if (tx + T <= x0 || tx >= x0 + width ||
+                ty + T <= y0 || ty >= y0 + height) {
+                continue;
+            }
+            for (int r = 0; r < T; r++) {
+                for (uint64_t b = words[t + 2 + r]; b != 0; b &= b - 1) {
+                    addCell(tx + __builtin_ctzll(b), ty + r);
+                }
+            }
+        }
+    }
+
+    // shade each pixel by the share of its cells alive, and repeat
+    // each row of pixels to zoom
+    image.resize(static_cast<size_t>(pixelsX) * pixelsY);
+    unsigned full = scale * scale;
+    for (int py = 0; py < sy; py++) {
+        unsigned char *line = &image[static_cast<size_t>(py) * zoom * pixelsX];
+        for (int px = 0; px < sx; px++) {
+            unsigned shade = (sums[py * sx + px] * 255 + full / 2) / full;
+            for (int z = 0; z < zoom; z++) {
+                line[px * zoom + z] = static_cast<unsigned char>(shade);
+            }
+        }
+        for (int z = 1; z < zoom; z++) {
+            memcpy(line + z * pixelsX, line, pixelsX);
+        }
+    }
+}
+
+// write the picture to a binary PGM file
+bool Exporter::writePgm(const std::string &name) {
+    std::ofstream file(name.c_str(), std::ios::binary);
+    file << "P5\n" << pixelsX << " " << pixelsY << "\n255\n";
+    file.write(reinterpret_cast<const char *>(image.data()), image.size());
+    file.close();
+    return !file.fail();
+}
+
+// CRC-32 of bytes, as PNG chunks end with
+uint32_t Exporter::crc(const unsigned char *p, size_t n) {
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t k = 0; k < n; k++) {
+        c = crcTable[(c ^ p[k]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+// append a PNG chunk's length and type before the data at its end
+// of out, and its CRC after it
+void Exporter::putChunk(const char *type, size_t start) {
+    size_t length = out.size() - start;
+    std::vector<unsigned char> head;
+    putBig(head, static_cast<uint32_t>(length));
+    head.insert(head.end(), type, type + 4);
+    out.insert(out.begin() + start, head.begin(), head.end());
+    putBig(out, crc(&out[start + 4], length + 4));
+}
+
+
+/*********************************************************************
+ ** Function: writePng
+ ** Description: Write the picture to an 8-bit grayscale PNG file.
+ ** Parameters: File name.
+ ** Pre-Conditions: render has shaded the picture.
+ ** Post-Conditions: Returns false if the file could not be written.
+ *********************************************************************/
+
+bool Exporter::writePng(const std::string &name) {
+    static const unsigned char SIGNATURE[8] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'
+    };
+    out.assign(SIGNATURE, SIGNATURE + 8);
+    size_t start = out.size();
+    putBig(out, pixelsX);
+    putBig(out, pixelsY);
+    out.push_back(8);       // bits per pixel
+    out.push_back(0);       // grayscale
+    out.push_back(0);       // deflate
+    out.push_back(0);       // adaptive filters
+    out.push_back(0);       // not interlaced
+    putChunk("IHDR", start);
+
+    // every row with no filter, in one zlib stream
+    std::vector<unsigned char> raw;
+    raw.reserve(static_cast<size_t>(pixelsX + 1) * pixelsY);
+    for (int py = 0; py < pixelsY; py++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), image.begin() + static_cast<size_t>(py) * pixelsX,
+                   image.begin() + static_cast<size_t>(py + 1) * pixelsX);
+    }
+    start = out.size();
+    out.push_back(0x78);
+    out.push_back(0x01);
+    deflate(raw.data(), raw.size());
+    uint32_t a = 1, b = 0;
+    for (size_t k = 0; k < raw.size(); k++) {
+        a = (a + raw[k]) % 65521;
+        b = (b + a) % 65521;
+    }
+    putBig(out, (b << 16) | a);
+    putChunk("IDAT", start);
+    putChunk("IEND", out.size());
+
+    std::ofstream file(name.c_str(), std::ios::binary);
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    file.close();
+    return !file.fail();
+}
+
+// add bits to out, lowest first, as deflate and GIF pack them
+void Exporter::putBits(uint32_t value, int n) {
+    bits |= static_cast<uint64_t>(value) << bitCount;
+    bitCount += n;
+    while (bitCount >= 8) {
+        out.push_back(static_cast<unsigned char>(bits));
+        bits >>= 8;
+        bitCount -= 8;
+    }
+}
+
+// add a Huffman code, which deflate packs highest bit first
+void Exporter::putCode(uint32_t code, int n) {
+    uint32_t reversed = 0;
+    for (int k = 0; k < n; k++) {
+        reversed = (reversed << 1) | ((code >> k) & 1);
+    }
+    putBits(reversed, n);
+}
+
+// add a literal, length or end symbol in the fixed Huffman code
+void Exporter::putSymbol(int symbol) {
+    if (symbol < 144) {
+        putCode(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        putCode(0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        putCode(symbol - 256, 7);
+    } else {
+        putCode(0xC0 + symbol - 280, 8);
+    }
+}
+
+
+/*********************************************************************
+ ** Function: deflate
+ ** Description: Compress bytes to a deflate block with the fixed
+ **   Huffman codes.  Matches are found through a hash of each three
+ **   bytes, taking the latest place they were seen, which is enough
+ **   for the long runs and repeated rows of a picture of cells.
+ ** Parameters: Bytes and their number.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The compressed bytes are appended to out.
+ *********************************************************************/
+
+void Exporter::deflate(const unsigned char *data, size_t n) {
+    bits = 0;
+    bitCount = 0;
+    putBits(1, 1);          // last block
+    putBits(1, 2);          // fixed Huffman codes
+    table.assign(1 << HASH_BITS, -1);
+    size_t pos = 0;
+    while (pos < n) {
+        int length = 0;
+        size_t from = 0;
+        if (pos + 3 <= n) {
+            int h = ((data[pos] << 10) ^ (data[pos + 1] << 5) ^ data[pos + 2])
+                    & ((1 << HASH_BITS) - 1);
+            int last = table[h];
+            table[h] = static_cast<int>(pos);
+            if (last >= 0 && pos - last <= static_cast<size_t>(WINDOW)) {
+                from = last;
+                size_t limit = std::min<size_t>(n - pos, MAX_MATCH);
+                while (static_cast<size_t>(length) < limit &&
+                       data[from + length] == data[pos + length]) {
+                    length++;
+                }
+            }
+        }
+        if (length < 3) {
+            putSymbol(data[pos]);
+            pos++;
+            continue;
+        }
+
+        // the length and distance codes with their extra bits
+        int c = 28;
+        while (LENGTH_BASE[c] > length) {
+            c--;
+        }
+        putSymbol(257 + c);
+        putBits(length - LENGTH_BASE[c], LENGTH_EXTRA[c]);
+        int distance = static_cast<int>(pos - from);
+        int d = 29;
+        while (DISTANCE_BASE[d] > distance) {
+            d--;
+        }
+        putCode(d, 5);
+        putBits(distance - DISTANCE_BASE[d], DISTANCE_EXTRA[d]);
+
+        // remember the places inside the match
+        for (size_t k = pos + 1; k < pos + length && k + 3 <= n; k++) {
+            int h = ((data[k] << 10) ^ (data[k + 1] << 5) ^ data[k + 2])
+                    & ((1 << HASH_BITS) - 1);
+            table[h] = static_cast<int>(k);
+        }
+        pos += length;
+    }
+    putSymbol(256);
+    putBits(0, 7);          // fill the last byte
+}
+
+
+/*********************************************************************
+ ** Function: compress
+ ** Description: LZW encode bytes for a GIF with 8-bit codes, the
+ **   strings seen so far kept in a hash table of each string's code
+ **   and next byte.  The table is reset when it holds 4095 codes.
+ ** Parameters: Bytes and their number.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The codes, packed lowest bit first, are appended
+ **   to out.
+ *********************************************************************/
+
+void Exporter::compress(const unsigned char *data, size_t n) {
+    std::vector<int> keys(GIF_TABLE);
+    table.assign(GIF_TABLE, -1);
+    bits = 0;
+    bitCount = 0;
+    int size = 9;
+    int next = GIF_END + 1;
+    putBits(GIF_CLEAR, size);
+    int code = n > 0 ? data[0] : 0;
+    for (size_t k = 1; k < n; k++) {
+        int key = (code << 8) | data[k];
+        int h = (key * 31 + data[k]) & (GIF_TABLE - 1);
+        while (table[h] >= 0 && keys[h] != key) {
+            h = (h + 1) & (GIF_TABLE - 1);
+        }
+        if (table[h] >= 0) {
+            code = table[h];
+            continue;
+        }
+        putBits(code, size);
+        if (next >= (1 << size) && size < 12) {
+            size++;
+        }
+        if (next >= GIF_CODES) {
+            putBits(GIF_CLEAR, size);
+            table.assign(GIF_TABLE, -1);
+            size = 9;
+            next = GIF_END + 1;
+        } else {
+            keys[h] = key;
+            table[h] = next++;
+        }
+        code = data[k];
+    }
+    putBits(code, size);
+    if (next >= (1 << size) && size < 12) {
+        size++;
+    }
+    putBits(GIF_END, size);
+    putBits(0, 7);          // fill the last byte
+}
+
+
+/*********************************************************************
+ ** Function: writeGif
+ ** Description: Add the picture to the animated GIF as a frame.
+ ** Parameters: none
+ ** Pre-Conditions: render has shaded the picture.
+ ** Post-Conditions: Returns false if the frame could not be written.
+ *********************************************************************/
+
+bool Exporter::writeGif() {
+    out.clear();
+    static const unsigned char CONTROL[4] = { 0x21, 0xF9, 0x04, 0x00 };
+    out.insert(out.end(), CONTROL, CONTROL + 4);
+    putLittle(out, delay);
+    out.push_back(0);
+    out.push_back(0);
+    out.push_back(0x2C);
+    putLittle(out, 0);
+    putLittle(out, 0);
+    putLittle(out, pixelsX);
+    putLittle(out, pixelsY);
+    out.push_back(0);
+    out.push_back(8);
+    size_t start = out.size();
+    compress(image.data(), image.size());
+
+    // split the codes into blocks of up to 255 bytes, each after its
+    // length
+    std::vector<unsigned char> blocks;
+    for (size_t k = start; k < out.size(); k += 255) {
+        size_t length = std::min<size_t>(out.size() - k, 255);
+        blocks.push_back(static_cast<unsigned char>(length));
+        blocks.insert(blocks.end(), out.begin() + k, out.begin() + k + length);
+    }
+    blocks.push_back(0);
+    out.resize(start);
+    out.insert(out.end(), blocks.begin(), blocks.end());
+    gif.write(reinterpret_cast<const char *>(out.data()), out.size());
+    return !gif.fail();
+}
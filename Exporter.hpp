@@ -0,0 +1,93 @@
+/*********************************************************************
+ ** Program Filename: Exporter.hpp, Exporter class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Exporter class specification, writes pictures of a
+ **   simulation as it runs: a PGM or PNG file per frame, or the frames
+ **   of one animated GIF.  A pixel shows a square of cells, brighter
+ **   the more of them are alive, and can be drawn as a larger square
+ **   of pixels.  Frames are copied out of the engine as snapshots,
+ **   which is all the simulation waits for, and encoded by a
+ **   background thread; a few snapshots are kept for reuse, and the
+ **   simulation only waits for one to be free when all of them are
+ **   still waiting to be encoded.
+ ** Input: engine, region of the board, cells per pixel, pixels per
+ **   cell, frame delay
+ ** Output: PGM, PNG or GIF files
+ *********************************************************************/
+
+#ifndef Exporter_hpp
+#define Exporter_hpp
+
+#include <stdint.h>             // header file for fixed width integer types
+#include <cstddef>              // header file for size_t
+#include <string>               // header file for string objects
+#include <vector>               // header file for vector objects
+#include <deque>                // header file for double ended queues
+#include <fstream>              // header file for file streams
+#include <thread>               // header file for thread objects
+#include <mutex>                // header file for mutual exclusion
+#include <condition_variable>   // header file for thread signalling
+#include "Snapshot.hpp"
+#include "Engine.hpp"
+
+class Exporter {
+public:
+    enum Format { PGM_FORMAT, PNG_FORMAT, GIF_FORMAT }; // kind of file
+    static const int QUEUE = 4;         // snapshots kept for encoding
+private:
+    Format format;                      // kind of file written
+    std::string fileName;               // file, or pattern of frame files
+    long long x0, y0;                   // engine coordinates of top left
+    int width, height;                  // cells exported
+    int scale;                          // cells per side of a pixel
+    int zoom;                           // pixels per side of a pixel
+    int delay;                          // GIF frame delay, centiseconds
+    int pixelsX, pixelsY;               // size of the picture
+    long long frames;                   // frames captured
+    Snapshot slots[QUEUE];              // copies of the cells
+    std::deque<int> waiting;            // slots to encode, oldest first
+    std::vector<int> spare;             // slots free to capture into
+    std::thread encoder;                // background encoder thread
+    std::mutex lock;                    // protects the fields above
+    std::condition_variable signal;     // signals work or its end
+    bool stop;                          // true when shutting down
+    bool failed;                        // a frame could not be written
+    std::string error;                  // what went wrong first
+    std::ofstream gif;                  // animated GIF being written
+    std::vector<uint32_t> sums;         // live cells of each pixel
+    std::vector<unsigned char> image;   // shade of each pixel
+    std::vector<unsigned char> out;     // encoded bytes
+    uint64_t bits;                      // bits not yet added to out
+    int bitCount;                       // number of those bits
+    std::vector<int> table;             // LZW or match hash table
+    uint32_t crcTable[256];             // CRC-32 of each byte
+    void loop();                        // body of the encoder thread
+    void render(Snapshot &);            // shade the picture of cells
+    void addCell(long long, long long); // add a live cell to its pixel
+    std::string frameName(long long);   // file of one frame
+    bool writePgm(const std::string &); // write the picture as PGM
+    bool writePng(const std::string &); // write the picture as PNG
+    bool writeGif();                    // add the picture to the GIF
+    void putBits(uint32_t, int);        // add bits, first bit lowest
+    void putCode(uint32_t, int);        // add a Huffman code
+    void putSymbol(int);                // add a fixed Huffman literal
+    void deflate(const unsigned char *, size_t); // compress to out
+    void compress(const unsigned char *, size_t); // LZW encode to out
+    void putChunk(const char *, size_t); // finish a PNG chunk in out
+    uint32_t crc(const unsigned char *, size_t); // CRC-32 of bytes
+    Exporter(const Exporter &);             // not copyable
+    Exporter &operator=(const Exporter &);  // not assignable
+public:
+    Exporter();                         // constructor
+    ~Exporter();                        // destructor
+    bool open(const std::string &, long long, long long, int, int, int,
+              int, int);                // start exporting to files
+    bool isOpen();                      // true while exporting
+    void capture(Engine &);             // queue a frame of the cells
+    bool finish();                      // encode the rest, close files
+    long long getFrames();              // get number of frames captured
+    std::string getError();             // get what went wrong first
+};
+
+#endif /* Exporter_hpp */
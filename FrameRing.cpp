@@ -0,0 +1,49 @@
+/*********************************************************************
+ ** Program Filename: FrameRing.cpp, FrameRing class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Triple buffer of frames handed from the thread that
+ **   steps the simulation to the thread that draws it, without locks.
+ ** Input: dimensions of the frames, frames filled by the stepper
+ ** Output: newest frame to the drawer
+ *********************************************************************/
+
+#include "FrameRing.hpp"
+
+// constructor, three dead frames of ncol x nrow visible cells; none is
+// published yet
+FrameRing::FrameRing(int ncol, int nrow) : shared(1) {
+    for (int k = 0; k < 3; k++) {
+        frames[k].cells.resize(ncol, nrow);
+        frames[k].tick = 0;
+    }
+    back = 0;
+    front = 2;
+}
+
+// frame for the stepper to fill
+FrameRing::Frame &FrameRing::getBack() {
+    return frames[back];
+}
+
+// publish the back frame as the newest, and take the frame it replaces
+// (published before, or given back by the drawer) to fill next.  The
+// exchange releases the cells filled, so the drawer sees them whole.
+void FrameRing::publish() {
+    back = shared.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+// take the newest published frame, giving back the one shown; false,
+// keeping the frame shown, if none was published since the last take
+bool FrameRing::take() {
+    if ((shared.load(std::memory_order_acquire) & FRESH) == 0) {
+        return false;
+    }
+    front = shared.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+    return true;
+}
+
+// frame the drawer took last
+FrameRing::Frame &FrameRing::getFront() {
+    return frames[front];
+}
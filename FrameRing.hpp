@@ -0,0 +1,46 @@
+/*********************************************************************
+ ** Program Filename: FrameRing.hpp, FrameRing class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Triple buffer of frames handed from the thread that
+ **   steps the simulation to the thread that draws it, without locks.
+ **   The stepper fills the back frame and publishes it, taking back
+ **   the frame published before; the drawer takes the newest frame
+ **   published, giving back the one it drew.  Neither ever waits for
+ **   the other: the stepper always has a frame to fill, and the
+ **   drawer always gets the newest complete one, skipping any it was
+ **   too slow to draw.  One thread may fill and one may draw.
+ ** Input: dimensions of the frames, frames filled by the stepper
+ ** Output: newest frame to the drawer
+ *********************************************************************/
+
+#ifndef FrameRing_hpp
+#define FrameRing_hpp
+
+#include <atomic>   // header file for atomic operations
+#include "Grid.hpp"
+
+class FrameRing {
+public:
+    struct Frame {
+        Grid cells;         // visible cells, as Engine::exportWindow fills
+        long long tick;     // time step of the cells
+    };
+private:
+    static const int FRESH = 4;     // flag of a frame not yet taken
+    Frame frames[3];                // back, shared and front frames
+    int back;                       // frame the stepper fills
+    std::atomic<int> shared;        // frame last published, with FRESH
+                                    // until the drawer takes it
+    int front;                      // frame the drawer shows
+    FrameRing(const FrameRing &);             // not copyable
+    FrameRing &operator=(const FrameRing &);  // not assignable
+public:
+    FrameRing(int, int);            // constructor
+    Frame &getBack();               // frame to fill (stepper)
+    void publish();                 // hand the back frame over (stepper)
+    bool take();                    // take the newest frame (drawer)
+    Frame &getFront();              // frame taken (drawer)
+};
+
+#endif /* FrameRing_hpp */
@@ -3,51 +3,175 @@
  ** Author: Diana Bacon
  ** Date: 2015-09-26
  ** Description: Game class implementation, handles high-level control
- **   of the Game of Life
- ** Input: menu-driven user input
+ **   of the Game of Life: menus and drawing around a Life board
+ ** Input: menu-driven user input, pattern library, keys pressed
+ **   during a run
  ** Output: displays time step and simulation result
  *********************************************************************/
 
 #include "Game.hpp"
+#include "Keyboard.hpp"
+#include <thread>   // header file for thread objects
+#include <cstdio>   // header file for snprintf
+
+static const int KEY_WAIT_MS = 5;       // longest wait for a key between
+                                        // looks for a new frame
+static const int PAUSE_WAIT_MS = 10;    // wait of a paused stepper
 
 /*********************************************************************
  ** Function:  Game
- ** Description:  Game class default constructor
- ** Parameters: none
+ ** Description:  Game class constructor
+ ** Parameters: Engine to simulate with (bool grid, bit-packed grid,
+ **   unbounded universe or HashLife), number of threads stepping
+ **   the bit-packed grid or universe, number of visible cells in the
+ **   x and y directions and whether to draw them as braille.
  ** Pre-Conditions: none
- ** Post-Conditions:  Two grid objects are created and other attributes
- **   are initialized.
+ ** Post-Conditions:  The board and display window are created and
+ **   other attributes are initialized.  A frame is drawn every time
+ **   step, ten per second.
  *********************************************************************/
 
-Game::Game() {
-    Grid oddGrid(40,20);  // current grid for odd time steps
-    Grid evenGrid(40,20); // current grid for even time steps
+Game::Game(Backend b, int nthreads, int ncol, int nrow, bool braille)
+    : life(b, ncol, nrow, nthreads), screen(ncol, nrow, braille) {
+    viewX = screen.getHide() + 1; // universe coordinates of the top
+    viewY = screen.getHide() + 1; // left cell shown on screen
+    renderEvery = 1;    // generations per frame
+    fps = 10;           // frames per second
     patternName = "";     // pattern name
     xLoc = 20;          // x coordinate for centerpoint of seed pattern
     yLoc = 10;          // y coordinate for centerpoint of seed pattern
     tick = 0;           // initial time step
+    controlled = false; // keys are read only during a run
+    paused = false;
+    quitting = false;
+    finished = false;
+    stepsWanted = 0;
+    rate = 0;
 }
 
 
 /*********************************************************************
- ** Function: getUserInput
- ** Description: Get user choice of starting pattern and location via
- **   interactive menu.  Reads pattern from a file, determines
- **   dimensions of pattern, and limits choice of starting location
- **   accordingly so that pattern will not be written to an out of
- **   memory location.
+ ** Function:  ~Game
+ ** Description:  Game class destructor
  ** Parameters: none
- ** Pre-Conditions:  Pattern files must exist in same directory, a 
- **   Seed object named mySeed, a string named pattern,  and integer
- **    variables xLoc and yLoc must exist.
- ** Post-Conditions:  Pattern coordinates will be stored in the Seed
- **   object, and starting coordinates wil be stored in variables
- **   xLoc and yLoc.  Returns the number of time steps to run.
+ ** Pre-Conditions: none
+ ** Post-Conditions:  The board is deallocated with the game.
  *********************************************************************/
 
-int Game::getUserInput() {
+Game::~Game() {
+}
+
+
+/*********************************************************************
+ ** Function: setLibrary
+ ** Description: Offer the patterns of a directory in the menu.
+ ** Parameters: The directory.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The directory's patterns are indexed and cached
+ **   (see PatternLibrary).  If it holds none the menu offers the
+ **   bundled patterns.  Returns false, after printing the reason, if
+ **   the directory cannot be read.
+ *********************************************************************/
+
+bool Game::setLibrary(const std::string &dir) {
+    if (!library.open(dir)) {
+        std::cerr << library.getError() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: choosePattern
+ ** Description: Get user choice of seed pattern from the library.
+ ** Parameters: none
+ ** Pre-Conditions: The library holds at least one pattern.
+ ** Post-Conditions: Only patterns that can be centered on the screen
+ **   of a bounded board are offered.  A short library is listed whole;
+ **   otherwise the user types part of a name and the patterns holding
+ **   it are listed, MENU_SIZE at most.  Patterns sharing a name are
+ **   listed by their paths.  The chosen pattern is read from the
+ **   library's cache into mySeed.  Returns false if no pattern of a
+ **   short library fits.
+ *********************************************************************/
+
+bool Game::choosePattern() {
+    int count = library.getCount();
+
+    // a pattern is centered with size/2 cells on either side of the
+    // center, so an even size needs a cell more than itself
+    int maxX = life.isBounded() ? (screen.getSizeX() - 1) | 1 : 0;
+    int maxY = life.isBounded() ? (screen.getSizeY() - 1) | 1 : 0;
+    std::vector<int> found;
+    int choice = 0;
+    while (choice == 0) {
+        if (count <= MENU_SIZE) {
+            library.search("", maxX, maxY, found);
+            if (found.empty()) {
+                std::cout << "No pattern in the library fits on the screen";
+                std::cout << std::endl;
+                return false;
+            }
+        } else {
+            std::string text;
+            std::cout << "Search " << count << " patterns, enter part of";
+            std::cout << " a name: ";
+            if (!(std::cin >> text)) {
+                return true;
+            }
+            library.search(text, maxX, maxY, found);
+            if (found.empty()) {
+                std::cout << "No pattern that fits is named like that";
+                std::cout << std::endl;
+                continue;
+            }
+        }
+
+        // display a menu and get user choice of starting pattern
+        int shown = static_cast<int>(found.size());
+        if (shown > MENU_SIZE) {
+            shown = MENU_SIZE;
+        }
+        int lowest = count <= MENU_SIZE ? 1 : 0;
+        std::cout << "Choose a seed pattern:" << std::endl;
+        for (int i = 0; i < shown; i++) {
+            std::cout << i + 1 << ") " << library.getLabel(found[i]);
+            std::cout << " (" << library.getSizeX(found[i]) << " x ";
+            std::cout << library.getSizeY(found[i]) << ")" << std::endl;
+        }
+        if (lowest == 0) {
+            if (static_cast<int>(found.size()) > shown) {
+                std::cout << "(" << found.size() - shown << " more, search";
+                std::cout << " again to narrow them down)";
+                std::cout << std::endl;
+            }
+            std::cout << "0) Search again" << std::endl;
+        }
+        std::cout << "Enter a value from " << lowest << " to " << shown;
+        std::cout << ": ";
+        std::cin >> choice;
+        while ((choice < lowest) || (choice > shown))
+        {
+            std::cout << "ERROR: Enter a value from " << lowest << " to ";
+            std::cout << shown << ": ";
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::cin >> choice;
+        }
+    }
+    patternName = library.getLabel(found[choice - 1]);
+    if (!library.load(found[choice - 1], mySeed)) {
+        std::cout << library.getError() << std::endl;
+    }
+    return true;
+}
+
+
+// choose one of the three bundled seed patterns, read from their files
+void Game::chooseBundled() {
     int choice = 1;
-    
+
     // display a menu and get user choice of starting pattern
     std::cout << "Choose a seed pattern:" << std::endl;
     std::cout << "1) Blinker" << std::endl;
@@ -78,16 +202,51 @@ int Game::getUserInput() {
     }
     
     // read pattern file
-    mySeed.readFile(patternName);
+    if (!mySeed.readFile(patternName)) {
+        std::cout << mySeed.getError() << std::endl;
+    }
+}
+
+
+/*********************************************************************
+ ** Function: getUserInput
+ ** Description: Get user choice of starting pattern and location via
+ **   interactive menu.  Takes the pattern from the library, or reads
+ **   one of the bundled patterns from its file, determines
+ **   dimensions of pattern, and limits choice of starting location
+ **   accordingly so that pattern will not be written to an out of
+ **   memory location.
+ ** Parameters: none
+ ** Pre-Conditions:  Pattern files must exist in same directory, a 
+ **   Seed object named mySeed, a string named pattern,  and integer
+ **    variables xLoc and yLoc must exist.
+ ** Post-Conditions:  Pattern coordinates will be stored in the Seed
+ **   object, and starting coordinates wil be stored in variables
+ **   xLoc and yLoc.  Returns the number of time steps to run.
+ *********************************************************************/
+
+int Game::getUserInput() {
+    // choose a pattern from the library, or the bundled ones if it
+    // has none that fit
+    if (library.getCount() == 0 || !choosePattern()) {
+        chooseBundled();
+    }
     std::cout << std::endl;
     std::cout << "The dimensions of the seed pattern are ";
     std::cout << mySeed.getSizeX() << " x " << mySeed.getSizeY() << std::endl;
 
-    // calculate safe range for starting location
+    // calculate safe range for starting location; an unbounded
+    // universe can hold the pattern anywhere around the screen
     int x1 = mySeed.getSizeX()/2 + 1;
-    int x2 = evenGrid.getSizeX() - mySeed.getSizeX()/2;
+    int x2 = screen.getSizeX() - mySeed.getSizeX()/2;
     int y1 = mySeed.getSizeY()/2 + 1;
-    int y2 = evenGrid.getSizeY() - mySeed.getSizeY()/2;
+    int y2 = screen.getSizeY() - mySeed.getSizeY()/2;
+    if (!life.isBounded()) {
+        x1 = 1;
+        x2 = screen.getSizeX();
+        y1 = 1;
+        y2 = screen.getSizeY();
+    }
     
     // display a menu and get user choice of starting location
     std::cout << std::endl;
@@ -123,9 +282,10 @@ int Game::getUserInput() {
         std::cin >> yLoc;
     }
     
-    // adjust location to account for hidden cells
-    xLoc = xLoc + evenGrid.getHide();
-    yLoc = yLoc + evenGrid.getHide();
+    // convert screen location to board coordinates, which count from
+    // the first visible cell
+    xLoc = xLoc + viewX - 1 - screen.getHide();
+    yLoc = yLoc + viewY - 1 - screen.getHide();
     
     // get user choice of number of time steps
     int nsteps;
@@ -143,81 +303,284 @@ int Game::getUserInput() {
 }
 
 
+// choose the rule the cells follow; false if the engine cannot run it
+bool Game::setRule(const Rule &rule) {
+    return life.setRule(rule);
+}
+
+// choose the edges of the grid; false if the engine has none
+bool Game::setBoundary(Boundary b) {
+    return life.setBoundary(b);
+}
+
+// choose the generations stepped per pass over memory; false if the
+// engine steps one at a time
+bool Game::setBlock(int k) {
+    return life.setBlock(k);
+}
+
+
 /*********************************************************************
  ** Function: setSeed
  ** Description: Apply seed pattern to grid at specified location and
  **   display time step and grid state to screen.
- ** Parameters: A seed object and a grid object.
+ ** Parameters: none
  ** Pre-Conditions: A seed object named mySeed must contain coordinates
- **   of starting pattern.  A grid object named evenGrid must exist.
- **   The seed pattern must not be larger than the grid.
+ **   of starting pattern.
  ** Post-Conditions: The initial time step and grid state will be 
  **   displayed.
  *********************************************************************/
 
 void Game::setSeed(){
     
-    // set time step to zero and fill grid with zeros
+    // set time step to zero, clear the board and apply the pattern
+    life.clear();
+    life.loadPattern(mySeed, xLoc, yLoc);
     tick = 0;
-    evenGrid.clearGrid();
-    
-    // apply the starting pattern to the grid
-    for (int i = 0; i < mySeed.getLength(); i++) {
-        evenGrid.setState(xLoc + mySeed.getX(i),
-                          yLoc + mySeed.getY(i), 1);
-    }
+    cycles.clear();
     
     // display the result
-    system("clear");
-    std::cout << "Tick = " << tick << std::endl;
-    evenGrid.displayGrid();
+    screen.invalidate();
+    displayTick();
     usleep(1000000); // pause for 1 second
 }
 
 
 /*********************************************************************
- ** Function: calcTick
- ** Description: Calculate and display grid state at a single time 
- **   step.
- ** Parameters: none
- ** Pre-Conditions:  Grid objects named evenGrid and oddGrid must
- **   exist.
- ** Post-Conditions: The current time step and grid state will be
- **   displayed.
+ ** Function: setFrameRate
+ ** Description: Choose when frames are drawn while the simulation
+ **   runs.
+ ** Parameters: Number of time steps per frame and frames per second.
+ **   With both, a frame is drawn every so many time steps and frames
+ **   are paced to the frame rate.  With only time steps per frame (0
+ **   frames per second), the simulation runs flat out and a frame is
+ **   drawn every so many time steps.  With only a frame rate (0 time
+ **   steps per frame), the simulation runs flat out and the latest
+ **   time step is drawn at that rate.
+ ** Pre-Conditions: At least one of the two must be positive.
+ ** Post-Conditions: Later runs draw frames accordingly.
  *********************************************************************/
 
-void Game::calcTick() {
-    
-    // determine which grid is current based on time step
-    Grid *current;
-    Grid *future;
-    if (tick % 2 == 0) {    // time step is even
-        current = &evenGrid;
-        future = &oddGrid;
-    } else {
-        current = &oddGrid;
-        future  = &evenGrid;
+void Game::setFrameRate(int every, double rate) {
+    renderEvery = every;
+    fps = rate;
+}
+
+
+// choose what a run does once the board repeats: see CycleDetector
+void Game::setCycleAction(CycleAction action) {
+    cycles.setAction(action);
+}
+
+
+/*********************************************************************
+ ** Function: run
+ ** Description: Calculate a number of time steps, displaying the grid
+ **   state as chosen with setFrameRate.  The board is stepped on a
+ **   thread of its own, which copies the visible cells of each time
+ **   step to draw into a FrameRing; this thread draws the newest frame
+ **   there and reads keys from the terminal: space pauses and resumes,
+ **   s pauses or steps one generation while paused, + and - double
+ **   and halve the speed, f runs as fast as the engine goes, and q
+ **   ends the run.  The last time step is always displayed.
+ ** Parameters: Number of time steps.
+ ** Pre-Conditions:  The seed must have been applied with setSeed.
+ ** Post-Conditions: The final time step and grid state will be
+ **   displayed, and any cycle the pattern settled into reported.  A
+ **   cycle may end the run early or be skipped through, as chosen with
+ **   setCycleAction, and q ends it where it is.
+ *********************************************************************/
+
+void Game::run(long long nsteps) {
+    typedef std::chrono::steady_clock Clock;
+    FrameRing ring(screen.getSizeX(), screen.getSizeY());
+    Keyboard keys;
+    controlled = keys.isActive();
+    paused = false;
+    quitting = false;
+    finished = false;
+    stepsWanted = 0;
+    rate = renderEvery > 0 && fps > 0 ? renderEvery * fps : 0;
+
+    // frames go no faster than the frame rate when the stepper is not
+    // paced to it
+    std::chrono::duration<double> gap(renderEvery == 0 && fps > 0 ? 1 / fps : 0);
+    Clock::time_point start = Clock::now(), shown = start;
+    long long firstTick = tick, shownTick = tick;
+    bool any = false;   // true once a frame was taken
+    std::thread stepper(&Game::stepLoop, this, tick + nsteps, &ring);
+    while (true) {
+        bool done = finished;
+        Clock::time_point now = Clock::now();
+        if ((done || now - shown >= gap) && ring.take()) {
+            FrameRing::Frame &f = ring.getFront();
+            screen.show(f.cells, f.tick, status());
+            shown = now;
+            shownTick = f.tick;
+            any = true;
+        }
+        if (done) {
+            break;
+        }
+        int key = keys.read(KEY_WAIT_MS);
+        std::chrono::duration<double> ran = Clock::now() - start;
+        double speed = ran.count() > 0 ? (shownTick - firstTick) / ran.count() : 0;
+        if (key != Keyboard::NONE && handleKey(key, speed) && any) {
+            FrameRing::Frame &f = ring.getFront();
+            screen.show(f.cells, f.tick, status());
+        }
     }
-    
-    // calculate future state
-    int myNeighbors, myState;
-    int jmax = current->getSizeY()+2*current->getHide();
-    int imax = current->getSizeX()+2*current->getHide();
-    for (int j = 1; j <= jmax; j++) {
-        for (int i = 1; i <= imax; i++) {
-            myNeighbors = current->sumNeighbors(i, j);
-            myState = current->getState(i, j);
-            future->setState(i, j, 0);
-            if (myNeighbors == 3 || (myNeighbors == 2 && myState == 1) ) {
-                future->setState(i, j, 1);
+    stepper.join();
+    controlled = false;
+    if (cycles.isFound()) {
+        std::cout << "Cycle: " << cycles.describe() << std::endl;
+    }
+}
+
+
+/*********************************************************************
+ ** Function: stepLoop
+ ** Description: Body of the thread stepping the board during a run.
+ ** Parameters: Time step to stop at and the ring to publish frames to.
+ ** Pre-Conditions: Started by run, which owns the ring.
+ ** Post-Conditions: The board is stepped to the end, a cycle that
+ **   stops the run, or a quit key, a frame published every so many
+ **   time steps as chosen with setFrameRate (every one if frames go
+ **   by time), and the steps paced to the speed chosen.  While paused
+ **   only the single steps asked for are taken.  Never waits on the
+ **   drawing thread.  Sets finished after the last frame.
+ *********************************************************************/
+
+void Game::stepLoop(long long end, FrameRing *ring) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point due = Clock::now();
+    while (tick < end && !cycles.isStopped() && !quitting) {
+        long long n = 1;
+        if (paused) {
+            if (stepsWanted == 0) {
+                std::this_thread::sleep_for(
+                    std::chrono::milliseconds(PAUSE_WAIT_MS));
+                due = Clock::now();
+                continue;
+            }
+            stepsWanted--;
+        } else if (renderEvery > 0) {
+            // step straight to the next time step to draw
+            n = renderEvery - tick % renderEvery;
+            n = n < end - tick ? n : end - tick;
+        }
+        tick += cycles.advance(life.getEngine(), n);
+        FrameRing::Frame &f = ring->getBack();
+        life.getEngine().exportWindow(f.cells, viewX, viewY);
+        f.tick = tick;
+        ring->publish();
+
+        // keep to the speed, without racing to catch up after a stall
+        double r = rate;
+        if (r > 0 && !paused) {
+            due += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(n / r));
+            Clock::time_point now = Clock::now();
+            if (due > now) {
+                std::this_thread::sleep_until(due);
+            } else if (now - due > std::chrono::milliseconds(250)) {
+                due = now;
             }
         }
     }
-    
-    // display the result
-    tick++;
-    system("clear");
-    std::cout << "Tick = " << tick << std::endl;
-    future->displayGrid();
-    usleep(100000);  // pause for 0.1 second
+    finished = true;
+}
+
+
+/*********************************************************************
+ ** Function: handleKey
+ ** Description: Act on a key pressed during a run.
+ ** Parameters: The key and the generations per second run so far.
+ ** Pre-Conditions: Called by run while the stepper runs.
+ ** Post-Conditions: Space pauses or resumes, s pauses or asks for one
+ **   more generation while paused, + doubles the speed, - halves it
+ **   (starting from the speed so far when running flat out), f runs
+ **   flat out, and q ends the run.  Returns true if the status shown
+ **   changed.
+ *********************************************************************/
+
+bool Game::handleKey(int key, double speed) {
+    double r = rate;
+    switch (key) {
+        case ' ':
+            paused = !paused;
+            return true;
+        case 's':
+        case 'S':
+            if (paused) {
+                stepsWanted++;
+            }
+            paused = true;
+            return true;
+        case '+':
+        case '=':
+            rate = r * 2;
+            return r > 0;
+        case '-':
+        case '_':
+            r = r > 0 ? r : speed;
+            rate = r / 2 > 0.5 ? r / 2 : 0.5;
+            return true;
+        case 'f':
+        case 'F':
+            rate = 0;
+            return r > 0;
+        case 'q':
+        case 'Q':
+            quitting = true;
+            return false;
+        default:
+            return false;
+    }
+}
+
+// state of the run shown after the time step while keys control it:
+// paused, or the speed it is held to
+std::string Game::status() {
+    if (!controlled) {
+        return "";
+    }
+    if (paused) {
+        return "  [paused]";
+    }
+    double r = rate;
+    if (r <= 0) {
+        return "";
+    }
+    char text[48];
+    snprintf(text, sizeof(text), "  [%g gen/s]", r);
+    return text;
+}
+
+
+/*********************************************************************
+ ** Function: displayTick
+ ** Description: Display the time step and the visible cells.
+ ** Parameters: none
+ ** Pre-Conditions:  No run is stepping the board.
+ ** Post-Conditions: The screen shows the current time step.
+ *********************************************************************/
+
+void Game::displayTick() {
+    screen.draw(life.getEngine(), viewX, viewY, tick);
+}
+
+
+/*********************************************************************
+ ** Function: setViewport
+ ** Description: Move the screen to show a different part of the
+ **   universe.
+ ** Parameters: Universe coordinates of the top left cell on screen.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Later displays show the new part of the universe.
+ *********************************************************************/
+
+void Game::setViewport(long long x, long long y) {
+    viewX = x;
+    viewY = y;
 }
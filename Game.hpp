@@ -3,8 +3,12 @@
  ** Author: Diana Bacon
  ** Date: 2015-09-26
  ** Description: Game class specification, handles high-level control
- **   of the Game of Life
- ** Input: menu-driven user input
+ **   of the Game of Life: menus and drawing around a Life board.  A
+ **   run steps the board on a thread of its own, which hands frames
+ **   to the drawing thread through a FrameRing, so neither waits on
+ **   the other or on the terminal.
+ ** Input: menu-driven user input, pattern library, keys pressed
+ **   during a run
  ** Output: displays time step and simulation result
  *********************************************************************/
 
@@ -13,23 +17,66 @@
 
 #include <iostream> // header file for input and output stream objects
 #include <string>   // header file for string objects
-#include <cstdlib>  // header file for system clear
 #include <limits>   // header file for properties of numeric types
+#include <unistd.h> // header file for usleep
+#include <chrono>   // header file for clocks
+#include <atomic>   // header file for atomic operations
+#include <vector>   // header file for vector objects
 #include "Grid.hpp"
 #include "Seed.hpp"
+#include "Engine.hpp"
+#include "Life.hpp"
+#include "Renderer.hpp"
+#include "CycleDetector.hpp"
+#include "FrameRing.hpp"
+#include "PatternLibrary.hpp"
 
 class Game {
 private:
-    Grid oddGrid, evenGrid; // current grids for odd and even time steps
+    Life life;              // board running the simulation
+    Renderer screen;        // draws the visible cells
+    int renderEvery;        // generations per frame, 0 to go by time
+    double fps;             // frames per second, 0 for no limit
+    long long viewX, viewY; // universe coordinates of top left of screen
     std::string patternName;    // name of seed pattern
     int xLoc, yLoc;         // x and y coordinates to center pattern
-    int tick;               // current time step
+    long long tick;         // current time step
     Seed mySeed;            // object to hold seed pattern coordinates
+    PatternLibrary library; // patterns offered in the menu
+    CycleDetector cycles;   // watches the run for a repeating board
+    bool controlled;        // true if keys control the run
+    std::atomic<bool> paused;       // true while stepping waits for keys
+    std::atomic<bool> quitting;     // true once the run is to end early
+    std::atomic<bool> finished;     // true once the stepper is done
+    std::atomic<long long> stepsWanted; // single steps asked for
+    std::atomic<double> rate;       // generations per second, 0 for
+                                    // as fast as the engine goes
+    static const int MENU_SIZE = 20;    // most patterns listed at once
+    bool choosePattern();   // choose a seed pattern from the library
+    void chooseBundled();   // choose one of the bundled seed patterns
+    void displayTick();     // display time step and visible cells
+    void stepLoop(long long, FrameRing *);  // body of the stepper thread
+    bool handleKey(int, double);    // act on a key, true if shown
+    std::string status();   // state of the run, shown after the tick
+    Game(const Game &);             // not copyable
+    Game &operator=(const Game &);  // not assignable
 public:
-    Game();                 // default constructor
+    Game(Backend = UNIVERSE_BACKEND, int = 1, int = 40, int = 20,
+         bool = false);     // constructor
+    ~Game();                // destructor
+    bool setLibrary(const std::string &); // offer a directory's patterns
     int getUserInput();     // get user input
     void setSeed();         // apply seed pattern to grid
-    void calcTick();        // calculate grid state at single time step
+    void setFrameRate(int, double); // choose when frames are drawn
+    void setCycleAction(CycleAction);   // choose what a cycle does
+    bool setRule(const Rule &);     // choose the rule, false if the
+                                    // engine cannot run it
+    bool setBoundary(Boundary);     // choose the edges, false if the
+                                    // engine has none
+    bool setBlock(int);             // generations per pass over memory,
+                                    // false if the engine steps one
+    void run(long long);    // calculate and display time steps
+    void setViewport(long long, long long); // move the screen
 };
 
 #endif /* Game_hpp */
@@ -10,64 +10,193 @@
  *********************************************************************/
 
 #include "Grid.hpp"
+#include "GridPool.hpp"
+#include "Soup.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <atomic>
 
 // constructor (nrow x ncol grid with boundary and hidden cells)
 Grid::Grid(int ncol, int nrow) {
-    sizeX = ncol;
-    sizeY = nrow;
     hide = 4;
-    state = new bool*[sizeX+2*(hide+1)];
-    for (int i = 0; i < sizeX+2*(hide+1); i++) {
-        state[i] = new bool[sizeY+2*(hide+1)];
-    }
+    boundary = PLANE_BOUNDARY;
+    cells = 0;
+    capacity = 0;
+    skew = 0;
+    allocate(ncol, nrow);
     clearGrid();
 }
 
 // default constructor (40 x 20 grid with boundary and hidden cells)
 Grid::Grid(){
-    sizeX = 40;
-    sizeY = 20;
     hide = 4;
-    state = new bool*[sizeX+2*(hide+1)];
-    for (int i = 0; i < sizeX+2*(hide+1); i++) {
-        state[i] = new bool[sizeY+2*(hide+1)];
-    }
+    boundary = PLANE_BOUNDARY;
+    cells = 0;
+    capacity = 0;
+    skew = 0;
+    allocate(40, 20);
     clearGrid();
 }
 
-// destructor, deallocate memory
+// move constructor, take the cells of another grid, which is left
+// with none until it is resized
+Grid::Grid(Grid &&g) {
+    cells = g.cells;
+    capacity = g.capacity;
+    skew = g.skew;
+    column = g.column;
+    sizeX = g.sizeX;
+    sizeY = g.sizeY;
+    hide = g.hide;
+    boundary = g.boundary;
+    g.cells = 0;
+    g.capacity = 0;
+    g.skew = 0;
+    g.column = 0;
+    g.sizeX = 0;
+    g.sizeY = 0;
+}
+
+// move assignment, give back these cells and take those of another
+// grid, which is left with none until it is resized, as by the move
+// constructor
+Grid &Grid::operator=(Grid &&g) {
+    if (this != &g) {
+        release();
+        swap(g);
+        g.column = 0;
+        g.sizeX = 0;
+        g.sizeY = 0;
+    }
+    return *this;
+}
+
+// destructor, give the cells back to the pool
 Grid::~Grid() {
-    for (int i = 0; i < sizeX+2*(hide+1); i++) {
-        delete [] state[i];
+    release();
+}
+
+// set the dimensions and take a block large enough for the cells,
+// keeping the block held if it is; the cells are not cleared.  The
+// pool's blocks are all aligned alike, so each new block has its cells
+// start a few cache lines further in than the last one did.
+void Grid::allocate(int ncol, int nrow) {
+    static std::atomic<unsigned> made(0);
+    sizeX = ncol;
+    sizeY = nrow;
+    column = sizeY+2*(hide+1);
+    size_t bytes = static_cast<size_t>(sizeX+2*(hide+1)) * column;
+    if (cells == 0 || skew + bytes > capacity) {
+        release();
+        size_t s = (made++ % 4) * STAGGER;
+        unsigned char *block = static_cast<unsigned char *>(
+                GridPool::shared().acquire(s + bytes, capacity));
+        skew = s;
+        cells = block + skew;
+    }
+}
+
+// give the block of cells back to the pool; the grid holds none after
+void Grid::release() {
+    if (cells != 0) {
+        GridPool::shared().release(cells - skew, capacity);
     }
-    delete [] state;
+    cells = 0;
+    capacity = 0;
+    skew = 0;
+}
+
+// trade cells, dimensions and edges with another grid, without copying
+void Grid::swap(Grid &g) {
+    std::swap(cells, g.cells);
+    std::swap(capacity, g.capacity);
+    std::swap(skew, g.skew);
+    std::swap(column, g.column);
+    std::swap(sizeX, g.sizeX);
+    std::swap(sizeY, g.sizeY);
+    std::swap(hide, g.hide);
+    std::swap(boundary, g.boundary);
+}
+
+// change the visible dimensions, keeping the block of cells if it is
+// large enough, and kill all cells
+void Grid::resize(int ncol, int nrow) {
+    allocate(ncol, nrow);
+    clearGrid();
 }
 
 // set grid cell state
 void Grid::setState(int i, int j, bool s) {
-    state[i][j] = s;
+    cells[static_cast<size_t>(i)*column + j] = s;
 }
 
 // return grid cell state
 bool Grid::getState(int i, int j){
-    return state[i][j];
+    return cells[static_cast<size_t>(i)*column + j] == 1;
+}
+
+// set grid cell state, which may be a dying state of a Generations rule
+void Grid::setValue(int i, int j, int s) {
+    cells[static_cast<size_t>(i)*column + j] = static_cast<unsigned char>(s);
+}
+
+// return grid cell state, dying states included
+int Grid::getValue(int i, int j) {
+    return cells[static_cast<size_t>(i)*column + j];
 }
 
 // set all grid states to zero
 void Grid::clearGrid() {
-    for (int i = 0; i < sizeX+2*(hide+1); i++) {
-        for (int j = 0; j < sizeY+2*(hide+1); j++) {
-            setState(i, j, 0);
+    if (cells != 0) {
+        memset(cells, 0, static_cast<size_t>(sizeX+2*(hide+1)) * column);
+    }
+}
+
+
+/*********************************************************************
+ ** Function: fillSoup
+ ** Description: Fill a rectangle of the grid with a random soup.
+ ** Parameters: The soup, the indices x0 and y0 of the rectangle's top
+ **   left cell, which is cell 0, 0 of the soup, and its width and
+ **   height.
+ ** Pre-Conditions: The rectangle is inside the grid.
+ ** Post-Conditions: Each cell of the rectangle is live if the soup's
+ **   cell is, and dead otherwise.  The soup is made a word of 64 cells
+ **   along a row at a time, for 64 rows, and written out a column at a
+ **   time, down the 64 rows, which lie next to each other in memory.
+ *********************************************************************/
+
+void Grid::fillSoup(const Soup &soup, int x0, int y0, int w, int h) {
+    uint64_t block[64];
+    uint64_t keys[64];
+    for (int r0 = 0; r0 < h; r0 += 64) {
+        int rows = std::min(64, h - r0);
+        for (int r = 0; r < rows; r++) {
+            keys[r] = soup.rowKey(r0 + r);
+        }
+        for (int k = 0; 64*k < w; k++) {
+            for (int r = 0; r < rows; r++) {
+                block[r] = soup.getWord(keys[r], k);
+            }
+            int width = std::min(64, w - 64*k);
+            for (int b = 0; b < width; b++) {
+                unsigned char *c = cells
+                    + static_cast<size_t>(x0 + 64*k + b)*column + y0 + r0;
+                for (int r = 0; r < rows; r++) {
+                    c[r] = (block[r] >> b) & 1;
+                }
+            }
         }
     }
 }
 
-// return sum of neigbor cell states
+// return number of live neighbor cells
 int Grid::sumNeighbors(int i, int j){
-    return state[i-1][j+1] + state[i+1][j+1] +
-            state[i-1][j] + state[i+1][j] +
-            state[i-1][j-1] + state[i+1][j-1] +
-            state[i][j+1] + state[i][j-1];
+    return getState(i-1, j+1) + getState(i+1, j+1) +
+            getState(i-1, j) + getState(i+1, j) +
+            getState(i-1, j-1) + getState(i+1, j-1) +
+            getState(i, j+1) + getState(i, j-1);
 }
 
 // get visible X dimension of grid
@@ -84,19 +213,77 @@ int Grid::getSizeY(){
 int Grid::getHide(){
     return hide;
 }
-// print grid to screen
-void Grid::displayGrid() {
-    
-    // display the grid
-    for (int j = 1 + hide; j <= sizeY + hide; j++) {
-        for (int i = 1 + hide; i <= sizeX + hide; i++) {
-            if (state[i][j] == 1) {
-                std::cout << '@';
-            } else {
-                std::cout << ' ';
+// choose the edges of the grid.  Away from the plane only the visible
+// cells are stepped, so any cells outside them are killed.
+void Grid::setBoundary(Boundary b) {
+    boundary = b;
+    int x0 = getEdge(), x1 = sizeX+2*hide+1-x0;
+    int y0 = x0, y1 = sizeY+2*hide+1-y0;
+    for (int i = 0; i < sizeX+2*(hide+1); i++) {
+        for (int j = 0; j < sizeY+2*(hide+1); j++) {
+            if (i < x0 || i > x1 || j < y0 || j > y1) {
+                setValue(i, j, 0);
             }
         }
-        std::cout << std::endl;
+    }
+}
+
+// get the edges of the grid
+Boundary Grid::getBoundary() {
+    return boundary;
+}
+
+// get the index of the first row and column of cells stepped: the
+// first hidden cell on the plane, otherwise the first visible cell.
+// As many are left out at the far end.
+int Grid::getEdge() {
+    return boundary == PLANE_BOUNDARY ? 1 : hide + 1;
+}
+
+
+/*********************************************************************
+ ** Function: fillHalo
+ ** Description: Fill the ring of cells just outside the stepped ones
+ **   with the cells a wrapped grid has there, so a time step can count
+ **   neighbors as if the grid had no edge.
+ ** Parameters: none
+ ** Pre-Conditions: The ring is dead.
+ ** Post-Conditions: On a torus each cell of the ring holds the cell at
+ **   the opposite edge; on a Klein bottle the top and bottom rows are
+ **   also mirrored left to right.  Otherwise the ring stays dead.
+ *********************************************************************/
+
+void Grid::fillHalo() {
+    if (boundary != TORUS_BOUNDARY && boundary != KLEIN_BOUNDARY) {
+        return;
+    }
+    int x0 = getEdge(), x1 = sizeX+2*hide+1-x0;
+    int y0 = x0, y1 = sizeY+2*hide+1-y0;
+    for (int j = y0; j <= y1; j++) {
+        setValue(x0-1, j, getValue(x1, j));
+        setValue(x1+1, j, getValue(x0, j));
+    }
+    for (int i = x0-1; i <= x1+1; i++) {
+        int m = boundary == KLEIN_BOUNDARY ? x0 + x1 - i : i;
+        setValue(i, y0-1, getValue(m, y1));
+        setValue(i, y1+1, getValue(m, y0));
+    }
+}
+
+// kill the ring of cells filled by fillHalo
+void Grid::clearHalo() {
+    if (boundary != TORUS_BOUNDARY && boundary != KLEIN_BOUNDARY) {
+        return;
+    }
+    int x0 = getEdge(), x1 = sizeX+2*hide+1-x0;
+    int y0 = x0, y1 = sizeY+2*hide+1-y0;
+    for (int j = y0-1; j <= y1+1; j++) {
+        setValue(x0-1, j, 0);
+        setValue(x1+1, j, 0);
+    }
+    for (int i = x0-1; i <= x1+1; i++) {
+        setValue(i, y0-1, 0);
+        setValue(i, y1+1, 0);
     }
 }
 
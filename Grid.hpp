@@ -3,35 +3,116 @@
  ** Author: Diana Bacon
  ** Date: 2015-09-26
  ** Description:  Attributes and functions related to the game grid
- **   for the Game of Life.
+ **   for the Game of Life.  Away from the plane, only the visible
+ **   cells are stepped, and the ring of cells around them is filled
+ **   from the opposite edges before a time step and cleared after it,
+ **   so the neighbor counts need no bounds checks.
  ** Input: dimensions of grid, number of hidden and boundary cells,
  **    and state of each grid cell (live or dead).
- ** Output:  Grid parameters, display grid to screen.
+ ** Output:  Grid parameters and cell states.
  *********************************************************************/
 
 #ifndef Grid_hpp
 #define Grid_hpp
 
-#include <iostream> // header file for input and output stream objects
+#include <cstddef>  // header file for size_t
+
+// edges of a bounded grid: the plane, emulated by stepping a margin of
+// hidden cells around the visible ones; a dead edge around the visible
+// cells; the visible cells wrapped into a torus; or wrapped into a
+// Klein bottle, where crossing the top or bottom edge also mirrors the
+// pattern left to right
+enum Boundary { PLANE_BOUNDARY, DEAD_BOUNDARY, TORUS_BOUNDARY,
+                KLEIN_BOUNDARY };
+
+// statistics of a generation, gathered while stepping to it: the live
+// cells, the cells born and died in that time step (-1 if not known),
+// and the box around the cells that are not dead, which is empty, with
+// its minimum above its maximum, if there are none
+struct CellStats {
+    static const long long NONE = 1LL << 62;   // corner of an empty box
+    long long population;   // live cells
+    long long births;       // cells born by the last time step
+    long long deaths;       // cells that died in the last time step
+    long long minX, minY;   // corner of the box with the least x and y
+    long long maxX, maxY;   // corner of the box with the most x and y
+
+    // no cells, births or deaths
+    void clear() {
+        population = births = deaths = 0;
+        minX = minY = NONE;
+        maxX = maxY = -NONE;
+    }
+
+    // true if the box holds no cells
+    bool isEmpty() const {
+        return minX > maxX;
+    }
+
+    // widen the box to hold a cell
+    void addCell(long long x, long long y) {
+        minX = x < minX ? x : minX;
+        maxX = x > maxX ? x : maxX;
+        minY = y < minY ? y : minY;
+        maxY = y > maxY ? y : maxY;
+    }
+
+    // add the statistics of another part of the board
+    void add(const CellStats &s) {
+        population += s.population;
+        births = births < 0 || s.births < 0 ? -1 : births + s.births;
+        deaths = deaths < 0 || s.deaths < 0 ? -1 : deaths + s.deaths;
+        if (!s.isEmpty()) {
+            addCell(s.minX, s.minY);
+            addCell(s.maxX, s.maxY);
+        }
+    }
+};
+
+class Soup;
 
 class Grid {
+public:
+    static const size_t STAGGER = 1088; // bytes between the first cells
+                            // of grids made one after the other, so the
+                            // grids stepped together do not alias in cache
 private:
-    bool **state;   // 2D array with state of cell (1=live, 0=dead)
+    unsigned char *cells;   // state of each cell (1=live, 0=dead, 2 and
+                            // up dying), one column after another
+    size_t capacity;        // bytes of the block holding the cells
+    size_t skew;            // bytes of the block before the first cell
+    int column;     // cells per column, hidden and boundary cells included
     int sizeX;      // x dimension of visible portion of array
     int sizeY;      // y dimension of visible portion of array
     int hide;       // number of extra cells to hide on each boundary
+    Boundary boundary;  // edges of the grid
+    void allocate(int,int);         // take a block for the cells
+    void release();                 // give the block back to the pool
+    Grid(const Grid &);             // not copyable
+    Grid &operator=(const Grid &);  // not assignable
 public:
     Grid(int,int);                  // constructor
     Grid();                         // default constructor
+    Grid(Grid &&);                  // move constructor
+    Grid &operator=(Grid &&);       // move assignment
     ~Grid();                        // destructor
+    void swap(Grid &);              // trade cells with another grid
+    void resize(int,int);           // change dimensions, killing all cells
     void setState(int,int,bool);    // set state of a single cell
     bool getState(int,int);         // get state of a single cell
+    void setValue(int,int,int);     // set state, dying states included
+    int getValue(int,int);          // get state, dying states included
     void clearGrid();               // set state of all cells to zero
-    int sumNeighbors(int,int);      // get sum of neighbor state
+    void fillSoup(const Soup &, int, int, int, int); // fill with a soup
+    int sumNeighbors(int,int);      // get number of live neighbors
     int getSizeX();                 // get x dimension of visible portion
     int getSizeY();                 // get y dimension of visible portion
     int getHide();                  // get number of hidden cells
-    void displayGrid();             // print all cell states to screen
+    void setBoundary(Boundary);     // choose the edges of the grid
+    Boundary getBoundary();         // get the edges of the grid
+    int getEdge();                  // get index of first stepped cell
+    void fillHalo();                // copy wrapped cells around the edge
+    void clearHalo();               // kill the cells around the edge
 };
 
 #endif /* Grid_hpp */
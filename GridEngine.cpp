@@ -0,0 +1,341 @@
+/*********************************************************************
+ ** Program Filename: GridEngine.cpp, GridEngine class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Simulation engine that steps a pair of grids, one
+ **   cell at a time, looking up each cell's next state in a table
+ **   made from the rule.
+ ** Input: grid dimensions, seed pattern, number of generations
+ ** Output: cell states, generation count, population
+ *********************************************************************/
+
+#include "GridEngine.hpp"
+#include "Kernel.hpp"
+#include "Soup.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+
+// constructor (ncol x nrow visible grid)
+GridEngine::GridEngine(int ncol, int nrow)
+    : oddGrid(ncol, nrow), evenGrid(ncol, nrow) {
+    start = 0;
+    tick = 0;
+    stats[0].clear();
+    stats[1].clear();
+    statsValid[0] = statsValid[1] = true;
+    setRule(rule);
+}
+
+// name of the engine
+const char *GridEngine::getName() {
+    return "bool";
+}
+
+// grid holding the current time step
+Grid *GridEngine::current() {
+    return tick % 2 == 0 ? &evenGrid : &oddGrid;
+}
+
+// true if a cell index lies on the cells stepped, which on the plane
+// leaves out only the outer ring of the grid; on a torus or Klein
+// bottle the index is wrapped onto the visible cells first
+bool GridEngine::inside(long long &x, long long &y) {
+    if (boundary != PLANE_BOUNDARY) {
+        return placeCell(x, y, evenGrid.getEdge(), evenGrid.getSizeX(),
+                         evenGrid.getSizeY());
+    }
+    int edge = evenGrid.getEdge();
+    return x >= edge && y >= edge &&
+           x < evenGrid.getSizeX() + 2*(evenGrid.getHide()+1) - edge &&
+           y < evenGrid.getSizeY() + 2*(evenGrid.getHide()+1) - edge;
+}
+
+// choose the edges of the grid, killing any cells outside the visible
+// ones unless it is the plane
+bool GridEngine::setBoundary(Boundary b) {
+    boundary = b;
+    evenGrid.setBoundary(b);
+    oddGrid.setBoundary(b);
+    statsValid[0] = statsValid[1] = false;
+    return true;
+}
+
+// kill all cells and restart at time step zero
+void GridEngine::clear() {
+    start = 0;
+    tick = 0;
+    evenGrid.clearGrid();
+    oddGrid.clearGrid();
+    stats[0].clear();
+    stats[1].clear();
+    statsValid[0] = statsValid[1] = true;
+}
+
+// follow a rule: any rule, dying states and neighborhood included
+bool GridEngine::setRule(const Rule &r) {
+    rule = r;
+    table.assign(rule.getStates() * 9, 0);
+    for (int s = 0; s < rule.getStates(); s++) {
+        for (int n = 0; n <= rule.getNeighbors(); n++) {
+            table[s*9 + n] = static_cast<unsigned char>(rule.next(s, n));
+        }
+    }
+    return true;
+}
+
+// set a cell of the current time step; cells off the grid are ignored
+void GridEngine::setCell(long long x, long long y, bool s) {
+    if (inside(x, y)) {
+        current()->setState(static_cast<int>(x), static_cast<int>(y), s);
+        statsValid[tick % 2] = false;
+    }
+}
+
+// set a cell of the current time step to any state of the rule
+void GridEngine::setCellState(long long x, long long y, int s) {
+    if (inside(x, y) && s >= 0 && s < rule.getStates()) {
+        current()->setValue(static_cast<int>(x), static_cast<int>(y), s);
+        statsValid[tick % 2] = false;
+    }
+}
+
+// fill a rectangle with a soup, a block of rows at a time, when it
+// lies within the stepped cells; one at a time, wrapping or clipping
+// as setCell does, when it does not
+void GridEngine::loadSoup(const Soup &soup, long long x, long long y,
+                          long long w, long long h) {
+    int edge = evenGrid.getEdge();
+    long long nx = evenGrid.getSizeX() + 2*(evenGrid.getHide()+1);
+    long long ny = evenGrid.getSizeY() + 2*(evenGrid.getHide()+1);
+    if (x < edge || y < edge || x + w > nx - edge || y + h > ny - edge) {
+        Engine::loadSoup(soup, x, y, w, h);
+        return;
+    }
+    ScopedTimer timer(SEED_TIMER);
+    current()->fillSoup(soup, static_cast<int>(x), static_cast<int>(y),
+                        static_cast<int>(w), static_cast<int>(h));
+    statsValid[tick % 2] = false;
+}
+
+// get a cell of the current time step; cells off the grid are dead
+bool GridEngine::getCell(long long x, long long y) {
+    if (!inside(x, y)) {
+        return false;
+    }
+    return current()->getState(static_cast<int>(x), static_cast<int>(y));
+}
+
+// number of live neighbors of a cell in a neighborhood; the
+// hexagonal one leaves out north-east and south-west
+template <Neighborhood N>
+static inline int countNeighbors(Grid *g, int i, int j) {
+    if (N == MOORE) {
+        return g->sumNeighbors(i, j);
+    }
+    int n = g->getState(i-1, j) + g->getState(i+1, j) +
+            g->getState(i, j-1) + g->getState(i, j+1);
+    if (N == HEXAGONAL) {
+        n += g->getState(i-1, j-1) + g->getState(i+1, j+1);
+    }
+    return n;
+}
+
+
+/*********************************************************************
+ ** Function: stepOnce
+ ** Description: Advance one time step in a neighborhood.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: The other grid holds the next generation, with
+ **   its statistics gathered on the way.  Only cells that can change
+ **   or must be cleared are stepped: the box around this generation's
+ **   cells grown by one, and the box around the older cells still in
+ **   the other grid.  Every cell is stepped while either box is not
+ **   known, or when the grown box reaches a wrapped edge.
+ *********************************************************************/
+
+template <Neighborhood N>
+void GridEngine::stepOnce() {
+    ScopedTimer timer(STEP_TIMER);
+
+    // determine which grid is current based on time step
+    int n = tick % 2;
+    Grid *now = current();
+    Grid *future = (now == &evenGrid) ? &oddGrid : &evenGrid;
+
+    // find the cells to step
+    int e = now->getEdge();
+    int jmax = now->getSizeY()+2*now->getHide()+1-e;
+    int imax = now->getSizeX()+2*now->getHide()+1-e;
+    int i0 = e, i1 = imax, j0 = e, j1 = jmax;
+    if (statsValid[0] && statsValid[1]) {
+        const CellStats &a = stats[n], &b = stats[1-n];
+        long long x0 = std::min(a.minX - 1, b.minX);
+        long long x1 = std::max(a.maxX + 1, b.maxX);
+        long long y0 = std::min(a.minY - 1, b.minY);
+        long long y1 = std::max(a.maxY + 1, b.maxY);
+        bool wrap = boundary == TORUS_BOUNDARY || boundary == KLEIN_BOUNDARY;
+        if (x0 > x1) {
+            i1 = i0 - 1;
+        } else if (!wrap || (x0 >= e && x1 <= imax && y0 >= e && y1 <= jmax)) {
+            i0 = static_cast<int>(std::max<long long>(x0, e));
+            i1 = static_cast<int>(std::min<long long>(x1, imax));
+            j0 = static_cast<int>(std::max<long long>(y0, e));
+            j1 = static_cast<int>(std::min<long long>(y1, jmax));
+        }
+    }
+
+    // calculate future state of the stepped cells, with the ring
+    // around them holding the cells of a wrapped grid
+    int myNeighbors, myState, nextState;
+    CellStats next;
+    next.clear();
+    now->fillHalo();
+    for (int j = j0; j <= j1; j++) {
+        for (int i = i0; i <= i1; i++) {
+            myNeighbors = countNeighbors<N>(now, i, j);
+            myState = now->getValue(i, j);
+            nextState = table[myState*9 + myNeighbors];
+            future->setValue(i, j, nextState);
+            if (nextState != 0) {
+                next.population += nextState == 1;
+                next.addCell(i, j);
+            }
+            if ((myState == 1) != (nextState == 1)) {
+                next.births += nextState == 1;
+                next.deaths += myState == 1;
+            }
+        }
+    }
+    now->clearHalo();
+    if (boundary == PLANE_BOUNDARY) {
+        countRing(now, future, next);
+    }
+    stats[1-n] = next;
+    statsValid[1-n] = true;
+    tick++;
+    if (i0 <= i1 && j0 <= j1) {
+        Trace::count(CELLS_COUNTER, uint64_t(j1 - j0 + 1) * (i1 - i0 + 1));
+    }
+    Trace::count(BIRTHS_COUNTER, next.births);
+    Trace::count(DEATHS_COUNTER, next.deaths);
+}
+
+// advance n time steps
+void GridEngine::step(long long n) {
+    for (long long t = 0; t < n; t++) {
+        switch (rule.getNeighborhood()) {
+            case VON_NEUMANN:
+                stepOnce<VON_NEUMANN>();
+                break;
+            case HEXAGONAL:
+                stepOnce<HEXAGONAL>();
+                break;
+            default:
+                stepOnce<MOORE>();
+                break;
+        }
+        Trace::endGeneration(getGeneration());
+    }
+}
+
+// number of time steps run since the last clear
+long long GridEngine::getGeneration() {
+    return start + tick;
+}
+
+// set the generation count, keeping the cells
+void GridEngine::setGeneration(long long n) {
+    start = n - tick;
+}
+
+// number of live cells
+long long GridEngine::getPopulation() {
+    Grid *now = current();
+    long long n = 0;
+    for (int j = 0; j < now->getSizeY()+2*(now->getHide()+1); j++) {
+        for (int i = 0; i < now->getSizeX()+2*(now->getHide()+1); i++) {
+            n += now->getState(i, j);
+        }
+    }
+    return n;
+}
+
+// call a function with the coordinates of every live cell
+void GridEngine::forEachCell(CellFunction fn, void *context) {
+    Grid *now = current();
+    for (int j = 0; j < now->getSizeY()+2*(now->getHide()+1); j++) {
+        for (int i = 0; i < now->getSizeX()+2*(now->getHide()+1); i++) {
+            if (now->getState(i, j)) {
+                fn(context, i, j);
+            }
+        }
+    }
+}
+
+// hash of the cells, dying cells of a Generations rule included, so
+// boards that differ only in how far their cells have decayed differ;
+// a two-state board hashes as in Engine::getHash
+uint64_t GridEngine::getHash() {
+    Grid *now = current();
+    uint64_t hash = 0;
+    for (int j = 0; j < now->getSizeY()+2*(now->getHide()+1); j++) {
+        for (int i = 0; i < now->getSizeX()+2*(now->getHide()+1); i++) {
+            int state = now->getValue(i, j);
+            if (state != 0) {
+                hash ^= hashCells<uint64_t>(
+                    static_cast<uint64_t>(i) * 0xD6E8FEB86659FD93ULL +
+                    static_cast<uint64_t>(j), state);
+            }
+        }
+    }
+    return hash;
+}
+
+// gather the statistics of a grid, with no births or deaths
+void GridEngine::countCells(int n) {
+    Grid *g = n == 0 ? &evenGrid : &oddGrid;
+    int c = boundary == PLANE_BOUNDARY ? 0 : g->getEdge();
+    stats[n].clear();
+    for (int j = c; j < g->getSizeY()+2*(g->getHide()+1)-c; j++) {
+        for (int i = c; i < g->getSizeX()+2*(g->getHide()+1)-c; i++) {
+            int state = g->getValue(i, j);
+            if (state != 0) {
+                stats[n].population += state == 1;
+                stats[n].addCell(i, j);
+            }
+        }
+    }
+    statsValid[n] = true;
+}
+
+// add the cells of the outer boundary of the plane, which are never
+// stepped, to the statistics of the next generation
+void GridEngine::countRing(Grid *now, Grid *future, CellStats &next) {
+    int nx = now->getSizeX()+2*(now->getHide()+1);
+    int ny = now->getSizeY()+2*(now->getHide()+1);
+    for (int j = 0; j < ny; j++) {
+        int step = (j == 0 || j == ny-1) ? 1 : nx-1;
+        for (int i = 0; i < nx; i += step) {
+            int before = now->getValue(i, j);
+            int after = future->getValue(i, j);
+            if (after != 0) {
+                next.population += after == 1;
+                next.addCell(i, j);
+            }
+            if ((before == 1) != (after == 1)) {
+                next.births += after == 1;
+                next.deaths += before == 1;
+            }
+        }
+    }
+}
+
+// statistics of the current generation, gathered as it was stepped
+// to, or by visiting every cell if its cells were set since then
+CellStats GridEngine::getStats() {
+    if (!statsValid[tick % 2]) {
+        countCells(tick % 2);
+    }
+    return stats[tick % 2];
+}
@@ -0,0 +1,56 @@
+/*********************************************************************
+ ** Program Filename: GridEngine.hpp, GridEngine class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Simulation engine that steps a pair of grids, one
+ **   cell at a time, looking up each cell's next state in a table
+ **   made from the rule.  Kept as the reference the faster engines
+ **   are checked against, and the only engine that runs Generations
+ **   rules.  The population, births, deaths and the box around the
+ **   cells are gathered while stepping, and each time step only steps
+ **   the box, grown by a cell for births.
+ ** Input: grid dimensions, seed pattern, number of generations
+ ** Output: cell states, generation count, population
+ *********************************************************************/
+
+#ifndef GridEngine_hpp
+#define GridEngine_hpp
+
+#include "Engine.hpp"
+#include "Grid.hpp"
+#include <vector>   // header file for vector objects
+
+class GridEngine : public Engine {
+private:
+    Grid oddGrid, evenGrid; // current grids for odd and even time steps
+    long long start;        // generation of time step zero
+    long long tick;         // current time step
+    std::vector<unsigned char> table;   // next state of each state and
+                                        // neighbor count
+    CellStats stats[2];     // statistics of the even and odd grids
+    bool statsValid[2];     // statistics match the cells of each grid
+    Grid *current();        // grid holding the current time step
+    template <Neighborhood N> void stepOnce(); // advance one time step
+    bool inside(long long &, long long &); // true if a cell is on the grid
+    void countCells(int);   // gather the statistics of a grid
+    void countRing(Grid *, Grid *, CellStats &); // add the plane's edge
+public:
+    GridEngine(int,int);    // constructor
+    const char *getName();
+    void clear();
+    bool setRule(const Rule &);
+    bool setBoundary(Boundary);
+    void setCell(long long, long long, bool);
+    void loadSoup(const Soup &, long long, long long, long long, long long);
+    bool getCell(long long, long long);
+    void setCellState(long long, long long, int);
+    void step(long long);
+    long long getGeneration();
+    void setGeneration(long long);
+    long long getPopulation();
+    void forEachCell(CellFunction, void *);
+    uint64_t getHash();
+    CellStats getStats();
+};
+
+#endif /* GridEngine_hpp */
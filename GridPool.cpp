@@ -0,0 +1,135 @@
+/*********************************************************************
+ ** Program Filename: GridPool.cpp, GridPool class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Pool of cache line aligned memory blocks for the
+ **   cells of grids, kept for reuse when given back.
+ ** Input: sizes of blocks wanted, blocks given back
+ ** Output: aligned blocks, number of blocks allocated and reused
+ *********************************************************************/
+
+#include "GridPool.hpp"
+#include <cstdlib>
+#include <new>
+#include <stdint.h>
+#include <sys/mman.h>
+
+// constructor, an empty pool
+GridPool::GridPool() {
+    allocations = 0;
+    reuses = 0;
+}
+
+// destructor, free the blocks kept
+GridPool::~GridPool() {
+    for (int c = 0; c < CLASSES; c++) {
+        for (size_t n = 0; n < spare[c].size(); n++) {
+            if ((SMALLEST << c) >= HUGE_PAGE) {
+                munmap(spare[c][n], SMALLEST << c);
+            } else {
+                free(spare[c][n]);
+            }
+        }
+    }
+}
+
+// the pool every grid draws from, made on first use
+GridPool &GridPool::shared() {
+    static GridPool pool;
+    return pool;
+}
+
+// smallest size class holding n bytes: class c holds SMALLEST << c
+int GridPool::sizeClass(size_t n) {
+    int c = 0;
+    while (c < CLASSES - 1 && (SMALLEST << c) < n) {
+        c++;
+    }
+    return c;
+}
+
+// map a block of zero pages aligned to a huge page, mapping a huge page
+// more than asked for and unmapping what lies outside the block
+void *GridPool::mapBlock(size_t n) {
+    void *base = mmap(0, n + HUGE_PAGE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    char *start = static_cast<char *>(base);
+    size_t lead = (HUGE_PAGE - reinterpret_cast<uintptr_t>(start) % HUGE_PAGE)
+                  % HUGE_PAGE;
+    if (lead > 0) {
+        munmap(start, lead);
+    }
+    munmap(start + lead + n, HUGE_PAGE - lead);
+#ifdef MADV_HUGEPAGE
+    madvise(start + lead, n, MADV_HUGEPAGE);
+#endif
+    return start + lead;
+}
+
+
+/*********************************************************************
+ ** Function: acquire
+ ** Description: Get a block of memory for the cells of a grid.
+ ** Parameters: Bytes needed, the size of the block returned and, if
+ **   wanted, where to say whether the block is known to be all zero.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns a block aligned to a cache line (to a huge
+ **   page if it is that large), which may hold old cells: a block
+ **   given back earlier if one of the size is kept, otherwise a new
+ **   one.  Only a new block of a huge page or more is known to be
+ **   zero.  Throws std::bad_alloc if there is no memory.
+ *********************************************************************/
+
+void *GridPool::acquire(size_t n, size_t &capacity, bool *zeroed) {
+    int c = sizeClass(n);
+    capacity = SMALLEST << c;
+    if (zeroed != 0) {
+        *zeroed = false;
+    }
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        if (!spare[c].empty()) {
+            void *block = spare[c].back();
+            spare[c].pop_back();
+            reuses++;
+            return block;
+        }
+        allocations++;
+    }
+    if (capacity >= HUGE_PAGE) {
+        if (zeroed != 0) {
+            *zeroed = true;
+        }
+        return mapBlock(capacity);
+    }
+    void *block;
+    if (posix_memalign(&block, ALIGN, capacity) != 0) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+// give back a block from acquire, with the size it was handed out at,
+// to be handed out again
+void GridPool::release(void *block, size_t capacity) {
+    if (block == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> hold(lock);
+    spare[sizeClass(capacity)].push_back(block);
+}
+
+// number of blocks allocated from the system
+long long GridPool::getAllocations() {
+    std::lock_guard<std::mutex> hold(lock);
+    return allocations;
+}
+
+// number of blocks handed out again instead of being allocated
+long long GridPool::getReuses() {
+    std::lock_guard<std::mutex> hold(lock);
+    return reuses;
+}
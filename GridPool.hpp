@@ -0,0 +1,52 @@
+/*********************************************************************
+ ** Program Filename: GridPool.hpp, GridPool class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Pool of cache line aligned memory blocks for the
+ **   cells of grids.  Blocks come in power of two sizes; a block
+ **   given back is kept for the next grid of its size instead of
+ **   being freed, so boards that are made, resized and dropped over
+ **   and over stop allocating once the pool holds a block of each
+ **   size in use.  Blocks of a huge page or more are mapped from the
+ **   system, aligned to a huge page and offered to it as huge pages;
+ **   a new one is all zero pages, which the system provides only as
+ **   they are first touched, so a huge grid that is mostly dead costs
+ **   little memory.
+ ** Input: sizes of blocks wanted, blocks given back
+ ** Output: aligned blocks, number of blocks allocated and reused
+ *********************************************************************/
+
+#ifndef GridPool_hpp
+#define GridPool_hpp
+
+#include <cstddef>  // header file for size_t
+#include <vector>   // header file for vector objects
+#include <mutex>    // header file for mutual exclusion
+
+class GridPool {
+public:
+    static const size_t ALIGN = 64;         // bytes, a cache line
+    static const size_t SMALLEST = 4096;    // bytes of the smallest block
+    static const size_t HUGE_PAGE = 1 << 21; // bytes of a huge page
+    static const int CLASSES = 48;          // power of two block sizes
+private:
+    std::vector<void *> spare[CLASSES];     // blocks kept, by size
+    std::mutex lock;                        // protects the fields here
+    long long allocations;                  // blocks taken from the system
+    long long reuses;                       // blocks handed out again
+    static int sizeClass(size_t);           // smallest class that fits
+    static void *mapBlock(size_t);          // map a huge page aligned block
+    GridPool();                             // constructor
+    GridPool(const GridPool &);             // not copyable
+    GridPool &operator=(const GridPool &);  // not assignable
+public:
+    ~GridPool();                            // destructor
+    static GridPool &shared();              // pool every grid draws from
+    void *acquire(size_t, size_t &, bool * = 0); // block of at least n
+                                            // bytes, and whether it is zero
+    void release(void *, size_t);           // give a block back
+    long long getAllocations();             // get blocks allocated
+    long long getReuses();                  // get blocks reused
+};
+
+#endif /* GridPool_hpp */
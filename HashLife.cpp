@@ -0,0 +1,528 @@
+/*********************************************************************
+ ** Program Filename: HashLife.cpp, HashLife class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  HashLife simulation engine.  A node of level L is a
+ **   square of 2^L cells on a side; its successor is the center square
+ **   of level L-1, advanced 2^min(stepLog, L-2) generations.
+ ** Input: seed pattern, cell states, number of generations to run
+ ** Output: cell states, generation count, population, display window
+ *********************************************************************/
+
+#include "HashLife.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+
+static const int BLOCK_NODES = 65536;   // nodes allocated at a time
+
+
+/*********************************************************************
+ ** Function: HashLife
+ ** Description: HashLife class constructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: An empty universe is created at generation zero.
+ *********************************************************************/
+
+HashLife::HashLife() {
+    freeList = 0;
+    nodeCount = 0;
+    maxNodes = 1 << 21;
+    table.assign(1 << 16, (Node *)0);
+    dead = newNode();
+    alive = newNode();
+    dead->population = 0;
+    alive->population = 1;
+    empties.push_back(dead);
+    stepLog = 0;
+    clear();
+}
+
+
+/*********************************************************************
+ ** Function: ~HashLife
+ ** Description: HashLife class destructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: All node blocks are deallocated.
+ *********************************************************************/
+
+HashLife::~HashLife() {
+    for (size_t b = 0; b < blocks.size(); b++) {
+        delete [] blocks[b];
+    }
+}
+
+// take a node from the free list, allocating a new block if needed
+HashLife::Node *HashLife::newNode() {
+    if (freeList == 0) {
+        Node *block = new Node[BLOCK_NODES];
+        blocks.push_back(block);
+        for (int i = 0; i < BLOCK_NODES; i++) {
+            block[i].next = freeList;
+            freeList = &block[i];
+        }
+    }
+    Node *n = freeList;
+    freeList = n->next;
+    n->nw = n->ne = n->sw = n->se = 0;
+    n->result = 0;
+    n->next = 0;
+    n->population = 0;
+    n->level = 0;
+    n->mark = false;
+    return n;
+}
+
+// hash of a node's four quadrants
+static inline size_t hashNode(const void *a, const void *b,
+                              const void *c, const void *d) {
+    uint64_t h = (uint64_t)(uintptr_t)a;
+    h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)b;
+    h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)c;
+    h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)d;
+    return static_cast<size_t>(h ^ (h >> 29));
+}
+
+// canonical node with the given quadrants: the existing one if this
+// square has been seen before, otherwise a new node
+HashLife::Node *HashLife::join(Node *nw, Node *ne, Node *sw, Node *se) {
+    size_t h = hashNode(nw, ne, sw, se) & (table.size() - 1);
+    for (Node *n = table[h]; n != 0; n = n->next) {
+        if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se) {
+            return n;
+        }
+    }
+    Node *n = newNode();
+    n->nw = nw;
+    n->ne = ne;
+    n->sw = sw;
+    n->se = se;
+    n->level = nw->level + 1;
+    n->population = nw->population + ne->population +
+                    sw->population + se->population;
+    n->next = table[h];
+    table[h] = n;
+    nodeCount++;
+    if (nodeCount > 2 * table.size()) {
+        rehash(2 * table.size());
+    }
+    return n;
+}
+
+// spread the nodes over a hash table of a new size (a power of two)
+void HashLife::rehash(size_t size) {
+    std::vector<Node *> old(size, (Node *)0);
+    old.swap(table);
+    for (size_t b = 0; b < old.size(); b++) {
+        Node *n = old[b];
+        while (n != 0) {
+            Node *next = n->next;
+            size_t h = hashNode(n->nw, n->ne, n->sw, n->se) & (size - 1);
+            n->next = table[h];
+            table[h] = n;
+            n = next;
+        }
+    }
+}
+
+// canonical empty node of a level
+HashLife::Node *HashLife::empty(int level) {
+    while (static_cast<int>(empties.size()) <= level) {
+        Node *e = empties.back();
+        empties.push_back(join(e, e, e, e));
+    }
+    return empties[level];
+}
+
+// center quarter of a node (one level down)
+HashLife::Node *HashLife::center(Node *n) {
+    return join(n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+}
+
+// cells of the 3x3 block around a cell, numbered (dy+1)*3 + (dx+1),
+// counted as neighbors in each neighborhood
+static const int NEIGHBORS[3] = {
+    0x1EF,  // Moore: all but the cell itself
+    0x0AA,  // von Neumann: north, west, east and south
+    0x1AB   // hexagonal: all but the cell, north-east and south-west
+};
+
+// center 2x2 of a 4x4 node after one generation, cell by cell
+HashLife::Node *HashLife::baseCase(Node *n) {
+    int cell[4][4];
+    Node *quad[2][2] = { { n->nw, n->ne }, { n->sw, n->se } };
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            Node *q = quad[y / 2][x / 2];
+            Node *c = (y % 2 == 0) ? (x % 2 == 0 ? q->nw : q->ne)
+                                   : (x % 2 == 0 ? q->sw : q->se);
+            cell[y][x] = (c == alive);
+        }
+    }
+    Node *next[2][2];
+    for (int y = 1; y <= 2; y++) {
+        for (int x = 1; x <= 2; x++) {
+            int sum = 0;
+            for (int k = 0; k < 9; k++) {
+                if ((NEIGHBORS[rule.getNeighborhood()] >> k) & 1) {
+                    sum += cell[y + k/3 - 1][x + k%3 - 1];
+                }
+            }
+            int counts = cell[y][x] ? rule.getSurvive() : rule.getBirth();
+            bool live = (counts >> sum) & 1;
+            next[y-1][x-1] = live ? alive : dead;
+        }
+    }
+    return join(next[0][0], next[0][1], next[1][0], next[1][1]);
+}
+
+// center of a node of level L advanced 2^min(stepLog, L-2) generations.
+// The node is cut into a 3x3 array of overlapping squares of level L-1;
+// these are either advanced or just trimmed to their centers, then
+// joined four at a time and advanced again.
+HashLife::Node *HashLife::successor(Node *n) {
+    if (n->population == 0) {
+        return empty(n->level - 1);
+    }
+    if (n->result != 0) {
+        return n->result;
+    }
+    if (n->level == 2) {
+        n->result = baseCase(n);
+        return n->result;
+    }
+
+    Node *s[3][3];
+    s[0][0] = n->nw;
+    s[0][1] = join(n->nw->ne, n->ne->nw, n->nw->se, n->ne->sw);
+    s[0][2] = n->ne;
+    s[1][0] = join(n->nw->sw, n->nw->se, n->sw->nw, n->sw->ne);
+    s[1][1] = join(n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+    s[1][2] = join(n->ne->sw, n->ne->se, n->se->nw, n->se->ne);
+    s[2][0] = n->sw;
+    s[2][1] = join(n->sw->ne, n->se->nw, n->sw->se, n->se->sw);
+    s[2][2] = n->se;
+
+    // at full speed both halves of the jump advance; otherwise only the
+    // second half does and the first just takes the centers
+    bool full = stepLog >= n->level - 2;
+    for (int y = 0; y < 3; y++) {
+        for (int x = 0; x < 3; x++) {
+            s[y][x] = full ? successor(s[y][x]) : center(s[y][x]);
+        }
+    }
+    n->result = join(successor(join(s[0][0], s[0][1], s[1][0], s[1][1])),
+                     successor(join(s[0][1], s[0][2], s[1][1], s[1][2])),
+                     successor(join(s[1][0], s[1][1], s[2][0], s[2][1])),
+                     successor(join(s[1][1], s[1][2], s[2][1], s[2][2])));
+    return n->result;
+}
+
+// double the universe, keeping the old root in the middle
+void HashLife::expand() {
+    Node *e = empty(root->level - 1);
+    long long half = 1LL << (root->level - 1);
+    root = join(join(e, e, e, root->nw), join(e, e, root->ne, e),
+                join(e, root->sw, e, e), join(root->se, e, e, e));
+    originX -= half;
+    originY -= half;
+}
+
+// true if every live cell lies in the middle quarter of the universe,
+// far enough from the edge that a full jump cannot reach it
+bool HashLife::centered() {
+    if (root->level < 3) {
+        return false;
+    }
+    Node *inner = join(root->nw->se->se, root->ne->sw->sw,
+                       root->sw->ne->ne, root->se->nw->nw);
+    return inner->population == root->population;
+}
+
+// change the number of generations each successor call advances.
+// Memoized results stay valid only for nodes small enough to have
+// been stepped at full speed under both the old and new settings.
+void HashLife::setStep(int k) {
+    if (k == stepLog) {
+        return;
+    }
+    int keep = std::min(k, stepLog) + 2;
+    for (size_t b = 0; b < table.size(); b++) {
+        for (Node *n = table[b]; n != 0; n = n->next) {
+            if (n->level > keep) {
+                n->result = 0;
+            }
+        }
+    }
+    stepLog = k;
+}
+
+// follow a rule, which must have two states.  Every memoized result
+// was stepped under the old rule, so all are dropped.
+bool HashLife::setRule(const Rule &r) {
+    Rule next = r;
+    if (next.getStates() != 2) {
+        return false;
+    }
+    rule = next;
+    for (size_t b = 0; b < table.size(); b++) {
+        for (Node *n = table[b]; n != 0; n = n->next) {
+            n->result = 0;
+        }
+    }
+    return true;
+}
+
+// mark a node and everything below it as reachable
+void HashLife::markNode(Node *n) {
+    if (n->mark) {
+        return;
+    }
+    n->mark = true;
+    if (n->level > 0) {
+        markNode(n->nw);
+        markNode(n->ne);
+        markNode(n->sw);
+        markNode(n->se);
+    }
+}
+
+// free every node that is not part of the universe or an empty node,
+// dropping memoized results that point at freed nodes
+void HashLife::collect() {
+    markNode(root);
+    for (size_t e = 0; e < empties.size(); e++) {
+        markNode(empties[e]);
+    }
+    for (size_t b = 0; b < table.size(); b++) {
+        Node **link = &table[b];
+        while (*link != 0) {
+            Node *n = *link;
+            if (n->mark) {
+                link = &n->next;
+            } else {
+                *link = n->next;
+                n->next = freeList;
+                freeList = n;
+                nodeCount--;
+            }
+        }
+    }
+    for (size_t b = 0; b < table.size(); b++) {
+        for (Node *n = table[b]; n != 0; n = n->next) {
+            if (n->result != 0 && !n->result->mark) {
+                n->result = 0;
+            }
+        }
+    }
+    for (size_t b = 0; b < table.size(); b++) {
+        for (Node *n = table[b]; n != 0; n = n->next) {
+            n->mark = false;
+        }
+    }
+    alive->mark = false;
+    dead->mark = false;
+
+    // the universe alone may be bigger than the limit
+    if (nodeCount > maxNodes / 2) {
+        maxNodes = 2 * nodeCount;
+    }
+}
+
+// name of the engine
+const char *HashLife::getName() {
+    return "hashlife";
+}
+
+// the universe has no edge
+bool HashLife::isBounded() {
+    return false;
+}
+
+// kill all cells and restart at generation zero
+void HashLife::clear() {
+    root = empty(3);
+    originX = -4;
+    originY = -4;
+    generation = 0;
+}
+
+// copy of a subtree with one cell set, (x, y) relative to its corner
+HashLife::Node *HashLife::setNode(Node *n, long long x, long long y,
+                                  bool s) {
+    if (n->level == 0) {
+        return s ? alive : dead;
+    }
+    long long half = 1LL << (n->level - 1);
+    if (y < half) {
+        if (x < half) {
+            return join(setNode(n->nw, x, y, s), n->ne, n->sw, n->se);
+        }
+        return join(n->nw, setNode(n->ne, x - half, y, s), n->sw, n->se);
+    }
+    if (x < half) {
+        return join(n->nw, n->ne, setNode(n->sw, x, y - half, s), n->se);
+    }
+    return join(n->nw, n->ne, n->sw, setNode(n->se, x - half, y - half, s));
+}
+
+// set a cell, growing the universe to reach it
+void HashLife::setCell(long long x, long long y, bool s) {
+    while (x < originX || y < originY ||
+           x >= originX + (1LL << root->level) ||
+           y >= originY + (1LL << root->level)) {
+        expand();
+    }
+    root = setNode(root, x - originX, y - originY, s);
+
+    // each change leaves the old path behind, so loading a large
+    // pattern cell by cell needs collecting too
+    if (nodeCount > maxNodes) {
+        collect();
+    }
+}
+
+// get a cell; cells outside the universe are dead
+bool HashLife::getCell(long long x, long long y) {
+    x -= originX;
+    y -= originY;
+    if (x < 0 || y < 0 || x >= (1LL << root->level) ||
+        y >= (1LL << root->level)) {
+        return false;
+    }
+    Node *n = root;
+    while (n->level > 0 && n->population > 0) {
+        long long half = 1LL << (n->level - 1);
+        bool east = x >= half, south = y >= half;
+        n = south ? (east ? n->se : n->sw) : (east ? n->ne : n->nw);
+        x -= east ? half : 0;
+        y -= south ? half : 0;
+    }
+    return n == alive;
+}
+
+
+/*********************************************************************
+ ** Function: step
+ ** Description: Advance the universe n generations, in jumps of
+ **   2^k generations for each bit k set in n.
+ ** Parameters: Number of generations.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The universe holds generation getGeneration()+n.
+ **   Unreachable nodes are collected if the cache is over its limit.
+ *********************************************************************/
+
+void HashLife::step(long long n) {
+    for (int k = 0; k < 62 && (n >> k) != 0; k++) {
+        if (((n >> k) & 1) == 0) {
+            continue;
+        }
+        ScopedTimer timer(STEP_TIMER);
+        setStep(k);
+        while (root->level < k + 3 || !centered()) {
+            expand();
+        }
+        long long quarter = 1LL << (root->level - 2);
+        root = successor(root);
+        originX += quarter;
+        originY += quarter;
+        generation += 1LL << k;
+        if (nodeCount > maxNodes) {
+            collect();
+        }
+        timer.stop();
+        Trace::endGeneration(generation);
+    }
+}
+
+// number of generations run since the last clear
+long long HashLife::getGeneration() {
+    return generation;
+}
+
+// set the generation count, keeping the cells
+void HashLife::setGeneration(long long n) {
+    generation = n;
+}
+
+// number of live cells
+long long HashLife::getPopulation() {
+    return static_cast<long long>(root->population);
+}
+
+// set the node count at which unreachable nodes are collected
+void HashLife::setMaxNodes(size_t n) {
+    maxNodes = n;
+}
+
+// number of nodes in the cache
+size_t HashLife::getNodes() {
+    return nodeCount;
+}
+
+// call a function for every live cell of a subtree with corner (x, y)
+void HashLife::visit(Node *n, long long x, long long y, CellFunction fn,
+                     void *context) {
+    if (n->population == 0) {
+        return;
+    }
+    if (n->level == 0) {
+        fn(context, x, y);
+        return;
+    }
+    long long half = 1LL << (n->level - 1);
+    visit(n->nw, x, y, fn, context);
+    visit(n->ne, x + half, y, fn, context);
+    visit(n->sw, x, y + half, fn, context);
+    visit(n->se, x + half, y + half, fn, context);
+}
+
+// call a function with the coordinates of every live cell
+void HashLife::forEachCell(CellFunction fn, void *context) {
+    visit(root, originX, originY, fn, context);
+}
+
+// set the live cells of a subtree with corner (x, y) that fall in the
+// window, skipping empty and off-window subtrees entirely
+void HashLife::fill(Node *n, long long x, long long y, Grid &window,
+                    long long x0, long long y0) {
+    long long size = 1LL << n->level;
+    if (n->population == 0 || x + size <= x0 || y + size <= y0 ||
+        x >= x0 + window.getSizeX() || y >= y0 + window.getSizeY()) {
+        return;
+    }
+    if (n->level == 0) {
+        int h = window.getHide();
+        window.setState(static_cast<int>(h + 1 + x - x0),
+                        static_cast<int>(h + 1 + y - y0), 1);
+        return;
+    }
+    long long half = size / 2;
+    fill(n->nw, x, y, window, x0, y0);
+    fill(n->ne, x + half, y, window, x0, y0);
+    fill(n->sw, x, y + half, window, x0, y0);
+    fill(n->se, x + half, y + half, window, x0, y0);
+}
+
+
+/*********************************************************************
+ ** Function: exportWindow
+ ** Description: Copy a rectangle of the universe into the visible
+ **   portion of a grid, for display.
+ ** Parameters: The grid to fill and the coordinates of the cell shown
+ **   in the top left corner of its visible portion.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The visible cells of the grid hold the universe's
+ **   cells; hidden cells of the grid are left alone.
+ *********************************************************************/
+
+void HashLife::exportWindow(Grid &window, long long x0, long long y0) {
+    int h = window.getHide();
+    for (int j = 0; j < window.getSizeY(); j++) {
+        for (int i = 0; i < window.getSizeX(); i++) {
+            window.setState(h + 1 + i, h + 1 + j, 0);
+        }
+    }
+    fill(root, originX, originY, window, x0, y0);
+}
@@ -0,0 +1,82 @@
+/*********************************************************************
+ ** Program Filename: HashLife.hpp, HashLife class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  HashLife simulation engine.  The universe is an
+ **   unbounded quadtree whose nodes are hash-consed, so identical
+ **   squares anywhere in space or time are stored once, and the
+ **   future of each node's center is memoized.  A run of n
+ **   generations is split into jumps of 2^k generations, each one
+ **   recursion over the tree, so periodic patterns can be advanced
+ **   billions of generations quickly.  The node cache is bounded:
+ **   when it grows past a limit between jumps, nodes not reachable
+ **   from the current universe are garbage collected.
+ ** Input: seed pattern, cell states, number of generations to run
+ ** Output: cell states, generation count, population, display window
+ *********************************************************************/
+
+#ifndef HashLife_hpp
+#define HashLife_hpp
+
+#include <vector>   // header file for vector objects
+#include <stdint.h> // header file for fixed width integer types
+#include "Engine.hpp"
+
+class HashLife : public Engine {
+private:
+    struct Node {
+        Node *nw, *ne, *sw, *se;    // quadrants, null for single cells
+        Node *result;               // memoized center after stepping
+        Node *next;                 // next node in the same hash bucket
+        uint64_t population;        // number of live cells
+        int level;                  // node is 2^level cells on a side
+        bool mark;                  // reached during garbage collection
+    };
+    std::vector<Node *> blocks;     // blocks of allocated nodes
+    Node *freeList;                 // unused nodes
+    std::vector<Node *> table;      // hash buckets of canonical nodes
+    size_t nodeCount;               // nodes in the hash table
+    size_t maxNodes;                // node count that triggers collection
+    std::vector<Node *> empties;    // canonical empty node of each level
+    Node *alive, *dead;             // the two single cell nodes
+    Node *root;                     // the universe
+    long long originX, originY;     // coordinates of root's top left cell
+    int stepLog;                    // successor advances 2^stepLog steps
+    long long generation;           // generations run since last clear
+    Node *newNode();                // take a node from the free list
+    Node *join(Node *, Node *, Node *, Node *); // canonical parent node
+    Node *empty(int);               // canonical empty node of a level
+    Node *center(Node *);           // center quarter of a node
+    Node *successor(Node *);        // center of a node, stepped
+    Node *baseCase(Node *);         // center of a 4x4 node, one step
+    Node *setNode(Node *, long long, long long, bool); // set in subtree
+    void expand();                  // double the universe around root
+    bool centered();                // true if live cells are well inside
+    void setStep(int);              // change generations per successor
+    void rehash(size_t);            // resize the hash table
+    void collect();                 // garbage collect unreachable nodes
+    void markNode(Node *);          // mark a node and its descendants
+    void fill(Node *, long long, long long, Grid &, long long, long long);
+    void visit(Node *, long long, long long, CellFunction, void *);
+    HashLife(const HashLife &);             // not copyable
+    HashLife &operator=(const HashLife &);  // not assignable
+public:
+    HashLife();                     // constructor
+    ~HashLife();                    // destructor
+    const char *getName();
+    bool isBounded();
+    void clear();
+    bool setRule(const Rule &);
+    void setCell(long long, long long, bool);
+    bool getCell(long long, long long);
+    void step(long long);
+    long long getGeneration();
+    void setGeneration(long long);
+    long long getPopulation();
+    void forEachCell(CellFunction, void *);
+    void exportWindow(Grid &, long long, long long);
+    void setMaxNodes(size_t);       // set node cache limit
+    size_t getNodes();              // get number of cached nodes
+};
+
+#endif /* HashLife_hpp */
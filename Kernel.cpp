@@ -0,0 +1,763 @@
+/*********************************************************************
+ ** Program Filename: Kernel.cpp, generation kernel implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Word-parallel kernels that compute the next
+ **   generation of a bit-packed grid.  Every path evaluates the same
+ **   adder network, 64, 128, 256 or 512 cells at a time:  the row
+ **   above and the row below each give a two bit sum of three cells,
+ **   the middle row a two bit sum of its two side cells.  A cell is
+ **   live next time step when exactly one "twos" bit is set (sum 2 or
+ **   3) and either the "ones" bit is set (sum 3) or the cell is live.
+ **   Kernels for other two-state rules are templates, compiled for
+ **   the neighborhood and, for common rules, the birth and survival
+ **   counts, so the comparisons with counts the rule does not name
+ **   are compiled away; any other rule uses a kernel that reads its
+ **   counts at run time.
+ ** Input: rows of bit-packed cells, requested instruction set
+ ** Output: rows of bit-packed cells one time step later, hashes,
+ **   statistics
+ *********************************************************************/
+
+// The rule kernels hand GCC vectors only to functions that are always
+// inlined into kernels built for the vectors' instruction set, so
+// GCC's warnings about how calls built without it pass vectors do not
+// apply.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+#include "Kernel.hpp"
+#include <cstring>  // header file for memcpy
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LIFE_X86 1
+#include <immintrin.h> // header file for SSE2, AVX2 and AVX-512 intrinsics
+#endif
+
+// next state of 64 cells from the words above, at and below them
+static inline uint64_t nextWord(const uint64_t *up, const uint64_t *mid,
+                                const uint64_t *dn, int w) {
+    uint64_t a = up[w], b = mid[w], c = dn[w];
+    uint64_t aL = (a << 1) | (up[w-1] >> 63);
+    uint64_t aR = (a >> 1) | (up[w+1] << 63);
+    uint64_t bL = (b << 1) | (mid[w-1] >> 63);
+    uint64_t bR = (b >> 1) | (mid[w+1] << 63);
+    uint64_t cL = (c << 1) | (dn[w-1] >> 63);
+    uint64_t cR = (c >> 1) | (dn[w+1] << 63);
+    return lifeWord(aL, a, aR, bL, b, bR, cL, c, cR);
+}
+
+// portable kernel, one 64-bit word at a time
+static bool stepScalar(const uint64_t *src, uint64_t *dst,
+                       const uint64_t *mask, int stride,
+                       int j0, int j1, int w0, int w1, int, int) {
+    uint64_t diff = 0;
+    for (int j = j0; j <= j1; j++) {
+        const uint64_t *mid = src + j*stride;
+        uint64_t *out = dst + j*stride;
+        for (int w = w0; w < w1; w++) {
+            out[w] = nextWord(mid - stride, mid, mid + stride, w) & mask[w];
+            diff |= out[w] ^ mid[w];
+        }
+    }
+    return diff != 0;
+}
+
+// load and store a word or a vector of words at any alignment
+template <typename W>
+static inline __attribute__((always_inline)) W loadWords(const uint64_t *p) {
+    W v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+template <typename W>
+static inline __attribute__((always_inline)) void storeWords(uint64_t *p,
+                                                             const W &v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+// kernel for a two-state rule, sizeof(W) / 8 words at a time.  B and S
+// are the birth and survival counts, or -1 to take them from the
+// arguments.
+template <Neighborhood N, int B, int S, typename W>
+static inline __attribute__((always_inline))
+bool stepRuleWords(const uint64_t *src, uint64_t *dst, const uint64_t *mask,
+                   int stride, int j0, int j1, int w0, int w1,
+                   int birth, int survive) {
+    if (B >= 0) {
+        birth = B;
+        survive = S;
+    }
+    const int WORDS = sizeof(W) / sizeof(uint64_t);
+    W diff = loadWords<W>(mask) ^ loadWords<W>(mask);
+    for (int j = j0; j <= j1; j++) {
+        const uint64_t *row[3] = { src + (j-1)*stride, src + j*stride,
+                                   src + (j+1)*stride };
+        uint64_t *out = dst + j*stride;
+        for (int w = w0; w < w1; w += WORDS) {
+            W v[3], vL[3], vR[3];
+            for (int r = 0; r < 3; r++) {
+                const uint64_t *p = row[r] + w;
+                v[r] = loadWords<W>(p);
+                vL[r] = (v[r] << 1) | (loadWords<W>(p-1) >> 63);
+                vR[r] = (v[r] >> 1) | (loadWords<W>(p+1) << 63);
+            }
+            W next = ruleWord<N>(birth, survive, vL[0], v[0], vR[0],
+                                 vL[1], v[1], vR[1], vL[2], v[2], vR[2]) &
+                     loadWords<W>(mask + w);
+            storeWords(out + w, next);
+            diff |= next ^ v[1];
+        }
+    }
+    uint64_t lanes[WORDS];
+    storeWords(lanes, diff);
+    uint64_t any = 0;
+    for (int i = 0; i < WORDS; i++) {
+        any |= lanes[i];
+    }
+    return any != 0;
+}
+
+// portable rule kernel, one 64-bit word at a time
+template <Neighborhood N, int B, int S>
+static bool stepRule(const uint64_t *src, uint64_t *dst,
+                     const uint64_t *mask, int stride,
+                     int j0, int j1, int w0, int w1,
+                     int birth, int survive) {
+    return stepRuleWords<N, B, S, uint64_t>(src, dst, mask, stride,
+                                            j0, j1, w0, w1, birth, survive);
+}
+
+#ifdef LIFE_X86
+
+// GCC vectors of two, four and eight words, compiled to SSE2, AVX2 or
+// AVX-512 instructions inside functions built for those instruction
+// sets
+typedef uint64_t Words2 __attribute__((vector_size(16)));
+typedef uint64_t Words4 __attribute__((vector_size(32)));
+typedef uint64_t Words8 __attribute__((vector_size(64)));
+
+// SSE2 rule kernel, two words at a time
+template <Neighborhood N, int B, int S>
+__attribute__((target("sse2")))
+static bool stepRuleSse2(const uint64_t *src, uint64_t *dst,
+                         const uint64_t *mask, int stride,
+                         int j0, int j1, int w0, int w1,
+                         int birth, int survive) {
+    return stepRuleWords<N, B, S, Words2>(src, dst, mask, stride,
+                                          j0, j1, w0, w1, birth, survive);
+}
+
+// AVX2 rule kernel, four words at a time
+template <Neighborhood N, int B, int S>
+__attribute__((target("avx2")))
+static bool stepRuleAvx2(const uint64_t *src, uint64_t *dst,
+                         const uint64_t *mask, int stride,
+                         int j0, int j1, int w0, int w1,
+                         int birth, int survive) {
+    return stepRuleWords<N, B, S, Words4>(src, dst, mask, stride,
+                                          j0, j1, w0, w1, birth, survive);
+}
+
+// AVX-512 rule kernel, eight words at a time
+template <Neighborhood N, int B, int S>
+__attribute__((target("avx512f")))
+static bool stepRuleAvx512(const uint64_t *src, uint64_t *dst,
+                           const uint64_t *mask, int stride,
+                           int j0, int j1, int w0, int w1,
+                           int birth, int survive) {
+    return stepRuleWords<N, B, S, Words8>(src, dst, mask, stride,
+                                          j0, j1, w0, w1, birth, survive);
+}
+
+#endif /* LIFE_X86 */
+
+// the rule kernel for an instruction set level
+template <Neighborhood N, int B, int S>
+static StepKernel ruleKernel(SimdLevel level) {
+    switch (level) {
+#ifdef LIFE_X86
+        case SIMD_SSE2:
+            return stepRuleSse2<N, B, S>;
+        case SIMD_AVX2:
+            return stepRuleAvx2<N, B, S>;
+        case SIMD_AVX512:
+            return stepRuleAvx512<N, B, S>;
+#endif
+        default:
+            return stepRule<N, B, S>;
+    }
+}
+
+// well known rules with kernels of their own
+static const struct {
+    int birth, survive;                 // neighbor counts as bits
+    StepKernel (*kernel)(SimdLevel);    // kernels compiled for the counts
+} RULE_KERNELS[] = {
+    { 0x048, 0x00C, ruleKernel<MOORE, 0x048, 0x00C> },  // HighLife B36/S23
+    { 0x1C8, 0x1D8, ruleKernel<MOORE, 0x1C8, 0x1D8> },  // Day & Night B3678/S34678
+    { 0x004, 0x000, ruleKernel<MOORE, 0x004, 0x000> },  // Seeds B2/S
+    { 0x008, 0x1FF, ruleKernel<MOORE, 0x008, 0x1FF> },  // Life without Death B3/S012345678
+    { 0x008, 0x03E, ruleKernel<MOORE, 0x008, 0x03E> },  // Maze B3/S12345
+    { 0x048, 0x026, ruleKernel<MOORE, 0x048, 0x026> },  // 2x2 B36/S125
+    { 0x0AA, 0x0AA, ruleKernel<MOORE, 0x0AA, 0x0AA> },  // Replicator B1357/S1357
+    { 0x148, 0x034, ruleKernel<MOORE, 0x148, 0x034> }   // Morley B368/S245
+};
+
+#ifdef LIFE_X86
+
+// SSE2 kernel, two words at a time
+__attribute__((target("sse2")))
+static bool stepSse2(const uint64_t *src, uint64_t *dst,
+                     const uint64_t *mask, int stride,
+                     int j0, int j1, int w0, int w1, int, int) {
+    __m128i diff = _mm_setzero_si128();
+    for (int j = j0; j <= j1; j++) {
+        const uint64_t *row[3] = { src + (j-1)*stride, src + j*stride,
+                                   src + (j+1)*stride };
+        uint64_t *out = dst + j*stride;
+        for (int w = w0; w < w1; w += 2) {
+            __m128i v[3], vL[3], vR[3];
+            for (int r = 0; r < 3; r++) {
+                const uint64_t *p = row[r] + w;
+                v[r] = _mm_loadu_si128((const __m128i *)p);
+                vL[r] = _mm_or_si128(_mm_slli_epi64(v[r], 1),
+                    _mm_srli_epi64(_mm_loadu_si128((const __m128i *)(p-1)), 63));
+                vR[r] = _mm_or_si128(_mm_srli_epi64(v[r], 1),
+                    _mm_slli_epi64(_mm_loadu_si128((const __m128i *)(p+1)), 63));
+            }
+            __m128i t;
+            t = _mm_xor_si128(vL[0], v[0]);
+            __m128i a0 = _mm_xor_si128(t, vR[0]);
+            __m128i a1 = _mm_or_si128(_mm_and_si128(vL[0], v[0]),
+                                      _mm_and_si128(vR[0], t));
+            t = _mm_xor_si128(vL[2], v[2]);
+            __m128i c0 = _mm_xor_si128(t, vR[2]);
+            __m128i c1 = _mm_or_si128(_mm_and_si128(vL[2], v[2]),
+                                      _mm_and_si128(vR[2], t));
+            __m128i m0 = _mm_xor_si128(vL[1], vR[1]);
+            __m128i m1 = _mm_and_si128(vL[1], vR[1]);
+
+            t = _mm_xor_si128(a0, c0);
+            __m128i ones = _mm_xor_si128(t, m0);
+            __m128i k = _mm_or_si128(_mm_and_si128(a0, c0),
+                                     _mm_and_si128(m0, t));
+            __m128i x = _mm_xor_si128(a1, c1);
+            __m128i y = _mm_xor_si128(m1, k);
+            __m128i odd = _mm_xor_si128(x, y);
+            __m128i pair = _mm_or_si128(_mm_or_si128(_mm_and_si128(a1, c1),
+                                                     _mm_and_si128(m1, k)),
+                                        _mm_and_si128(x, y));
+            __m128i next = _mm_andnot_si128(pair,
+                _mm_and_si128(odd, _mm_or_si128(ones, v[1])));
+            next = _mm_and_si128(next,
+                _mm_loadu_si128((const __m128i *)(mask + w)));
+            _mm_storeu_si128((__m128i *)(out + w), next);
+            diff = _mm_or_si128(diff, _mm_xor_si128(next, v[1]));
+        }
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128()))
+        != 0xFFFF;
+}
+
+// AVX2 kernel, four words at a time
+__attribute__((target("avx2")))
+static bool stepAvx2(const uint64_t *src, uint64_t *dst,
+                     const uint64_t *mask, int stride,
+                     int j0, int j1, int w0, int w1, int, int) {
+    __m256i diff = _mm256_setzero_si256();
+    for (int j = j0; j <= j1; j++) {
+        const uint64_t *row[3] = { src + (j-1)*stride, src + j*stride,
+                                   src + (j+1)*stride };
+        uint64_t *out = dst + j*stride;
+        for (int w = w0; w < w1; w += 4) {
+            __m256i v[3], vL[3], vR[3];
+            for (int r = 0; r < 3; r++) {
+                const uint64_t *p = row[r] + w;
+                v[r] = _mm256_loadu_si256((const __m256i *)p);
+                vL[r] = _mm256_or_si256(_mm256_slli_epi64(v[r], 1),
+                    _mm256_srli_epi64(_mm256_loadu_si256((const __m256i *)(p-1)), 63));
+                vR[r] = _mm256_or_si256(_mm256_srli_epi64(v[r], 1),
+                    _mm256_slli_epi64(_mm256_loadu_si256((const __m256i *)(p+1)), 63));
+            }
+            __m256i t;
+            t = _mm256_xor_si256(vL[0], v[0]);
+            __m256i a0 = _mm256_xor_si256(t, vR[0]);
+            __m256i a1 = _mm256_or_si256(_mm256_and_si256(vL[0], v[0]),
+                                         _mm256_and_si256(vR[0], t));
+            t = _mm256_xor_si256(vL[2], v[2]);
+            __m256i c0 = _mm256_xor_si256(t, vR[2]);
+            __m256i c1 = _mm256_or_si256(_mm256_and_si256(vL[2], v[2]),
+                                         _mm256_and_si256(vR[2], t));
+            __m256i m0 = _mm256_xor_si256(vL[1], vR[1]);
+            __m256i m1 = _mm256_and_si256(vL[1], vR[1]);
+
+            t = _mm256_xor_si256(a0, c0);
+            __m256i ones = _mm256_xor_si256(t, m0);
+            __m256i k = _mm256_or_si256(_mm256_and_si256(a0, c0),
+                                        _mm256_and_si256(m0, t));
+            __m256i x = _mm256_xor_si256(a1, c1);
+            __m256i y = _mm256_xor_si256(m1, k);
+            __m256i odd = _mm256_xor_si256(x, y);
+            __m256i pair = _mm256_or_si256(
+                _mm256_or_si256(_mm256_and_si256(a1, c1), _mm256_and_si256(m1, k)),
+                _mm256_and_si256(x, y));
+            __m256i next = _mm256_andnot_si256(pair,
+                _mm256_and_si256(odd, _mm256_or_si256(ones, v[1])));
+            next = _mm256_and_si256(next,
+                _mm256_loadu_si256((const __m256i *)(mask + w)));
+            _mm256_storeu_si256((__m256i *)(out + w), next);
+            diff = _mm256_or_si256(diff, _mm256_xor_si256(next, v[1]));
+        }
+    }
+    return !_mm256_testz_si256(diff, diff);
+}
+
+// AVX-512 kernel, eight words at a time.  Three-input XOR (0x96) and
+// majority (0xE8) are each a single ternary logic instruction.  Some
+// GCC versions warn, wrongly, about the undefined vectors their
+// intrinsics start from when optimizing.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+static bool stepAvx512(const uint64_t *src, uint64_t *dst,
+                       const uint64_t *mask, int stride,
+                       int j0, int j1, int w0, int w1, int, int) {
+    __m512i diff = _mm512_setzero_si512();
+    for (int j = j0; j <= j1; j++) {
+        const uint64_t *row[3] = { src + (j-1)*stride, src + j*stride,
+                                   src + (j+1)*stride };
+        uint64_t *out = dst + j*stride;
+        for (int w = w0; w < w1; w += 8) {
+            __m512i v[3], vL[3], vR[3];
+            for (int r = 0; r < 3; r++) {
+                const uint64_t *p = row[r] + w;
+                v[r] = _mm512_loadu_si512(p);
+                vL[r] = _mm512_or_si512(_mm512_slli_epi64(v[r], 1),
+                    _mm512_srli_epi64(_mm512_loadu_si512(p-1), 63));
+                vR[r] = _mm512_or_si512(_mm512_srli_epi64(v[r], 1),
+                    _mm512_slli_epi64(_mm512_loadu_si512(p+1), 63));
+            }
+            __m512i a0 = _mm512_ternarylogic_epi64(vL[0], v[0], vR[0], 0x96);
+            __m512i a1 = _mm512_ternarylogic_epi64(vL[0], v[0], vR[0], 0xE8);
+            __m512i c0 = _mm512_ternarylogic_epi64(vL[2], v[2], vR[2], 0x96);
+            __m512i c1 = _mm512_ternarylogic_epi64(vL[2], v[2], vR[2], 0xE8);
+            __m512i m0 = _mm512_xor_si512(vL[1], vR[1]);
+            __m512i m1 = _mm512_and_si512(vL[1], vR[1]);
+
+            __m512i ones = _mm512_ternarylogic_epi64(a0, c0, m0, 0x96);
+            __m512i k = _mm512_ternarylogic_epi64(a0, c0, m0, 0xE8);
+            __m512i x = _mm512_xor_si512(a1, c1);
+            __m512i y = _mm512_xor_si512(m1, k);
+            __m512i odd = _mm512_xor_si512(x, y);
+            __m512i pair = _mm512_ternarylogic_epi64(
+                _mm512_and_si512(a1, c1), _mm512_and_si512(m1, k),
+                _mm512_and_si512(x, y), 0xFE);
+            __m512i next = _mm512_andnot_si512(pair,
+                _mm512_and_si512(odd, _mm512_or_si512(ones, v[1])));
+            next = _mm512_and_si512(next, _mm512_loadu_si512(mask + w));
+            _mm512_storeu_si512(out + w, next);
+            diff = _mm512_or_si512(diff, _mm512_xor_si512(next, v[1]));
+        }
+    }
+    return _mm512_test_epi64_mask(diff, diff) != 0;
+}
+#pragma GCC diagnostic pop
+
+#endif /* LIFE_X86 */
+
+// hash of a block of words, sizeof(W) / 8 words at a time
+template <typename W>
+static inline __attribute__((always_inline))
+uint64_t hashWords(const uint64_t *words, int stride,
+                   int j0, int j1, int w0, int w1) {
+    const int WORDS = sizeof(W) / sizeof(uint64_t);
+    uint64_t first[WORDS];
+    for (int i = 0; i < WORDS; i++) {
+        first[i] = i;
+    }
+    W lane = loadWords<W>(first);
+    W hash = lane ^ lane;
+    uint64_t rest = 0;
+    for (int j = j0; j <= j1; j++) {
+        const uint64_t *row = words + static_cast<size_t>(j)*stride;
+        uint64_t place = static_cast<uint64_t>(j)*stride;
+        int w = w0;
+        for (; w + WORDS <= w1; w += WORDS) {
+            hash ^= hashCells<W>(lane + (place + w), loadWords<W>(row + w));
+        }
+        for (; w < w1; w++) {
+            rest ^= hashCells<uint64_t>(place + w, row[w]);
+        }
+    }
+    uint64_t lanes[WORDS];
+    storeWords(lanes, hash);
+    for (int i = 0; i < WORDS; i++) {
+        rest ^= lanes[i];
+    }
+    return rest;
+}
+
+// portable hash kernel
+static uint64_t hashScalar(const uint64_t *words, int stride,
+                           int j0, int j1, int w0, int w1) {
+    return hashWords<uint64_t>(words, stride, j0, j1, w0, w1);
+}
+
+#ifdef LIFE_X86
+
+// SSE2 hash kernel
+__attribute__((target("sse2")))
+static uint64_t hashSse2(const uint64_t *words, int stride,
+                         int j0, int j1, int w0, int w1) {
+    return hashWords<Words2>(words, stride, j0, j1, w0, w1);
+}
+
+// AVX2 hash kernel
+__attribute__((target("avx2")))
+static uint64_t hashAvx2(const uint64_t *words, int stride,
+                         int j0, int j1, int w0, int w1) {
+    return hashWords<Words4>(words, stride, j0, j1, w0, w1);
+}
+
+// AVX-512 hash kernel
+__attribute__((target("avx512f")))
+static uint64_t hashAvx512(const uint64_t *words, int stride,
+                           int j0, int j1, int w0, int w1) {
+    return hashWords<Words8>(words, stride, j0, j1, w0, w1);
+}
+
+#endif /* LIFE_X86 */
+
+// live cells in a word
+static inline __attribute__((always_inline)) uint64_t countLanes(uint64_t w) {
+    return __builtin_popcountll(w);
+}
+
+#ifdef LIFE_X86
+
+// live cells in each word of a vector of eight
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static inline Words8 countLanes(const Words8 &w) {
+    return (Words8) _mm512_popcnt_epi64((__m512i) w);
+}
+
+#endif /* LIFE_X86 */
+
+// statistics of a block of words, sizeof(W) / 8 words at a time, with
+// births and deaths if BEFORE.  The box only needs the first and last
+// live word of each row, which are found a word at a time.
+template <typename W, bool BEFORE>
+static inline __attribute__((always_inline))
+void countWords(const uint64_t *words, const uint64_t *before,
+                const uint64_t *mask, int stride,
+                int j0, int j1, int w0, int w1, CellStats &stats) {
+    const int WORDS = sizeof(W) / sizeof(uint64_t);
+    W zero = loadWords<W>(mask) & 0;
+    W live = zero, born = zero, died = zero;
+    uint64_t rest[3] = { 0, 0, 0 };
+    for (int j = j0; j <= j1; j++) {
+        const uint64_t *row = words + static_cast<size_t>(j)*stride;
+        const uint64_t *old = BEFORE ? before + static_cast<size_t>(j)*stride
+                                     : 0;
+        int w = w0;
+        for (; w + WORDS <= w1; w += WORDS) {
+            W m = loadWords<W>(mask + w);
+            W bits = loadWords<W>(row + w) & m;
+            live += countLanes(bits);
+            if (BEFORE) {
+                W was = loadWords<W>(old + w) & m;
+                born += countLanes(bits & ~was);
+                died += countLanes(was & ~bits);
+            }
+        }
+        for (; w < w1; w++) {
+            uint64_t bits = row[w] & mask[w];
+            rest[0] += countLanes(bits);
+            if (BEFORE) {
+                uint64_t was = old[w] & mask[w];
+                rest[1] += countLanes(bits & ~was);
+                rest[2] += countLanes(was & ~bits);
+            }
+        }
+        int first = w0, last = w1 - 1;
+        while (first < w1 && (row[first] & mask[first]) == 0) {
+            first++;
+        }
+        if (first < w1) {
+            while ((row[last] & mask[last]) == 0) {
+                last--;
+            }
+            stats.addCell(64LL*first + __builtin_ctzll(row[first] & mask[first]),
+                          j);
+            stats.addCell(64LL*last + 63 - __builtin_clzll(row[last] & mask[last]),
+                          j);
+        }
+    }
+    uint64_t lanes[3][WORDS];
+    storeWords(lanes[0], live);
+    storeWords(lanes[1], born);
+    storeWords(lanes[2], died);
+    for (int i = 0; i < WORDS; i++) {
+        rest[0] += lanes[0][i];
+        rest[1] += lanes[1][i];
+        rest[2] += lanes[2][i];
+    }
+    stats.population += rest[0];
+    stats.births += rest[1];
+    stats.deaths += rest[2];
+}
+
+// count kernel, sizeof(W) / 8 words at a time
+template <typename W>
+static inline __attribute__((always_inline))
+void countBlock(const uint64_t *words, const uint64_t *before,
+                const uint64_t *mask, int stride,
+                int j0, int j1, int w0, int w1, CellStats &stats) {
+    if (before != 0) {
+        countWords<W, true>(words, before, mask, stride, j0, j1, w0, w1,
+                            stats);
+    } else {
+        countWords<W, false>(words, before, mask, stride, j0, j1, w0, w1,
+                             stats);
+    }
+}
+
+// portable count kernel
+static void countScalar(const uint64_t *words, const uint64_t *before,
+                        const uint64_t *mask, int stride,
+                        int j0, int j1, int w0, int w1, CellStats &stats) {
+    countBlock<uint64_t>(words, before, mask, stride, j0, j1, w0, w1, stats);
+}
+
+#ifdef LIFE_X86
+
+// count kernel using the population count instruction
+__attribute__((target("popcnt")))
+static void countPopcnt(const uint64_t *words, const uint64_t *before,
+                        const uint64_t *mask, int stride,
+                        int j0, int j1, int w0, int w1, CellStats &stats) {
+    countBlock<uint64_t>(words, before, mask, stride, j0, j1, w0, w1, stats);
+}
+
+// AVX-512 count kernel, for CPUs that count the cells of eight words
+// at once
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt"), flatten))
+static void countAvx512(const uint64_t *words, const uint64_t *before,
+                        const uint64_t *mask, int stride,
+                        int j0, int j1, int w0, int w1, CellStats &stats) {
+    countBlock<Words8>(words, before, mask, stride, j0, j1, w0, w1, stats);
+}
+
+#endif /* LIFE_X86 */
+
+// currently selected kernels, chosen on first use
+static SimdLevel currentLevel = SIMD_AUTO;
+static StepKernel currentKernel = 0;
+static HashKernel currentHash = 0;
+static CountKernel currentCount = 0;
+
+
+/*********************************************************************
+ ** Function: detectSimd
+ ** Description: Determine the widest kernel this CPU can run.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the best supported SimdLevel.
+ *********************************************************************/
+
+SimdLevel detectSimd() {
+#ifdef LIFE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SIMD_SSE2;
+    }
+#endif
+    return SIMD_SCALAR;
+}
+
+
+/*********************************************************************
+ ** Function: setSimdLevel
+ ** Description: Select the kernels used by getStepKernel,
+ **   getHashKernel and getCountKernel.
+ ** Parameters: Requested level; SIMD_AUTO picks the best supported.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false, leaving the selection unchanged,
+ **   if the CPU does not support the requested level.
+ *********************************************************************/
+
+bool setSimdLevel(SimdLevel level) {
+    SimdLevel best = detectSimd();
+    if (level == SIMD_AUTO) {
+        level = best;
+    }
+    if (level > best) {
+        return false;
+    }
+    switch (level) {
+#ifdef LIFE_X86
+        case SIMD_SSE2:
+            currentKernel = stepSse2;
+            currentHash = hashSse2;
+            currentCount = __builtin_cpu_supports("popcnt") ? countPopcnt
+                                                            : countScalar;
+            break;
+        case SIMD_AVX2:
+            currentKernel = stepAvx2;
+            currentHash = hashAvx2;
+            currentCount = countPopcnt;
+            break;
+        case SIMD_AVX512:
+            currentKernel = stepAvx512;
+            currentHash = hashAvx512;
+            currentCount = __builtin_cpu_supports("avx512vpopcntdq")
+                               ? countAvx512 : countPopcnt;
+            break;
+#endif
+        default:
+            level = SIMD_SCALAR;
+            currentKernel = stepScalar;
+            currentHash = hashScalar;
+            currentCount = countScalar;
+            break;
+    }
+    currentLevel = level;
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: getSimdLevel
+ ** Description: Get the level of the selected kernel.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the selected level, selecting the best
+ **   supported kernel if none has been chosen yet.
+ *********************************************************************/
+
+SimdLevel getSimdLevel() {
+    if (currentKernel == 0) {
+        setSimdLevel(SIMD_AUTO);
+    }
+    return currentLevel;
+}
+
+
+/*********************************************************************
+ ** Function: getStepKernel
+ ** Description: Get the selected kernel.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the selected kernel, selecting the best
+ **   supported kernel if none has been chosen yet.
+ *********************************************************************/
+
+StepKernel getStepKernel() {
+    if (currentKernel == 0) {
+        setSimdLevel(SIMD_AUTO);
+    }
+    return currentKernel;
+}
+
+
+/*********************************************************************
+ ** Function: getRuleKernel
+ ** Description: Get the kernel for a two-state rule.
+ ** Parameters: The rule.
+ ** Pre-Conditions: The rule has two states.
+ ** Post-Conditions: Returns the selected Life kernel for Conway's
+ **   Life; otherwise a kernel for the selected instruction set,
+ **   compiled for the rule's counts if there is one, or one that
+ **   reads them from its arguments.
+ *********************************************************************/
+
+StepKernel getRuleKernel(Rule &rule) {
+    if (rule.isLife()) {
+        return getStepKernel();
+    }
+    SimdLevel level = getSimdLevel();
+    switch (rule.getNeighborhood()) {
+        case VON_NEUMANN:
+            return ruleKernel<VON_NEUMANN, -1, -1>(level);
+        case HEXAGONAL:
+            return ruleKernel<HEXAGONAL, -1, -1>(level);
+        default:
+            break;
+    }
+    for (size_t i = 0; i < sizeof(RULE_KERNELS) / sizeof(RULE_KERNELS[0]);
+         i++) {
+        if (RULE_KERNELS[i].birth == rule.getBirth() &&
+            RULE_KERNELS[i].survive == rule.getSurvive()) {
+            return RULE_KERNELS[i].kernel(level);
+        }
+    }
+    return ruleKernel<MOORE, -1, -1>(level);
+}
+
+
+// get the hash kernel for the selected instruction set
+HashKernel getHashKernel() {
+    if (currentHash == 0) {
+        setSimdLevel(SIMD_AUTO);
+    }
+    return currentHash;
+}
+
+// get the count kernel for the selected instruction set
+CountKernel getCountKernel() {
+    if (currentCount == 0) {
+        setSimdLevel(SIMD_AUTO);
+    }
+    return currentCount;
+}
+
+
+/*********************************************************************
+ ** Function: simdName
+ ** Description: Get the printable name of a kernel level.
+ ** Parameters: A kernel level.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the name used by the --simd option.
+ *********************************************************************/
+
+const char *simdName(SimdLevel level) {
+    switch (level) {
+        case SIMD_SCALAR:
+            return "scalar";
+        case SIMD_SSE2:
+            return "sse2";
+        case SIMD_AVX2:
+            return "avx2";
+        case SIMD_AVX512:
+            return "avx512";
+        default:
+            return "auto";
+    }
+}
+
+
+/*********************************************************************
+ ** Function: parseSimd
+ ** Description: Convert a --simd option value to a kernel level.
+ ** Parameters: Option value and the level to store the result in.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false if the name is not recognized.
+ *********************************************************************/
+
+bool parseSimd(const std::string &name, SimdLevel &level) {
+    SimdLevel all[] = { SIMD_AUTO, SIMD_SCALAR, SIMD_SSE2,
+                        SIMD_AVX2, SIMD_AVX512 };
+    for (int i = 0; i < 5; i++) {
+        if (name == simdName(all[i])) {
+            level = all[i];
+            return true;
+        }
+    }
+    return false;
+}
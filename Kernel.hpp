@@ -0,0 +1,154 @@
+/*********************************************************************
+ ** Program Filename: Kernel.hpp, generation kernel specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Word-parallel kernels that compute the next
+ **   generation of a bit-packed grid, with a portable 64-bit path and
+ **   SSE2, AVX2 and AVX-512 paths chosen at startup from the CPU's
+ **   supported instruction sets.  Other two-state rules count
+ **   neighbors into bit planes and pick the counts the rule names;
+ **   common rules get kernels compiled for their counts, the rest
+ **   read the counts from the rule.  Hash kernels hash blocks of
+ **   words the same way at every level, for spotting repeated boards,
+ **   and count kernels gather the statistics of a block, with the
+ **   CPU's population count instruction where it has one.
+ ** Input: rows of bit-packed cells, rule, requested instruction set
+ ** Output: rows of bit-packed cells one time step later, hashes,
+ **   statistics
+ *********************************************************************/
+
+#ifndef Kernel_hpp
+#define Kernel_hpp
+
+#include <string>   // header file for string objects
+#include <stdint.h> // header file for fixed width integer types
+#include "Rule.hpp"
+#include "Grid.hpp"
+
+enum SimdLevel { SIMD_AUTO, SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 };
+
+// advance rows j0..j1 and words w0..w1-1 of a grid with the given row
+// stride from src into dst, keeping only the cells set in mask.  Rows
+// j0-1 and j1+1 and the words either side of each row must be readable.
+// birth and survive are the rule's counts (see Rule), ignored by
+// kernels written for one rule.  Returns true if any cell in the block
+// changed state.
+typedef bool (*StepKernel)(const uint64_t *src, uint64_t *dst,
+                           const uint64_t *mask, int stride,
+                           int j0, int j1, int w0, int w1,
+                           int birth, int survive);
+
+// next state of 64 cells in word b, given the words above (a) and
+// below (c) and each of the three shifted one cell left (L) and right
+// (R) so that bit k of every input lines up with the cell in bit k
+static inline uint64_t lifeWord(uint64_t aL, uint64_t a, uint64_t aR,
+                                uint64_t bL, uint64_t b, uint64_t bR,
+                                uint64_t cL, uint64_t c, uint64_t cR) {
+    uint64_t a0 = aL ^ a ^ aR, a1 = (aL & a) | (aR & (aL ^ a));
+    uint64_t c0 = cL ^ c ^ cR, c1 = (cL & c) | (cR & (cL ^ c));
+    uint64_t m0 = bL ^ bR,     m1 = bL & bR;
+
+    uint64_t ones = a0 ^ c0 ^ m0;
+    uint64_t k = (a0 & c0) | (m0 & (a0 ^ c0));
+    uint64_t odd = a1 ^ c1 ^ m1 ^ k;
+    uint64_t pair = (a1 & c1) | (m1 & k) | ((a1 ^ c1) & (m1 ^ k));
+    return odd & ~pair & (ones | b);
+}
+
+// next state of the cells in word b under a two-state rule: the
+// neighbors of each cell are added into four bit planes s0..s3 of a
+// count, which is compared with each count the rule names.  Inputs
+// are as for lifeWord; L is the cell to the west, R to the east.  W is
+// a 64-bit word or a GCC vector of them, for the SIMD rule kernels.
+template <Neighborhood N, typename W>
+static inline __attribute__((always_inline))
+W ruleWord(int birth, int survive, const W &aL, const W &a, const W &aR,
+           const W &bL, const W &b, const W &bR,
+           const W &cL, const W &c, const W &cR) {
+    W s0, s1, s2, s3;
+    if (N == VON_NEUMANN) {
+        W p0 = a ^ c, p1 = a & c;
+        W q0 = bL ^ bR, q1 = bL & bR;
+        W k = p0 & q0;
+        s0 = p0 ^ q0;
+        s1 = p1 ^ q1 ^ k;
+        s2 = (p1 & q1) | (k & (p1 ^ q1));
+        s3 = s2 ^ s2;
+    } else {
+        // the hexagonal neighborhood leaves out north-east (aR) and
+        // south-west (cL)
+        W a0, a1, c0, c1;
+        if (N == HEXAGONAL) {
+            a0 = aL ^ a;
+            a1 = aL & a;
+            c0 = c ^ cR;
+            c1 = c & cR;
+        } else {
+            a0 = aL ^ a ^ aR;
+            a1 = (aL & a) | (aR & (aL ^ a));
+            c0 = cL ^ c ^ cR;
+            c1 = (cL & c) | (cR & (cL ^ c));
+        }
+        W m0 = bL ^ bR, m1 = bL & bR;
+        W k = (a0 & c0) | (m0 & (a0 ^ c0));
+        W x0 = a1 ^ c1 ^ m1, x1 = (a1 & c1) | (m1 & (a1 ^ c1));
+        s0 = a0 ^ c0 ^ m0;
+        s1 = x0 ^ k;
+        s2 = x1 ^ (x0 & k);
+        s3 = x1 & x0 & k;
+    }
+    W born = b ^ b, kept = b ^ b;
+    for (int n = 0; n <= 8; n++) {
+        if (((birth | survive) >> n) & 1) {
+            W count = (n & 1 ? s0 : ~s0) & (n & 2 ? s1 : ~s1) &
+                      (n & 4 ? s2 : ~s2) & (n & 8 ? s3 : ~s3);
+            if ((birth >> n) & 1) {
+                born |= count;
+            }
+            if ((survive >> n) & 1) {
+                kept |= count;
+            }
+        }
+    }
+    return (born & ~b) | (kept & b);
+}
+
+// hash of 64 cells (the bits of a word) at a position on the board,
+// or of a vector of words at a vector of positions.  A board's hash is
+// the XOR of the hashes of its words, dead words adding nothing, so it
+// can be updated a word or a tile at a time.
+template <typename W>
+static inline __attribute__((always_inline))
+W hashCells(const W &position, const W &bits) {
+    W z = bits ^ (position * 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 32)) * 0xBF58476D1CE4E5B9ULL;  // high cells reach all bits
+    W live = (bits | (0 - bits)) >> 63;
+    return (z ^ (z >> 32)) & (0 - live);
+}
+
+// hash rows j0..j1 and words w0..w1-1 of a grid with the given row
+// stride: the XOR of hashCells(j*stride + w, word) over the block
+typedef uint64_t (*HashKernel)(const uint64_t *words, int stride,
+                               int j0, int j1, int w0, int w1);
+
+// add the statistics of rows j0..j1 and words w0..w1-1 of a grid with
+// the given row stride, keeping only the cells set in mask, to stats:
+// the live cells, the box around them, with cell k of word w in row j
+// at (64*w + k, j), and, unless before is null, the births and deaths
+// since the same block of before
+typedef void (*CountKernel)(const uint64_t *words, const uint64_t *before,
+                            const uint64_t *mask, int stride,
+                            int j0, int j1, int w0, int w1,
+                            CellStats &stats);
+
+SimdLevel detectSimd();                 // best level this CPU supports
+bool setSimdLevel(SimdLevel);           // select kernel, false if unsupported
+SimdLevel getSimdLevel();               // currently selected level
+StepKernel getStepKernel();             // currently selected kernel
+StepKernel getRuleKernel(Rule &);       // selected kernel for a rule
+HashKernel getHashKernel();             // selected block hash kernel
+CountKernel getCountKernel();           // selected block count kernel
+const char *simdName(SimdLevel);        // printable name of a level
+bool parseSimd(const std::string &, SimdLevel &); // name to level
+
+#endif /* Kernel_hpp */
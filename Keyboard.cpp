@@ -0,0 +1,96 @@
+/*********************************************************************
+ ** Program Filename: Keyboard.cpp, Keyboard class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Reads single key presses from the terminal while a
+ **   simulation runs.
+ ** Input: key presses
+ ** Output: keys, one at a time
+ *********************************************************************/
+
+#include "Keyboard.hpp"
+#include <csignal>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+static struct termios saved;    // terminal settings to put back
+static bool savedValid = false; // true while the settings are changed
+
+
+/*********************************************************************
+ ** Function:  Keyboard
+ ** Description:  Keyboard class constructor
+ ** Parameters: none
+ ** Pre-Conditions: Only one Keyboard exists at a time.
+ ** Post-Conditions:  If standard input is a terminal, it delivers each
+ **   key as it is pressed, without echoing it, and the old settings
+ **   are put back if SIGINT or SIGTERM ends the program.  Otherwise
+ **   the keyboard is inactive.
+ *********************************************************************/
+
+Keyboard::Keyboard() {
+    active = false;
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &saved) != 0) {
+        return;
+    }
+    struct termios raw = saved;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    savedValid = true;
+    signal(SIGINT, restore);
+    signal(SIGTERM, restore);
+    active = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+}
+
+// destructor, put the terminal settings back
+Keyboard::~Keyboard() {
+    if (savedValid) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+        savedValid = false;
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+    }
+}
+
+// put the terminal settings back and end the program as the signal
+// would have
+void Keyboard::restore(int sig) {
+    if (savedValid) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    }
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+// true if keys are read from a terminal
+bool Keyboard::isActive() {
+    return active;
+}
+
+
+/*********************************************************************
+ ** Function: read
+ ** Description: Get the next key pressed.
+ ** Parameters: Milliseconds to wait for one.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the key as an unsigned character, or NONE
+ **   if none was pressed in time.  An inactive keyboard just waits.
+ *********************************************************************/
+
+int Keyboard::read(int ms) {
+    if (!active) {
+        usleep(ms * 1000);
+        return NONE;
+    }
+    struct pollfd in;
+    in.fd = STDIN_FILENO;
+    in.events = POLLIN;
+    in.revents = 0;
+    unsigned char c;
+    if (poll(&in, 1, ms) > 0 && ::read(STDIN_FILENO, &c, 1) == 1) {
+        return c;
+    }
+    return NONE;
+}
@@ -0,0 +1,33 @@
+/*********************************************************************
+ ** Program Filename: Keyboard.hpp, Keyboard class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Reads single key presses from the terminal while a
+ **   simulation runs.  While a Keyboard exists, a terminal on standard
+ **   input is switched out of line mode and echo, so keys arrive as
+ **   they are pressed; the settings are put back when it is destroyed,
+ **   or if the program is interrupted or terminated first.  When
+ **   standard input is not a terminal nothing is read from it, so
+ **   piped answers to the menus are left alone.
+ ** Input: key presses
+ ** Output: keys, one at a time
+ *********************************************************************/
+
+#ifndef Keyboard_hpp
+#define Keyboard_hpp
+
+class Keyboard {
+private:
+    bool active;            // true if keys are read from a terminal
+    static void restore(int);   // put the terminal back on a signal
+    Keyboard(const Keyboard &);             // not copyable
+    Keyboard &operator=(const Keyboard &);  // not assignable
+public:
+    static const int NONE = -1; // no key was pressed
+    Keyboard();             // constructor
+    ~Keyboard();            // destructor
+    bool isActive();        // true if keys can be pressed
+    int read(int);          // next key, waiting up to some milliseconds
+};
+
+#endif /* Keyboard_hpp */
@@ -0,0 +1,237 @@
+/*********************************************************************
+ ** Program Filename: Life.cpp, Life class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Embeddable Game of Life board, the interface of the
+ **   liblife library.
+ ** Input: engine and board dimensions, rule, edges, patterns as text
+ **   in memory, cells, number of generations
+ ** Output: cell states, regions of cells, generation count,
+ **   population, statistics, hash, description of any error
+ *********************************************************************/
+
+#include "Life.hpp"
+#include "Soup.hpp"
+
+
+/*********************************************************************
+ ** Function:  Life
+ ** Description:  Life class constructor
+ ** Parameters: Engine to simulate with, visible cells across and down
+ **   of a bounded board, and threads (or, for the domain engine,
+ **   processes) stepping it.
+ ** Pre-Conditions: The dimensions are positive.
+ ** Post-Conditions:  The engine is created with every cell dead, on a
+ **   plane under Conway's Life.  Throws std::bad_alloc if it cannot be.
+ *********************************************************************/
+
+Life::Life(Backend b, int ncol, int nrow, int nthreads) : window(1, 1) {
+    engine = Engine::create(b, ncol, nrow, nthreads);
+    hide = window.getHide();
+    cols = ncol;
+    rows = nrow;
+}
+
+// destructor, deallocate the engine
+Life::~Life() {
+    delete engine;
+}
+
+// the engine behind the board, for drawing it or watching it for cycles;
+// its cells are addressed with grid indices, hidden cells included
+Engine &Life::getEngine() {
+    return *engine;
+}
+
+// name of the engine
+const char *Life::getName() {
+    return engine->getName();
+}
+
+// true if the board has edges, false if it is unbounded
+bool Life::isBounded() {
+    return engine->isBounded();
+}
+
+// visible cells across
+int Life::getSizeX() {
+    return cols;
+}
+
+// visible cells down
+int Life::getSizeY() {
+    return rows;
+}
+
+// choose the rule by name, in B/S or S/B notation; false, with the
+// reason in getError, if it cannot be read or the engine cannot run it
+bool Life::setRule(const std::string &name) {
+    Rule rule;
+    if (!rule.parse(name)) {
+        error = rule.getError();
+        return false;
+    }
+    return setRule(rule);
+}
+
+// choose the rule; false, with the reason in getError, if the engine
+// cannot run it
+bool Life::setRule(const Rule &rule) {
+    if (!engine->setRule(rule)) {
+        error = std::string("The ") + engine->getName() +
+                " engine cannot run " + Rule(rule).getName();
+        return false;
+    }
+    return true;
+}
+
+// rule the cells follow
+Rule Life::getRule() {
+    return engine->getRule();
+}
+
+// choose the edges; false, with the reason in getError, if the engine
+// has none
+bool Life::setBoundary(Boundary b) {
+    if (!engine->setBoundary(b)) {
+        error = std::string("The ") + engine->getName() + " engine has no edges";
+        return false;
+    }
+    return true;
+}
+
+// step k generations per pass over memory; false, with the reason in
+// getError, if the engine steps one at a time
+bool Life::setBlock(int k) {
+    if (!engine->setBlock(k)) {
+        error = std::string("The ") + engine->getName() +
+                " engine steps one generation per pass";
+        return false;
+    }
+    return true;
+}
+
+// kill all cells and count generations from 0 again
+void Life::clear() {
+    engine->clear();
+}
+
+
+/*********************************************************************
+ ** Function: loadPattern
+ ** Description: Read a pattern from text in memory and add its cells
+ **   to the board.
+ ** Parameters: The text, its length in bytes, and the board
+ **   coordinates to center the pattern on.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The pattern's live (and dying) cells are set; the
+ **   other cells are left alone, and any rule the text names is not
+ **   applied.  Returns false, with the reason in getError and the board
+ **   unchanged, if the text is not an RLE, Life 1.05, Life 1.06 or
+ **   plaintext pattern with live cells.
+ *********************************************************************/
+
+bool Life::loadPattern(const char *text, size_t n, long long x,
+                       long long y) {
+    Seed seed;
+    if (!seed.readText(text, n)) {
+        error = seed.getError();
+        return false;
+    }
+    loadPattern(seed, x, y);
+    return true;
+}
+
+// add the cells of a pattern already read, centered on board
+// coordinates x, y
+void Life::loadPattern(Seed &seed, long long x, long long y) {
+    engine->loadSeed(seed, x + hide, y + hide);
+}
+
+// fill the rectangle of w x h cells with top left corner at board
+// coordinates x, y with soup number 0 of a random number seed, each
+// cell live with chance fill; the soup is the same on every engine
+void Life::loadSoup(uint64_t seed, double fill, long long x, long long y,
+                    long long w, long long h) {
+    engine->loadSoup(Soup(seed, fill), x + hide, y + hide, w, h);
+}
+
+// set a cell at board coordinates; cells off a bounded board are
+// wrapped onto it or dropped, as its edges say
+void Life::setCell(long long x, long long y, bool s) {
+    engine->setCell(x + hide, y + hide, s);
+}
+
+// true if the cell at board coordinates is live
+bool Life::getCell(long long x, long long y) {
+    return engine->getCell(x + hide, y + hide);
+}
+
+
+/*********************************************************************
+ ** Function: getRegion
+ ** Description: Read a rectangle of cells.
+ ** Parameters: Board coordinates of its top left cell, its width and
+ **   height, and where to put the cells.
+ ** Pre-Conditions: The buffer holds width x height bytes.
+ ** Post-Conditions: The buffer holds the rectangle row by row, 1 for a
+ **   live cell and 0 otherwise.  Returns the number of live cells in
+ **   it.  The cells are read the way the engine draws its screen, so
+ **   no engine visits them one at a time.
+ *********************************************************************/
+
+long long Life::getRegion(long long x, long long y, int w, int h,
+                          unsigned char *cells) {
+    if (w < 1 || h < 1) {
+        return 0;
+    }
+    window.resize(w, h);
+    engine->exportWindow(window, x + hide, y + hide);
+    long long n = 0;
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            bool live = window.getState(hide + 1 + i, hide + 1 + j);
+            cells[static_cast<size_t>(j)*w + i] = live;
+            n += live;
+        }
+    }
+    return n;
+}
+
+// run n generations
+void Life::step(long long n) {
+    engine->step(n);
+}
+
+// generations run since the board was cleared
+long long Life::getGeneration() {
+    return engine->getGeneration();
+}
+
+// number of live cells
+long long Life::getPopulation() {
+    return engine->getPopulation();
+}
+
+// population, births and deaths of the last generation, and the box
+// around the cells in board coordinates
+CellStats Life::getStats() {
+    CellStats stats = engine->getStats();
+    if (!stats.isEmpty()) {
+        stats.minX -= hide;
+        stats.maxX -= hide;
+        stats.minY -= hide;
+        stats.maxY -= hide;
+    }
+    return stats;
+}
+
+// hash of the live cells, equal for equal boards on the same engine
+uint64_t Life::getHash() {
+    return engine->getHash();
+}
+
+// why the last call that failed did
+std::string Life::getError() {
+    return error;
+}
@@ -0,0 +1,68 @@
+/*********************************************************************
+ ** Program Filename: Life.hpp, Life class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Embeddable Game of Life board, the interface of the
+ **   liblife library.  A board wraps one of the simulation engines
+ **   and addresses cells in board coordinates, which count from 1 at
+ **   the top left visible cell, as the seed locations of the program
+ **   do; an unbounded board extends past them in every direction.
+ **   Nothing here reads or writes a terminal or file, or sleeps, so
+ **   a board can be stepped in the hot loop of another program.
+ ** Input: engine and board dimensions, rule, edges, patterns as text
+ **   in memory, random soups, cells, number of generations
+ ** Output: cell states, regions of cells, generation count,
+ **   population, statistics, hash, description of any error
+ *********************************************************************/
+
+#ifndef Life_hpp
+#define Life_hpp
+
+#include <string>   // header file for string objects
+#include <cstddef>  // header file for size_t
+#include <stdint.h> // header file for fixed width integer types
+#include "Grid.hpp"
+#include "Seed.hpp"
+#include "Rule.hpp"
+#include "Engine.hpp"
+
+class Life {
+private:
+    Engine *engine;         // engine running the simulation
+    int hide;               // hidden cells before the first visible one
+    int cols, rows;         // visible cells of a bounded board
+    Grid window;            // cells of the last region read
+    std::string error;      // why the last call that failed did
+    Life(const Life &);             // not copyable
+    Life &operator=(const Life &);  // not assignable
+public:
+    Life(Backend = PACKED_BACKEND, int = 40, int = 20, int = 1); // constructor
+    ~Life();                        // destructor
+    Engine &getEngine();            // engine, for drawing and watching
+    const char *getName();          // name of the engine
+    bool isBounded();               // true if the board has edges
+    int getSizeX();                 // visible cells across
+    int getSizeY();                 // visible cells down
+    bool setRule(const std::string &); // choose the rule by name
+    bool setRule(const Rule &);     // choose the rule
+    Rule getRule();                 // rule the cells follow
+    bool setBoundary(Boundary);     // choose the edges
+    bool setBlock(int);             // generations per pass over memory
+    void clear();                   // kill all cells, back to generation 0
+    bool loadPattern(const char *, size_t, long long, long long); // from text
+    void loadPattern(Seed &, long long, long long); // add a read pattern
+    void loadSoup(uint64_t, double, long long, long long, long long,
+                  long long);       // fill a rectangle with a soup
+    void setCell(long long, long long, bool);   // set a cell
+    bool getCell(long long, long long);         // get a cell
+    long long getRegion(long long, long long, int, int,
+                        unsigned char *);       // read a rectangle
+    void step(long long);           // run n generations
+    long long getGeneration();      // generations run
+    long long getPopulation();      // live cells
+    CellStats getStats();           // population, births, deaths and box
+    uint64_t getHash();             // hash of the cells
+    std::string getError();         // why the last call failed
+};
+
+#endif /* Life_hpp */
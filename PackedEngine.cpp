@@ -0,0 +1,220 @@
+/*********************************************************************
+ ** Program Filename: PackedEngine.cpp, PackedEngine class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Simulation engine that steps a pair of bit-packed
+ **   grids with the word-parallel kernels, tiled on a thread pool.
+ ** Input: grid dimensions, number of threads, seed pattern, number
+ **   of generations
+ ** Output: cell states, generation count, population
+ *********************************************************************/
+
+#include "PackedEngine.hpp"
+#include "Snapshot.hpp"
+#include "Soup.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <sys/mman.h>
+
+// constructor (ncol x nrow visible grid stepped by nthreads threads)
+PackedEngine::PackedEngine(int ncol, int nrow, int nthreads)
+    : oddGrid(ncol, nrow), evenGrid(ncol, nrow), pool(nthreads) {
+    start = 0;
+    tick = 0;
+    swapped = false;
+    block = 1;
+}
+
+// name of the engine
+const char *PackedEngine::getName() {
+    return "packed";
+}
+
+// grid holding the current time step
+PackedGrid *PackedEngine::current() {
+    return (tick % 2 == 0) != swapped ? &evenGrid : &oddGrid;
+}
+
+// true if a cell index lies on the cells stepped, which on the plane
+// leaves out only the outer ring of the grid; on a torus or Klein
+// bottle the index is wrapped onto the visible cells first
+bool PackedEngine::inside(long long &x, long long &y) {
+    if (boundary != PLANE_BOUNDARY) {
+        return placeCell(x, y, evenGrid.getEdge(), evenGrid.getSizeX(),
+                         evenGrid.getSizeY());
+    }
+    int edge = evenGrid.getEdge();
+    return x >= edge && y >= edge &&
+           x < evenGrid.getSizeX() + 2*(evenGrid.getHide()+1) - edge &&
+           y < evenGrid.getSizeY() + 2*(evenGrid.getHide()+1) - edge;
+}
+
+// choose the edges of the grid, killing any cells outside the visible
+// ones unless it is the plane
+bool PackedEngine::setBoundary(Boundary b) {
+    boundary = b;
+    evenGrid.setBoundary(b);
+    oddGrid.setBoundary(b);
+    return true;
+}
+
+// kill all cells and restart at time step zero
+void PackedEngine::clear() {
+    start = 0;
+    tick = 0;
+    swapped = false;
+    evenGrid.clearGrid();
+    oddGrid.clearGrid();
+}
+
+// follow a rule; the kernels run only two-state rules
+bool PackedEngine::setRule(const Rule &r) {
+    if (!evenGrid.setRule(r) || !oddGrid.setRule(r)) {
+        return false;
+    }
+    rule = r;
+    return true;
+}
+
+// set a cell of the current time step; cells off the grid are ignored
+void PackedEngine::setCell(long long x, long long y, bool s) {
+    if (inside(x, y)) {
+        current()->setState(static_cast<int>(x), static_cast<int>(y), s);
+    }
+}
+
+// fill a rectangle with a soup, a word of cells at a time, rows shared
+// among the threads, when it lies within the stepped cells; one at a
+// time, wrapping or clipping as setCell does, when it does not
+void PackedEngine::loadSoup(const Soup &soup, long long x, long long y,
+                            long long w, long long h) {
+    int edge = evenGrid.getEdge();
+    long long nx = evenGrid.getSizeX() + 2*(evenGrid.getHide()+1);
+    long long ny = evenGrid.getSizeY() + 2*(evenGrid.getHide()+1);
+    if (x < edge || y < edge || x + w > nx - edge || y + h > ny - edge) {
+        Engine::loadSoup(soup, x, y, w, h);
+        return;
+    }
+    ScopedTimer timer(SEED_TIMER);
+    current()->fillSoup(soup, static_cast<int>(x), static_cast<int>(y),
+                        static_cast<int>(w), static_cast<int>(h), pool);
+}
+
+// get a cell of the current time step; cells off the grid are dead
+bool PackedEngine::getCell(long long x, long long y) {
+    if (!inside(x, y)) {
+        return false;
+    }
+    return current()->getState(static_cast<int>(x), static_cast<int>(y));
+}
+
+// step k generations per pass over the grid (see calcBlock), for runs
+// of at least k generations on a plane or dead edges
+bool PackedEngine::setBlock(int k) {
+    if (k < 1) {
+        return false;
+    }
+    block = k;
+    return true;
+}
+
+// advance n time steps, k at a time if blocking
+void PackedEngine::step(long long n) {
+    for (long long t = 0; t < n; ) {
+        PackedGrid *now = current();
+        PackedGrid &next = now == &evenGrid ? oddGrid : evenGrid;
+        int k = 1;
+        if (block > 1 && n - t > 1) {
+            k = now->calcBlock(next, static_cast<int>(
+                                   std::min<long long>(block, n - t)), pool);
+        } else {
+            now->calcNext(next, pool);
+        }
+        swapped = swapped != (k % 2 == 0);
+        tick += k;
+        t += k;
+        Trace::endGeneration(getGeneration());
+    }
+}
+
+// number of time steps run since the last clear
+long long PackedEngine::getGeneration() {
+    return start + tick;
+}
+
+// set the generation count, keeping the cells
+void PackedEngine::setGeneration(long long n) {
+    start = n - tick;
+}
+
+// number of live cells
+long long PackedEngine::getPopulation() {
+    return current()->countLive();
+}
+
+// hash of the cells, kept up to date tile by tile as the grids step
+uint64_t PackedEngine::getHash() {
+    return current()->getHash();
+}
+
+// the grids update their hashes as they step
+bool PackedEngine::tracksHash() {
+    return true;
+}
+
+// statistics of the cells, kept up to date tile by tile as the grids
+// step once asked for
+CellStats PackedEngine::getStats() {
+    return current()->getStats();
+}
+
+// call a function with the coordinates of every live cell, skipping
+// empty words
+void PackedEngine::forEachCell(CellFunction fn, void *context) {
+    PackedGrid *now = current();
+    for (int j = 0; j < now->getRows(); j++) {
+        const uint64_t *row = now->getRow(j);
+        for (int w = 0; w < now->getStride(); w++) {
+            for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+                fn(context, 64LL*w + __builtin_ctzll(bits), j);
+            }
+        }
+    }
+}
+
+// copy the whole bit-packed grid to a snapshot
+void PackedEngine::saveState(Snapshot &snapshot) {
+    PackedGrid *now = current();
+    snapshot.setDense(now->getSizeX(), now->getSizeY(), now->getHide(),
+                      now->getStride(), now->getRows(), now->getBuffer(),
+                      now->getBufferWords(), getGeneration());
+    snapshot.setRule(rule.getName());
+    snapshot.setBoundary(boundary);
+}
+
+// replace the cells with a snapshot's.  A dense grid read from a file,
+// with the same edges, becomes the current grid as it is, its pages
+// read from the file as they are used, and the grids take its
+// dimensions; anything else is loaded a cell at a time.
+bool PackedEngine::loadState(Snapshot &snapshot) {
+    void *base;
+    size_t length;
+    size_t count = snapshot.getWordCount();
+    uint64_t *data;
+    if (snapshot.getKind() != Snapshot::DENSE ||
+        snapshot.getHide() != evenGrid.getHide() ||
+        snapshot.getBoundary() != boundary ||
+        (data = snapshot.takeMapping(base, length)) == 0) {
+        return Engine::loadState(snapshot);
+    }
+    if (!evenGrid.adopt(snapshot.getSizeX(), snapshot.getSizeY(), base,
+                        length, data, count)) {
+        munmap(base, length);
+        return false;
+    }
+    oddGrid.resize(snapshot.getSizeX(), snapshot.getSizeY());
+    tick = 0;
+    swapped = false;
+    start = snapshot.getGeneration();
+    return true;
+}
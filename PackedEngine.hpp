@@ -0,0 +1,52 @@
+/*********************************************************************
+ ** Program Filename: PackedEngine.hpp, PackedEngine class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Simulation engine that steps a pair of bit-packed
+ **   grids with the word-parallel kernels, tiled on a thread pool.
+ ** Input: grid dimensions, number of threads, seed pattern, number
+ **   of generations
+ ** Output: cell states, generation count, population
+ *********************************************************************/
+
+#ifndef PackedEngine_hpp
+#define PackedEngine_hpp
+
+#include "Engine.hpp"
+#include "PackedGrid.hpp"
+#include "ThreadPool.hpp"
+
+class PackedEngine : public Engine {
+private:
+    PackedGrid oddGrid, evenGrid;   // grids for odd and even time steps
+    ThreadPool pool;                // worker threads
+    long long start;        // generation of time step zero
+    long long tick;                 // current time step
+    bool swapped;                   // grids trade roles after an even
+                                    // number of blocked time steps
+    int block;                      // time steps per blocked pass
+    PackedGrid *current();          // grid holding the current time step
+    bool inside(long long &, long long &); // true if a cell is on the grid
+public:
+    PackedEngine(int,int,int);      // constructor
+    const char *getName();
+    void clear();
+    bool setRule(const Rule &);
+    bool setBoundary(Boundary);
+    bool setBlock(int);
+    void setCell(long long, long long, bool);
+    void loadSoup(const Soup &, long long, long long, long long, long long);
+    bool getCell(long long, long long);
+    void step(long long);
+    long long getGeneration();
+    void setGeneration(long long);
+    long long getPopulation();
+    void forEachCell(CellFunction, void *);
+    uint64_t getHash();
+    bool tracksHash();
+    CellStats getStats();
+    void saveState(Snapshot &);
+    bool loadState(Snapshot &);
+};
+
+#endif /* PackedEngine_hpp */
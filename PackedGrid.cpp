@@ -0,0 +1,975 @@
+/*********************************************************************
+ ** Program Filename: PackedGrid.cpp, PackedGrid class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Bit-packed game grid for the Game of Life.  Bit k of
+ **   word w in row j holds cell (64*w + k, j).
+ ** Input: dimensions of grid and state of each grid cell
+ ** Output:  Grid parameters, next generation, display grid to screen
+ *********************************************************************/
+
+#include "PackedGrid.hpp"
+#include "GridPool.hpp"
+#include "Kernel.hpp"
+#include "Soup.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+
+// constructor (ncol x nrow grid with boundary and hidden cells)
+PackedGrid::PackedGrid(int ncol, int nrow) {
+    sizeX = ncol;
+    sizeY = nrow;
+    hide = 4;
+    sparse = true;
+    tileRows = 32;
+    tileWords = 16;
+    hashing = false;
+    counting = false;
+    boundary = PLANE_BOUNDARY;
+    buffer = 0;
+    capacity = 0;
+    mapping = 0;
+    mappedLength = 0;
+    allocate();
+}
+
+// default constructor (40 x 20 grid with boundary and hidden cells)
+PackedGrid::PackedGrid() {
+    sizeX = 40;
+    sizeY = 20;
+    hide = 4;
+    sparse = true;
+    tileRows = 32;
+    tileWords = 16;
+    hashing = false;
+    counting = false;
+    boundary = PLANE_BOUNDARY;
+    buffer = 0;
+    capacity = 0;
+    mapping = 0;
+    mappedLength = 0;
+    allocate();
+}
+
+// destructor, deallocate memory
+PackedGrid::~PackedGrid() {
+    release();
+}
+
+// give the word buffer back to the pool, or unmap it if it was
+// adopted from a file; the grid holds none after
+void PackedGrid::release() {
+    if (mapping != 0) {
+        munmap(mapping, mappedLength);
+    } else if (buffer != 0) {
+        GridPool::shared().release(buffer, capacity);
+    }
+    buffer = 0;
+    capacity = 0;
+    mapping = 0;
+    mappedLength = 0;
+}
+
+// lay out the grid and take a block from the grid pool for its words,
+// keeping the block held if it is large enough, and clear them.  A new
+// block of a huge page or more is already zero pages, which the system
+// provides as they are first touched, so even a huge grid is allocated
+// at once.
+void PackedGrid::allocate() {
+    layout();
+    size_t bytes = getBufferWords() * sizeof(uint64_t);
+    bool zeroed = false;
+    if (mapping != 0 || buffer == 0 || bytes > capacity) {
+        release();
+        buffer = static_cast<uint64_t *>(
+                GridPool::shared().acquire(bytes, capacity, &zeroed));
+    }
+    if (!zeroed) {
+        memset(buffer, 0, bytes);
+    }
+    words = buffer + PAD;
+}
+
+// words per row of a grid with nx cells per row: whole cache lines,
+// keeping at least one spare bit at the end of each row so the last
+// bit of every row is always dead
+int PackedGrid::rowStride(int nx) {
+    return ((nx + 64) / 64 + 7) / 8 * 8;
+}
+
+// lay out the rows and compute the mask and tiles
+void PackedGrid::layout() {
+    nx = sizeX + 2*(hide+1);
+    ny = sizeY + 2*(hide+1);
+    stride = rowStride(nx);
+
+    masks.assign(2*stride, 0);
+    mask = &masks[0];
+    countMask = mask + stride;
+    fillMask();
+    setTileSize(tileRows, tileWords);
+}
+
+// only cells getEdge() to nx-1-getEdge() are updated: on the plane
+// everything but the outer boundary, otherwise the visible cells.
+// The statistics count the cells of the outer boundary of the plane
+// too, as getPopulation does, but never the copies around other edges.
+void PackedGrid::fillMask() {
+    int e = getEdge();
+    int c = countEdge();
+    for (int w = 0; w < stride; w++) {
+        mask[w] = 0;
+        countMask[w] = 0;
+        for (int k = 0; k < 64; k++) {
+            int i = 64*w + k;
+            if (i >= e && i <= nx - 1 - e) {
+                mask[w] |= uint64_t(1) << k;
+            }
+            if (i >= c && i <= nx - 1 - c) {
+                countMask[w] |= uint64_t(1) << k;
+            }
+        }
+    }
+}
+
+// change the dimensions of the grid, keeping the block of words if it
+// is large enough, and kill all cells
+void PackedGrid::resize(int ncol, int nrow) {
+    sizeX = ncol;
+    sizeY = nrow;
+    allocate();
+}
+
+// take over words mapped from a file as the grid's buffer.  The data
+// must be laid out like the buffer of an ncol x nrow grid, padding
+// words included, in count words within the mapping of length bytes
+// at base, which the grid unmaps when done with it.  Returns false,
+// leaving the grid and mapping alone, if the layout does not match.
+bool PackedGrid::adopt(int ncol, int nrow, void *base, size_t length,
+                       uint64_t *data, size_t count) {
+    if (ncol < 1 || nrow < 1 || count != static_cast<size_t>(
+            rowStride(ncol + 2*(hide+1))) * (nrow + 2*(hide+1)) + 2*PAD) {
+        return false;
+    }
+    release();
+    sizeX = ncol;
+    sizeY = nrow;
+    layout();
+    buffer = data;
+    words = buffer + PAD;
+    mapping = base;
+    mappedLength = length;
+    return true;
+}
+
+// set grid cell state
+void PackedGrid::setState(int i, int j, bool s) {
+    uint64_t bit = uint64_t(1) << (i & 63);
+    markChanged(i, j);
+    hashValid = false;
+    statsValid = false;
+    if (s) {
+        words[j*stride + (i >> 6)] |= bit;
+    } else {
+        words[j*stride + (i >> 6)] &= ~bit;
+    }
+}
+
+// return grid cell state
+bool PackedGrid::getState(int i, int j) {
+    return (words[j*stride + (i >> 6)] >> (i & 63)) & 1;
+}
+
+// set all grid states to zero
+void PackedGrid::clearGrid() {
+    int j0 = std::max(getFirstRow() - 1, 0);
+    int j1 = std::min(getLastRow() + 1, ny - 1);
+    std::fill(words + static_cast<size_t>(j0)*stride,
+              words + static_cast<size_t>(j1 + 1)*stride, uint64_t(0));
+    hashValid = false;
+    statsValid = false;
+    markAll();
+}
+
+// context shared by the tasks filling a grid with a soup
+struct SoupFill {
+    PackedGrid *grid;       // grid filled
+    const Soup *soup;       // soup it is filled with
+    int x0, y0;             // indices of the soup's cell 0, 0
+    int width;              // cells across
+    int first, last;        // rows filled, within the band
+};
+
+// thread pool task: fill rows n*FILL_ROWS on of a soup filling, a word
+// of 64 soup cells at a time, shifted into place across two grid words
+void PackedGrid::fillRows(void *context, int n, int) {
+    SoupFill *fill = static_cast<SoupFill *>(context);
+    PackedGrid *g = fill->grid;
+    int j0 = fill->first + n * FILL_ROWS;
+    int j1 = std::min(j0 + FILL_ROWS - 1, fill->last);
+    int d0 = fill->x0 >> 6, s = fill->x0 & 63;
+    for (int j = j0; j <= j1; j++) {
+        uint64_t key = fill->soup->rowKey(j - fill->y0);
+        uint64_t *row = g->words + static_cast<size_t>(j)*g->stride + d0;
+        for (int k = 0; 64*k < fill->width; k++) {
+            int left = fill->width - 64*k;
+            uint64_t m = left >= 64 ? ~uint64_t(0)
+                                    : (uint64_t(1) << left) - 1;
+            uint64_t v = fill->soup->getWord(key, k) & m;
+            row[k] = (row[k] & ~(m << s)) | (v << s);
+            if (s != 0 && (m >> (64 - s)) != 0) {
+                row[k+1] = (row[k+1] & ~(m >> (64 - s))) | (v >> (64 - s));
+            }
+        }
+    }
+}
+
+
+/*********************************************************************
+ ** Function: fillSoup
+ ** Description: Fill a rectangle of the grid with a random soup.
+ ** Parameters: The soup, the indices x0 and y0 of the rectangle's top
+ **   left cell, which is cell 0, 0 of the soup, its width and height,
+ **   and optionally a thread pool to share the rows among.
+ ** Pre-Conditions: The rectangle is inside the grid.
+ ** Post-Conditions: Each cell of the rectangle in the band held is
+ **   live if the soup's cell is, and dead otherwise; a soup's cells do
+ **   not depend on which thread made them, so the grid is the same for
+ **   any number of threads.  Every tile is stepped next time.
+ *********************************************************************/
+
+void PackedGrid::fillSoup(const Soup &soup, int x0, int y0, int w, int h) {
+    ThreadPool serial(1);
+    fillSoup(soup, x0, y0, w, h, serial);
+}
+
+void PackedGrid::fillSoup(const Soup &soup, int x0, int y0, int w, int h,
+                          ThreadPool &pool) {
+    SoupFill fill;
+    fill.grid = this;
+    fill.soup = &soup;
+    fill.x0 = x0;
+    fill.y0 = y0;
+    fill.width = w;
+    fill.first = std::max(y0, getFirstRow());
+    fill.last = std::min(y0 + h - 1, getLastRow());
+    if (w > 0 && fill.first <= fill.last) {
+        int tasks = (fill.last - fill.first) / FILL_ROWS + 1;
+        pool.run(tasks, fillRows, &fill);
+    }
+    hashValid = false;
+    statsValid = false;
+    markAll();
+}
+
+// mark the tile holding a cell as changed
+void PackedGrid::markChanged(int i, int j) {
+    j = std::max(1, std::min(j, ny - 2));
+    changed[((j - 1) / tileRows) * tilesX + (i >> 6) / tileWords] = 1;
+}
+
+// mark every tile as changed, so the next time step computes them all
+void PackedGrid::markAll() {
+    changed.assign(tilesX * tilesY, 1);
+}
+
+// use (true) or skip (false) active tile tracking
+void PackedGrid::setSparse(bool s) {
+    sparse = s;
+}
+
+// follow a rule, which must have two states.  Tiles that were stable
+// under the old rule may not be under the new one, so the next time
+// step computes them all.
+bool PackedGrid::setRule(const Rule &r) {
+    Rule next = r;
+    if (next.getStates() != 2) {
+        return false;
+    }
+    rule = next;
+    markAll();
+    return true;
+}
+
+// choose the edges of the grid.  Away from the plane only the visible
+// cells are stepped, so any cells outside them are killed.
+void PackedGrid::setBoundary(Boundary b) {
+    boundary = b;
+    fillMask();
+    int e = getEdge();
+    int j0 = std::max(getFirstRow() - 1, 0);
+    int j1 = std::min(getLastRow() + 1, ny - 1);
+    for (int j = j0; j <= j1; j++) {
+        uint64_t *row = words + j*stride;
+        for (int w = 0; w < stride; w++) {
+            row[w] &= (j < e || j > ny - 1 - e) ? 0 : mask[w];
+        }
+    }
+    hashValid = false;
+    statsValid = false;
+    markAll();
+}
+
+// get the edges of the grid
+Boundary PackedGrid::getBoundary() {
+    return boundary;
+}
+
+// get the index of the first row and column of cells stepped: the
+// first hidden cell on the plane, otherwise the first visible cell.
+// As many are left out at the far end.
+int PackedGrid::getEdge() {
+    return boundary == PLANE_BOUNDARY ? 1 : hide + 1;
+}
+
+// index of the first cell counted in the statistics
+int PackedGrid::countEdge() {
+    return boundary == PLANE_BOUNDARY ? 0 : hide + 1;
+}
+
+// state of cell i of a row, and setting it
+static inline bool cellOf(const uint64_t *row, int i) {
+    return (row[i >> 6] >> (i & 63)) & 1;
+}
+static inline void putCell(uint64_t *row, int i, bool s) {
+    uint64_t bit = uint64_t(1) << (i & 63);
+    row[i >> 6] = s ? (row[i >> 6] | bit) : (row[i >> 6] & ~bit);
+}
+
+
+/*********************************************************************
+ ** Function: fillHalo
+ ** Description: Fill the ring of cells just outside the stepped ones
+ **   with the cells a wrapped grid has there, so the kernels can step
+ **   the grid as if it had no edge.
+ ** Parameters: none
+ ** Pre-Conditions: The ring is dead.
+ ** Post-Conditions: On a torus each cell of the ring holds the cell at
+ **   the opposite edge: two bits a row, then two whole rows copied.
+ **   On a Klein bottle the top and bottom rows are mirrored left to
+ **   right, a cell at a time.  Otherwise the ring stays dead.  A grid
+ **   holding a band of rows only wraps the ends of its own rows; the
+ **   rows wrapped from the other end are copied in with copyRow.
+ *********************************************************************/
+
+void PackedGrid::fillHalo() {
+    if (boundary != TORUS_BOUNDARY && boundary != KLEIN_BOUNDARY) {
+        return;
+    }
+    int x0 = getEdge(), x1 = nx - 1 - x0;
+    int y0 = x0, y1 = ny - 1 - y0;
+    for (int j = std::max(y0, getFirstRow());
+         j <= std::min(y1, getLastRow()); j++) {
+        uint64_t *row = words + j*stride;
+        putCell(row, x0 - 1, cellOf(row, x1));
+        putCell(row, x1 + 1, cellOf(row, x0));
+    }
+    if (isBand()) {
+        return;
+    }
+    uint64_t *top = words + (y0-1)*stride, *bottom = words + (y1+1)*stride;
+    const uint64_t *first = words + y0*stride, *last = words + y1*stride;
+    if (boundary == TORUS_BOUNDARY) {
+        std::copy(last, last + stride, top);
+        std::copy(first, first + stride, bottom);
+    } else {
+        for (int i = x0 - 1; i <= x1 + 1; i++) {
+            putCell(top, i, cellOf(last, x0 + x1 - i));
+            putCell(bottom, i, cellOf(first, x0 + x1 - i));
+        }
+    }
+}
+
+// kill the ring of cells filled by fillHalo.  A band keeps the rows
+// copied in with copyRow, which are compared with the next ones.
+void PackedGrid::clearHalo() {
+    if (boundary != TORUS_BOUNDARY && boundary != KLEIN_BOUNDARY) {
+        return;
+    }
+    int x0 = getEdge(), x1 = nx - 1 - x0;
+    int y0 = x0, y1 = ny - 1 - y0;
+    for (int j = std::max(y0, getFirstRow());
+         j <= std::min(y1, getLastRow()); j++) {
+        uint64_t *row = words + j*stride;
+        putCell(row, x0 - 1, 0);
+        putCell(row, x1 + 1, 0);
+    }
+    if (isBand()) {
+        return;
+    }
+    std::fill(words + (y0-1)*stride, words + y0*stride, uint64_t(0));
+    std::fill(words + (y1+1)*stride, words + (y1+2)*stride, uint64_t(0));
+}
+
+// get visible X dimension of grid
+int PackedGrid::getSizeX() {
+    return sizeX;
+}
+
+// get visible Y dimension of grid
+int PackedGrid::getSizeY() {
+    return sizeY;
+}
+
+// get number of hidden cells at boundary
+int PackedGrid::getHide() {
+    return hide;
+}
+
+// get number of words in each row
+int PackedGrid::getStride() {
+    return stride;
+}
+
+// get number of rows, boundary rows included
+int PackedGrid::getRows() {
+    return ny;
+}
+
+// get number of words in the buffer, rows and padding words included
+size_t PackedGrid::getBufferWords() {
+    return static_cast<size_t>(stride)*ny + 2*PAD;
+}
+
+// get the buffer: PAD zero words, the rows, then PAD zero words
+uint64_t *PackedGrid::getBuffer() {
+    return buffer;
+}
+
+// get the words of a row; bit k of word w is cell 64*w + k
+uint64_t *PackedGrid::getRow(int j) {
+    return words + j*stride;
+}
+
+// set the tile size used to split a time step into tasks: rows per
+// tile and words per tile row (rounded up to a multiple of 8)
+void PackedGrid::setTileSize(int rows, int nwords) {
+    tileRows = rows < 1 ? 1 : rows;
+    tileWords = nwords < 8 ? 8 : (nwords + 7) / 8 * 8;
+    tilesY = (ny - 2 + tileRows - 1) / tileRows;
+    tilesX = (stride + tileWords - 1) / tileWords;
+    bandFirst = 0;
+    bandLast = tilesY - 1;
+    hashValid = false;
+    statsValid = false;
+    markAll();
+    active.reserve(tilesX * tilesY);    // so stepping never grows it
+}
+
+// get number of tiles in a time step
+int PackedGrid::getTiles() {
+    return tilesX * tilesY;
+}
+
+// most bands the grid can be split into: one per row of tiles, but
+// the last band holds the last visible row and the ring below it
+int PackedGrid::getMaxBands() {
+    return (ny - 2 - (hide + 1)) / tileRows + 1;
+}
+
+
+/*********************************************************************
+ ** Function: setBand
+ ** Description: Hold only a band of rows of tiles, for a grid split
+ **   between processes.  The grid keeps the layout of the whole grid,
+ **   so cells keep their indices and hashes, but only the band's rows
+ **   are stepped, hashed, counted and cleared, so only their pages of
+ **   the zero page buffer are ever used.
+ ** Parameters: Band k of n, counted from the top.
+ ** Pre-Conditions: 0 <= k < n <= getMaxBands(); setTileSize resets
+ **   the band to the whole grid.
+ ** Post-Conditions: The rows of the band, from getFirstRow to
+ **   getLastRow, are the grid; the rows just outside it are filled by
+ **   copyRow before each time step.  The first band holds the top ring
+ **   and visible row, and the last band the bottom ones, so the rows a
+ **   torus or Klein bottle wraps are each copied to one band.
+ *********************************************************************/
+
+void PackedGrid::setBand(int k, int n) {
+    int bands = getMaxBands();
+    bandFirst = k * bands / n;
+    bandLast = k == n - 1 ? tilesY - 1 : (k + 1) * bands / n - 1;
+    hashValid = false;
+    statsValid = false;
+    markAll();
+}
+
+// true if the grid holds only a band of its rows
+bool PackedGrid::isBand() {
+    return bandFirst > 0 || bandLast < tilesY - 1;
+}
+
+// first row of the band, the boundary row included at the top
+int PackedGrid::getFirstRow() {
+    return bandFirst == 0 ? 0 : 1 + bandFirst * tileRows;
+}
+
+// last row of the band, the boundary row included at the bottom
+int PackedGrid::getLastRow() {
+    return bandLast == tilesY - 1 ? ny - 1 : (bandLast + 1) * tileRows;
+}
+
+// replace row j with a row of another grid of the same layout, mirrored
+// left to right if reflect (for a Klein bottle, as fillHalo does), and
+// mark the tiles whose cells change so they are stepped
+void PackedGrid::copyRow(int j, const uint64_t *source, bool reflect) {
+    uint64_t *row = words + static_cast<size_t>(j)*stride;
+    std::vector<uint64_t> mirror;
+    if (reflect) {
+        int x0 = getEdge(), x1 = nx - 1 - x0;
+        mirror.assign(row, row + stride);
+        for (int i = x0 - 1; i <= x1 + 1; i++) {
+            putCell(&mirror[0], i, cellOf(source, x0 + x1 - i));
+        }
+        source = &mirror[0];
+    }
+    for (int w = 0; w < stride; w++) {
+        if (row[w] != source[w]) {
+            markChanged(64*w, j);
+            row[w] = source[w];
+        }
+    }
+}
+
+// get number of tiles computed by the last time step
+int PackedGrid::getActiveTiles() {
+    return static_cast<int>(active.size());
+}
+
+// list the tiles that need computing this time step: those where the
+// tile itself or one of its eight neighbor tiles changed last time
+// step.  Every other tile is stable, and its old state is still in the
+// future grid from the time step before.  On a torus or Klein bottle
+// the tiles along each edge also neighbor those along the opposite
+// edge; as a Klein bottle's top and bottom are mirrored, a change
+// anywhere along one of them wakes the whole other.
+void PackedGrid::findActive() {
+    bool wrap = boundary == TORUS_BOUNDARY || boundary == KLEIN_BOUNDARY;
+    bool klein = boundary == KLEIN_BOUNDARY;
+    int e = getEdge();
+    int top = (e - 1) / tileRows, bottom = (ny - 2 - e) / tileRows;
+    int left = (e >> 6) / tileWords, right = ((nx - 1 - e) >> 6) / tileWords;
+    bool topChanged = false, bottomChanged = false;
+    for (int t = 0; klein && t < tilesX * tilesY; t++) {
+        topChanged = topChanged || (changed[t] && t / tilesX == top);
+        bottomChanged = bottomChanged || (changed[t] && t / tilesX == bottom);
+    }
+
+    active.clear();
+    for (int ty = bandFirst; ty <= bandLast; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            bool busy = !sparse ||
+                        (klein && ty == top && bottomChanged) ||
+                        (klein && ty == bottom && topChanged);
+            for (int dy = -1; !busy && dy <= 1; dy++) {
+                int y = ty + dy;
+                if (wrap && !klein && ty == top && dy < 0) {
+                    y = bottom;
+                } else if (wrap && !klein && ty == bottom && dy > 0) {
+                    y = top;
+                }
+                for (int dx = -1; y >= 0 && y < tilesY && dx <= 1; dx++) {
+                    int x = tx + dx;
+                    if (wrap && tx == left && dx < 0) {
+                        x = right;
+                    } else if (wrap && tx == right && dx > 0) {
+                        x = left;
+                    }
+                    if (x >= 0 && x < tilesX) {
+                        busy = busy || changed[y*tilesX + x];
+                    }
+                }
+            }
+            if (busy) {
+                active.push_back(ty*tilesX + tx);
+            }
+        }
+    }
+}
+
+// count live cells in the whole grid, or its band.  Away from the
+// plane the rows of the ring are left out, as a band may hold rows
+// wrapped from the other end there.
+long long PackedGrid::countLive() {
+    long long n = 0;
+    int j0 = std::max(getFirstRow(), countEdge());
+    int j1 = std::min(getLastRow(), ny - 1 - countEdge());
+    const uint64_t *end = words + static_cast<size_t>(j1 + 1)*stride;
+    for (const uint64_t *w = getRow(j0); w < end; w++) {
+        n += __builtin_popcountll(*w);
+    }
+    return n;
+}
+
+// hash of the cells of a tile, each word hashed at its place in the
+// grid.  The rows that are never stepped are left out.
+uint64_t PackedGrid::hashTile(int tile) {
+    int j0 = std::max(1 + (tile / tilesX) * tileRows, getEdge());
+    int j1 = std::min(1 + (tile / tilesX + 1) * tileRows - 1,
+                      ny - 1 - getEdge());
+    if (j0 > j1) {
+        return 0;
+    }
+    int w0 = (tile % tilesX) * tileWords;
+    int w1 = std::min(w0 + tileWords, stride);
+    return getHashKernel()(words, stride, j0, j1, w0, w1);
+}
+
+// recompute the hash of every tile of the band
+void PackedGrid::hashAll() {
+    tileHash.assign(tilesX * tilesY, 0);
+    for (int t = bandFirst * tilesX; t < (bandLast + 1) * tilesX; t++) {
+        tileHash[t] = hashTile(t);
+    }
+    hashValid = true;
+}
+
+
+/*********************************************************************
+ ** Function: getHash
+ ** Description: Hash the cells of the grid.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the XOR of the tile hashes.  The first call
+ **   hashes every tile and turns on hashing, after which each time
+ **   step rehashes only the tiles it changed and later calls only
+ **   combine the tile hashes.
+ *********************************************************************/
+
+uint64_t PackedGrid::getHash() {
+    if (!hashing || !hashValid) {
+        hashAll();
+        hashing = true;
+    }
+    uint64_t hash = 0;
+    for (size_t t = 0; t < tileHash.size(); t++) {
+        hash ^= tileHash[t];
+    }
+    return hash;
+}
+
+// statistics of the cells of a tile, with the births and deaths since
+// the cells of the grid before (none if it is null).  Away from the
+// plane only the stepped rows and cells are counted, as the ring
+// around them may hold wrapped cells during a time step.
+CellStats PackedGrid::countTile(int tile, const PackedGrid *before) {
+    int ty = tile / tilesX;
+    int j0 = std::max(ty == 0 ? 0 : 1 + ty * tileRows, countEdge());
+    int j1 = std::min(ty == tilesY - 1 ? ny - 1 : (ty + 1) * tileRows,
+                      ny - 1 - countEdge());
+    int w0 = (tile % tilesX) * tileWords;
+    int w1 = std::min(w0 + tileWords, stride);
+    CellStats stats;
+    stats.clear();
+    getCountKernel()(words, before ? before->words : 0, countMask, stride,
+                     j0, j1, w0, w1, stats);
+    return stats;
+}
+
+// recount the statistics of every tile of the band, with no births
+// or deaths
+void PackedGrid::countAll() {
+    CellStats none;
+    none.clear();
+    tileStats.assign(tilesX * tilesY, none);
+    for (int t = bandFirst * tilesX; t < (bandLast + 1) * tilesX; t++) {
+        tileStats[t] = countTile(t, 0);
+    }
+    statsValid = true;
+}
+
+
+/*********************************************************************
+ ** Function: getStats
+ ** Description: Get the statistics of the cells of the grid.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the sum of the tile statistics.  As with
+ **   getHash, the first call counts every tile, with no births or
+ **   deaths, and turns on counting, after which each time step counts
+ **   the tiles it changed as it writes them.
+ *********************************************************************/
+
+CellStats PackedGrid::getStats() {
+    if (!counting || !statsValid) {
+        countAll();
+        counting = true;
+    }
+    CellStats stats;
+    stats.clear();
+    for (size_t t = 0; t < tileStats.size(); t++) {
+        stats.add(tileStats[t]);
+    }
+    return stats;
+}
+
+// context shared by the tile tasks of one time step
+struct TileStep {
+    PackedGrid *current;    // grid at this time step
+    PackedGrid *future;     // grid at the next time step
+    StepKernel kernel;      // selected kernel
+    int birth, survive;     // neighbor counts of the rule
+};
+
+// thread pool task: step the n-th active tile of the grid
+void PackedGrid::stepTile(void *context, int n, int) {
+    ScopedTimer timer(TILE_TIMER);
+    TileStep *step = static_cast<TileStep *>(context);
+    PackedGrid *g = step->current;
+    int tile = g->active[n];
+    int j0 = 1 + (tile / g->tilesX) * g->tileRows;
+    int j1 = std::min(j0 + g->tileRows - 1, g->ny - 2);
+    int w0 = (tile % g->tilesX) * g->tileWords;
+    int w1 = std::min(w0 + g->tileWords, g->stride);
+    PackedGrid *f = step->future;
+
+    // rows outside the stepped ones stay dead
+    j0 = std::max(j0, g->getEdge());
+    j1 = std::min(j1, g->ny - 1 - g->getEdge());
+    if (j0 > j1) {
+        return;
+    }
+    f->changed[tile] = step->kernel(g->words, f->words, g->mask, g->stride,
+                                    j0, j1, w0, w1,
+                                    step->birth, step->survive);
+    if (f->hashing && f->changed[tile]) {
+        f->tileHash[tile] = f->hashTile(tile);
+    }
+    if ((f->counting || Trace::isEnabled()) && f->changed[tile]) {
+        CellStats stats = f->countTile(tile, g);
+        if (f->counting) {
+            f->tileStats[tile] = stats;
+        }
+        Trace::count(BIRTHS_COUNTER, stats.births);
+        Trace::count(DEATHS_COUNTER, stats.deaths);
+    }
+    Trace::count(STEPPED_COUNTER, 1);
+    Trace::count(CELLS_COUNTER, 64ULL * (j1 - j0 + 1) * (w1 - w0));
+}
+
+// start a time step into the future grid: find the tiles to compute
+// and, if hashing or counting, give the future grid this grid's tile
+// hashes and statistics, which stay right for every tile that does not
+// change, but for its births and deaths
+void PackedGrid::beginStep(PackedGrid &future) {
+    findActive();
+    Trace::count(SKIPPED_COUNTER, tilesX * tilesY - active.size());
+    future.changed.assign(tilesX * tilesY, 0);
+    future.hashing = hashing;
+    if (hashing) {
+        if (!hashValid) {
+            hashAll();
+        }
+        future.tileHash = tileHash;
+        future.hashValid = true;
+    }
+    future.counting = counting;
+    if (counting) {
+        if (!statsValid) {
+            countAll();
+        }
+        future.tileStats = tileStats;
+        for (size_t t = 0; t < tileStats.size(); t++) {
+            future.tileStats[t].births = 0;
+            future.tileStats[t].deaths = 0;
+        }
+        future.statsValid = true;
+    }
+}
+
+// calculate the next generation of every cell into the future grid,
+// which must have the same dimensions as this grid, using the kernel
+// selected for this CPU and rule
+void PackedGrid::calcNext(PackedGrid &future) {
+    ScopedTimer timer(STEP_TIMER);
+    TileStep step;
+    step.current = this;
+    step.future = &future;
+    step.kernel = getRuleKernel(rule);
+    step.birth = rule.getBirth();
+    step.survive = rule.getSurvive();
+    beginStep(future);
+    fillHalo();
+    for (size_t n = 0; n < active.size(); n++) {
+        stepTile(&step, static_cast<int>(n), 0);
+    }
+    clearHalo();
+}
+
+// calculate the next generation into the future grid, split into
+// tiles shared among the threads of a pool.  The grids are double
+// buffered, so the only synchronization is the wait for the last tile.
+void PackedGrid::calcNext(PackedGrid &future, ThreadPool &pool) {
+    ScopedTimer timer(STEP_TIMER);
+    TileStep step;
+    step.current = this;
+    step.future = &future;
+    step.kernel = getRuleKernel(rule);
+    step.birth = rule.getBirth();
+    step.survive = rule.getSurvive();
+    beginStep(future);
+    fillHalo();
+    pool.run(getActiveTiles(), stepTile, &step);
+    clearHalo();
+}
+
+// context shared by the strip tasks of a temporally blocked pass
+struct BlockStep {
+    PackedGrid *current;    // grid at the first time step
+    PackedGrid *future;     // grid at the last time step
+    StepKernel kernel;      // selected kernel
+    int birth, survive;     // neighbor counts of the rule
+    int generations;        // time steps of the pass
+    int stripRows;          // rows per strip, whole tiles
+    size_t scratchWords;    // words of each of a worker's two buffers
+    std::vector<unsigned char> busy;    // strips holding an active tile
+};
+
+// thread pool task: advance the n-th strip of rows of the grid every
+// time step of a blocked pass in a worker's scratch buffers
+void PackedGrid::stepStrip(void *context, int n, int worker) {
+    ScopedTimer timer(TILE_TIMER);
+    BlockStep *step = static_cast<BlockStep *>(context);
+    PackedGrid *g = step->current;
+    PackedGrid *f = step->future;
+    int k = step->generations, e = g->getEdge(), ny = g->ny;
+    int stride = g->stride;
+    int r0 = 1 + n * step->stripRows;
+    int r1 = std::min(r0 + step->stripRows - 1, ny - 2);
+    int j0 = std::max(r0, e), j1 = std::min(r1, ny - 1 - e);
+    int t0 = ((r0 - 1) / g->tileRows) * g->tilesX;
+    int t1 = ((r1 - 1) / g->tileRows + 1) * g->tilesX;
+    if (j0 > j1) {
+        return;
+    }
+
+    // a strip with no active tile is the same every time step
+    if (!step->busy[n]) {
+        std::copy(g->getRow(j0), g->getRow(j1 + 1), f->getRow(j0));
+        Trace::count(SKIPPED_COUNTER, t1 - t0);
+        return;
+    }
+
+    // load the strip and the k rows either side of it: all of them from
+    // this time step, and the rows that are never stepped from the
+    // other one too, as the grids alternate
+    int a = std::max(0, r0 - k), b = std::min(ny - 1, r1 + k);
+    uint64_t *buffer[2];
+    buffer[0] = &g->blockScratch[2 * worker * step->scratchWords] + PAD;
+    buffer[1] = buffer[0] + step->scratchWords;
+    std::copy(g->getRow(a), g->getRow(b + 1), buffer[0]);
+    for (int j = a; j <= b; j++) {
+        if (j < e || j > ny - 1 - e) {
+            std::copy(f->getRow(j), f->getRow(j + 1),
+                      buffer[1] + static_cast<size_t>(j - a) * stride);
+        }
+    }
+
+    // each time step the rows that are still right shrink by one at
+    // both ends, until only the strip is left
+    for (int gen = 1; gen <= k; gen++) {
+        int lo = std::max(r0 - (k - gen), e);
+        int hi = std::min(r1 + (k - gen), ny - 1 - e);
+        step->kernel(buffer[(gen - 1) & 1], buffer[gen & 1], g->mask,
+                     stride, lo - a, hi - a, 0, stride,
+                     step->birth, step->survive);
+        Trace::count(CELLS_COUNTER, 64ULL * (hi - lo + 1) * stride);
+    }
+    const uint64_t *result = buffer[k & 1] + static_cast<size_t>(j0 - a) * stride;
+    std::copy(result, result + static_cast<size_t>(j1 - j0 + 1) * stride,
+              f->getRow(j0));
+    for (int t = t0; t < t1; t++) {
+        f->changed[t] = 1;
+        if (f->hashing) {
+            f->tileHash[t] = f->hashTile(t);
+        }
+    }
+    Trace::count(STEPPED_COUNTER, t1 - t0);
+}
+
+
+/*********************************************************************
+ ** Function: calcBlock
+ ** Description: Calculate several generations at once into the future
+ **   grid, which must have the same dimensions as this grid.  The grid
+ **   is split into strips of whole rows of tiles, shared among the
+ **   threads of a pool; each strip is copied with k rows either side
+ **   into a buffer small enough to stay in the cache, stepped k times
+ **   there, a row less at each end every time, and only then written
+ **   back, so memory is read and written once per k time steps
+ **   instead of once per time step.  A strip with no active tile is
+ **   only copied.
+ ** Parameters: The future grid, the number of generations k and the
+ **   thread pool.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the number of generations calculated: k,
+ **   or 1 after a plain time step if the grid wraps, holds a band or
+ **   keeps statistics (whose births and deaths are those of the last
+ **   time step alone).  k is at most the rows of a tile, so a tile
+ **   whose neighbors did not change stays the same throughout.  The
+ **   cells are those k single time steps would give.
+ *********************************************************************/
+
+int PackedGrid::calcBlock(PackedGrid &future, int k, ThreadPool &pool) {
+    k = std::min(k, tileRows);
+    if (k < 2 || boundary == TORUS_BOUNDARY ||
+        boundary == KLEIN_BOUNDARY || isBand() || counting) {
+        calcNext(future, pool);
+        return 1;
+    }
+    ScopedTimer timer(STEP_TIMER);
+    BlockStep step;
+    step.current = this;
+    step.future = &future;
+    step.kernel = getRuleKernel(rule);
+    step.birth = rule.getBirth();
+    step.survive = rule.getSurvive();
+    step.generations = k;
+
+    // strips of whole tiles, as tall as fit in the cache but at least
+    // four times the extra rows they are loaded with
+    size_t rowBytes = static_cast<size_t>(stride) * sizeof(uint64_t);
+    int fit = static_cast<int>(BLOCK_BYTES / (2 * rowBytes)) - 2*k;
+    step.stripRows = std::max(fit, 4*k) / tileRows * tileRows;
+    step.stripRows = std::max(step.stripRows, tileRows);
+    int strips = (ny - 2 + step.stripRows - 1) / step.stripRows;
+    step.scratchWords = static_cast<size_t>(step.stripRows + 2*k) * stride +
+                        2*PAD;
+    size_t words = 2 * pool.getThreads() * step.scratchWords;
+    if (blockScratch.size() < words) {
+        blockScratch.assign(words, 0);
+    }
+
+    findActive();
+    step.busy.assign(strips, 0);
+    for (size_t n = 0; n < active.size(); n++) {
+        step.busy[(active[n] / tilesX) * tileRows / step.stripRows] = 1;
+    }
+    future.changed.assign(tilesX * tilesY, 0);
+    future.hashing = hashing;
+    if (hashing) {
+        if (!hashValid) {
+            hashAll();
+        }
+        future.tileHash = tileHash;
+        future.hashValid = true;
+    }
+    future.counting = false;
+    future.statsValid = false;
+    pool.run(strips, stepStrip, &step);
+
+    // the rows that are never stepped alternate between the grids, so
+    // after an even number of time steps they trade places
+    if (k % 2 == 0) {
+        int e = getEdge();
+        for (int j = 0; j < ny; j++) {
+            if (j < e || j > ny - 1 - e) {
+                std::swap_ranges(getRow(j), getRow(j + 1), future.getRow(j));
+            }
+        }
+    }
+    return k;
+}
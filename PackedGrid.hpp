@@ -0,0 +1,132 @@
+/*********************************************************************
+ ** Program Filename: PackedGrid.hpp, PackedGrid class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Bit-packed game grid for the Game of Life.  Cells are
+ **   stored 64 to a word in one contiguous allocation and a whole
+ **   word of cells is advanced at once with bitwise adder logic.
+ **   Cell indices, hidden cells and boundary cells match Grid so the
+ **   two backends produce identical boards.  Only tiles near cells
+ **   that changed in the last time step are recomputed, so stable and
+ **   empty regions cost nothing.  Once asked for, a hash of the cells
+ **   is kept per tile and updated only for tiles that change, and so
+ **   are the statistics of the cells (population, births, deaths and
+ **   the box around them), counted while each tile is in cache.  Edges
+ **   other than the plane are handled as in Grid, by filling the ring
+ **   of cells around the visible ones before a time step.  A grid can
+ **   also hold only a band of rows, for a grid split between processes
+ **   that copy each other's edge rows in before each time step.
+ ** Input: dimensions of grid and state of each grid cell
+ ** Output:  Grid parameters, next generation.
+ *********************************************************************/
+
+#ifndef PackedGrid_hpp
+#define PackedGrid_hpp
+
+#include <stdint.h> // header file for fixed width integer types
+#include <cstddef>  // header file for size_t
+#include <vector>   // header file for vector objects
+#include "ThreadPool.hpp"
+#include "Rule.hpp"
+#include "Grid.hpp"
+
+class Soup;
+
+class PackedGrid {
+private:
+    uint64_t *buffer;   // single allocation holding all rows plus padding
+    uint64_t *words;    // first word of row 0 (inside buffer)
+    size_t capacity;    // bytes of the pool block holding the buffer
+    std::vector<uint64_t> masks;    // the two masks below, one after other
+    uint64_t *mask;     // per-word mask of cells updated each time step
+    uint64_t *countMask;    // per-word mask of cells in the statistics
+    void *mapping;      // file mapping holding the buffer, if adopted
+    size_t mappedLength;    // length of the mapping in bytes
+    int sizeX;          // x dimension of visible portion of array
+    int sizeY;          // y dimension of visible portion of array
+    int hide;           // number of extra cells to hide on each boundary
+    int nx, ny;         // total cells per row and column incl. boundary
+    int stride;         // number of words per row
+    int tileRows;       // rows per tile stepped as one task
+    int tileWords;      // words per tile row, a multiple of 8
+    int tilesX, tilesY; // number of tiles across and down
+    int bandFirst, bandLast;    // rows of tiles held, all unless split
+    std::vector<unsigned char> changed; // tiles changed by last time step
+    std::vector<int> active;            // tiles computed this time step
+    bool sparse;        // skip tiles whose neighborhood did not change
+    std::vector<uint64_t> tileHash;     // hash of the cells of each tile
+    bool hashing;       // keep tile hashes up to date while stepping
+    bool hashValid;     // tile hashes match the cells
+    std::vector<CellStats> tileStats;   // statistics of each tile
+    bool counting;      // keep tile statistics up to date while stepping
+    bool statsValid;    // tile statistics match the cells
+    std::vector<uint64_t> blockScratch; // buffers of a blocked pass
+    Rule rule;          // two-state rule the cells follow
+    Boundary boundary;  // edges of the grid
+    void allocate();    // take and clear a block for the word buffer
+    void layout();      // compute row layout, mask and tiles
+    void fillMask();    // compute the masks of stepped and counted cells
+    int countEdge();    // get index of first counted cell
+    bool isBand();      // true if only a band of rows is held
+    void release();     // give back the word buffer
+    static int rowStride(int);  // words per row for a row length
+    void markChanged(int,int);  // mark the tile holding a cell changed
+    void findActive();  // list tiles that must be computed
+    uint64_t hashTile(int);     // hash of the cells of a tile
+    void hashAll();     // recompute every tile hash
+    CellStats countTile(int, const PackedGrid *); // statistics of a tile
+    void countAll();    // recount every tile's statistics
+    void beginStep(PackedGrid &);   // set up a time step into a grid
+    static void stepTile(void *, int, int); // thread pool task
+    static void stepStrip(void *, int, int); // blocked pass task
+    static void fillRows(void *, int, int); // soup filling task
+    PackedGrid(const PackedGrid &);             // not copyable
+    PackedGrid &operator=(const PackedGrid &);  // not assignable
+public:
+    static const int PAD = 8;       // zero words before and after rows
+    static const size_t BLOCK_BYTES = 1 << 20; // buffers of a blocked strip
+    static const int FILL_ROWS = 64;    // rows of a soup filling task
+    PackedGrid(int,int);            // constructor
+    PackedGrid();                   // default constructor
+    ~PackedGrid();                  // destructor
+    void setState(int,int,bool);    // set state of a single cell
+    bool getState(int,int);         // get state of a single cell
+    void clearGrid();               // set state of all cells to zero
+    void fillSoup(const Soup &, int, int, int, int); // fill with a soup
+    void fillSoup(const Soup &, int, int, int, int, ThreadPool &); // same,
+                                    // rows shared among a pool's threads
+    int getSizeX();                 // get x dimension of visible portion
+    int getSizeY();                 // get y dimension of visible portion
+    int getHide();                  // get number of hidden cells
+    int getStride();                // get number of words per row
+    int getRows();                  // get number of rows incl. boundary
+    uint64_t *getRow(int);          // get the words of a row
+    size_t getBufferWords();        // get number of words incl. padding
+    uint64_t *getBuffer();          // get the words incl. padding
+    void resize(int,int);           // change dimensions, killing all cells
+    bool adopt(int,int,void *,size_t,uint64_t *,size_t); // use mapped words
+    void setTileSize(int,int);      // set tile rows and words per row
+    int getTiles();                 // get number of tiles
+    int getMaxBands();              // get most bands the grid splits into
+    void setBand(int,int);          // hold only band k of n
+    int getFirstRow();              // get first row of the band
+    int getLastRow();               // get last row of the band
+    void copyRow(int,const uint64_t *,bool); // copy a row from another grid
+    int getActiveTiles();           // get tiles computed by last step
+    void setSparse(bool);           // turn active tile tracking on/off
+    bool setRule(const Rule &);     // follow a two-state rule
+    void setBoundary(Boundary);     // choose the edges of the grid
+    Boundary getBoundary();         // get the edges of the grid
+    int getEdge();                  // get index of first stepped cell
+    void fillHalo();                // copy wrapped cells around the edge
+    void clearHalo();               // kill the cells around the edge
+    void markAll();                 // force every tile to be computed
+    long long countLive();          // get number of live cells
+    uint64_t getHash();             // get hash of the cells
+    CellStats getStats();           // get statistics of the cells
+    void calcNext(PackedGrid &);    // write next generation into a grid
+    void calcNext(PackedGrid &, ThreadPool &); // same, tiled on a pool
+    int calcBlock(PackedGrid &, int, ThreadPool &); // several generations
+};
+
+#endif /* PackedGrid_hpp */
@@ -0,0 +1,506 @@
+/*********************************************************************
+ ** Program Filename: PatternLibrary.cpp, PatternLibrary class
+ **   implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Library of the seed patterns in a directory, indexed
+ **   and cached on disk so they are read from text only once.
+ ** Input: directory of pattern files, index and cache files
+ ** Output: index and cache files, pattern names and dimensions,
+ **   patterns found by name or size, patterns read from the cache
+ *********************************************************************/
+
+#include "PatternLibrary.hpp"
+#include <algorithm>    // header file for sort
+#include <fstream>      // header file for file streams
+#include <sstream>      // header file for string streams
+#include <unordered_map> // header file for hash tables
+#include <cstdio>       // header file for rename
+#include <cstdlib>      // header file for atoll
+#include <cstring>      // header file for strlen
+#include <cctype>       // header file for tolower
+#include <dirent.h>     // header file for reading directories
+#include <fcntl.h>      // header file for open
+#include <unistd.h>     // header file for write and close
+#include <sys/mman.h>   // header file for mmap
+#include <sys/stat.h>   // header file for stat
+
+const char *PatternLibrary::INDEX_FILE = ".lifeindex";
+const char *PatternLibrary::CACHE_FILE = ".lifecache";
+
+// first line of an index file, followed by the length of its cache
+static const char *INDEX_HEADER = "#PatternLibrary 1";
+
+
+/*********************************************************************
+ ** Function:  PatternLibrary
+ ** Description:  PatternLibrary class constructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions:  The library is empty until a directory is opened.
+ *********************************************************************/
+
+PatternLibrary::PatternLibrary() {
+    mapping = 0;
+    mappedLength = 0;
+    cache = 0;
+    cacheLength = 0;
+    parsed = 0;
+}
+
+// destructor, unmap the cache
+PatternLibrary::~PatternLibrary() {
+    close();
+}
+
+// forget the patterns and unmap the cache
+void PatternLibrary::close() {
+    if (mapping != 0) {
+        munmap(mapping, mappedLength);
+    }
+    mapping = 0;
+    mappedLength = 0;
+    built.clear();
+    cache = 0;
+    cacheLength = 0;
+    entries.clear();
+    patterns.clear();
+}
+
+// true if a file name ends in the extension of a pattern format
+static bool isPatternFile(const std::string &name) {
+    static const char *extensions[] = { ".lif", ".life", ".rle", ".cells" };
+    std::string lower = name;
+    for (size_t i = 0; i < lower.size(); i++) {
+        lower[i] = static_cast<char>(tolower(lower[i]));
+    }
+    for (size_t k = 0; k < sizeof(extensions) / sizeof(extensions[0]); k++) {
+        size_t n = strlen(extensions[k]);
+        if (lower.size() > n &&
+            lower.compare(lower.size() - n, n, extensions[k]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// list the pattern files in a directory below the library's, and in
+// the directories below it, with their sizes and modification times.
+// Hidden files and links to directories are left out, and so are
+// names with tabs or line breaks, which the index cannot hold.
+void PatternLibrary::scan(const std::string &below,
+                          std::vector<Entry> &found) {
+    DIR *dir = opendir((directory + "/" + below).c_str());
+    if (dir == 0) {
+        return;
+    }
+    std::vector<std::string> names;
+    for (struct dirent *d = readdir(dir); d != 0; d = readdir(dir)) {
+        std::string name = d->d_name;
+        if (name[0] != '.' && name.find_first_of("\t\r\n") == std::string::npos) {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+    for (size_t i = 0; i < names.size(); i++) {
+        std::string file = below.empty() ? names[i] : below + "/" + names[i];
+        struct stat info;
+        if (lstat((directory + "/" + file).c_str(), &info) != 0) {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            scan(file, found);
+        } else if (S_ISREG(info.st_mode) && isPatternFile(names[i])) {
+            Entry e;
+            e.name = names[i].substr(0, names[i].rfind('.'));
+            e.file = file;
+            e.sizeX = e.sizeY = 0;
+            e.population = 0;
+            e.offset = e.bytes = 0;
+            e.fileBytes = info.st_size;
+            e.modified = info.st_mtim.tv_sec * 1000000000LL +
+                         info.st_mtim.tv_nsec;
+            found.push_back(e);
+        }
+    }
+}
+
+// read the index file into a list of entries; false if there is none
+// or it is not a whole index
+bool PatternLibrary::readIndex(std::vector<Entry> &old) {
+    std::ifstream in((directory + "/" + INDEX_FILE).c_str());
+    std::string line;
+    if (!getline(in, line) || line.compare(0, strlen(INDEX_HEADER),
+                                           INDEX_HEADER) != 0) {
+        return false;
+    }
+    long long expected = atoll(line.c_str() + strlen(INDEX_HEADER));
+    while (getline(in, line)) {
+        std::vector<std::string> fields;
+        for (size_t start = 0; fields.size() < 12; ) {
+            size_t tab = line.find('\t', start);
+            fields.push_back(line.substr(start, tab - start));
+            if (tab == std::string::npos) {
+                break;
+            }
+            start = tab + 1;
+        }
+        if (fields.size() != 11) {
+            return false;
+        }
+        Entry e;
+        e.name = fields[0];
+        e.file = fields[1];
+        e.format = fields[2];
+        e.sizeX = atoi(fields[3].c_str());
+        e.sizeY = atoi(fields[4].c_str());
+        e.population = atoll(fields[5].c_str());
+        e.rule = fields[6];
+        e.offset = atoll(fields[7].c_str());
+        e.bytes = atoll(fields[8].c_str());
+        e.fileBytes = atoll(fields[9].c_str());
+        e.modified = atoll(fields[10].c_str());
+        if (e.offset < 0 || e.bytes < 0 || e.offset + e.bytes > expected) {
+            return false;
+        }
+        old.push_back(e);
+    }
+    return mapCache() && static_cast<long long>(cacheLength) == expected;
+}
+
+// map the cache file into memory; false if it cannot be read
+bool PatternLibrary::mapCache() {
+    std::string fileName = directory + "/" + CACHE_FILE;
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void *data = size > 0 ? mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                          : MAP_FAILED;
+    ::close(fd);
+    if (size > 0 && data == MAP_FAILED) {
+        return false;
+    }
+    if (mapping != 0) {
+        munmap(mapping, mappedLength);
+    }
+    mapping = size > 0 ? data : 0;
+    mappedLength = size;
+    cache = static_cast<const char *>(mapping);
+    cacheLength = size;
+    return true;
+}
+
+// write all of a buffer to a file descriptor
+static bool writeAll(int fd, const char *bytes, size_t n) {
+    while (n > 0) {
+        ssize_t done = write(fd, bytes, n < (1u << 30) ? n : (1u << 30));
+        if (done <= 0) {
+            return false;
+        }
+        bytes += done;
+        n -= done;
+    }
+    return true;
+}
+
+// write a file under a temporary name and rename it into place, so a
+// reader never sees half of it
+static bool replaceFile(const std::string &fileName, const std::string &data) {
+    std::string temp = fileName + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = writeAll(fd, data.data(), data.size());
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || rename(temp.c_str(), fileName.c_str()) != 0) {
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// write the cache, then the index naming its length, so an index only
+// ever describes a whole cache
+bool PatternLibrary::writeFiles(const std::string &data) {
+    std::ostringstream index;
+    index << INDEX_HEADER << " " << data.size() << "\n";
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry &e = entries[i];
+        index << e.name << "\t" << e.file << "\t" << e.format << "\t"
+              << e.sizeX << "\t" << e.sizeY << "\t" << e.population << "\t"
+              << e.rule << "\t" << e.offset << "\t" << e.bytes << "\t"
+              << e.fileBytes << "\t" << e.modified << "\n";
+    }
+    return replaceFile(directory + "/" + CACHE_FILE, data) &&
+           replaceFile(directory + "/" + INDEX_FILE, index.str());
+}
+
+
+/*********************************************************************
+ ** Function: open
+ ** Description: Scan a directory for pattern files and index them.
+ ** Parameters: The directory.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The library holds every RLE, Life 1.05, Life 1.06
+ **   and plaintext file (.rle, .lif, .life and .cells) in the
+ **   directory and those below it, sorted by name.  Files whose size
+ **   and modification time match the index are taken from it and the
+ **   cache; the others are read, and if any were, or any were removed,
+ **   the index and cache are written again.  Files that are not
+ **   readable patterns are remembered in the index, so they are not
+ **   read again either, but are not counted among the patterns.
+ **   Returns false, with the reason in getError, if the directory
+ **   cannot be read.
+ *********************************************************************/
+
+bool PatternLibrary::open(const std::string &dir) {
+    close();
+    directory = dir.empty() ? "." : dir;
+    parsed = 0;
+    error = "";
+    DIR *d = opendir(directory.c_str());
+    if (d == 0) {
+        error = directory + ": cannot read directory";
+        return false;
+    }
+    closedir(d);
+
+    std::vector<Entry> found;
+    scan("", found);
+    std::sort(found.begin(), found.end(),
+              [](const Entry &a, const Entry &b) {
+                  return a.name != b.name ? a.name < b.name : a.file < b.file;
+              });
+    std::vector<Entry> old;
+    if (!readIndex(old)) {
+        old.clear();
+    }
+    std::unordered_map<std::string, size_t> known; // old entry of a file
+    for (size_t i = 0; i < old.size(); i++) {
+        known[old[i].file] = i;
+    }
+
+    // take unchanged files from the index, and read the others
+    std::vector<std::string> fresh(found.size());  // cells of files read
+    for (size_t i = 0; i < found.size(); i++) {
+        Entry &e = found[i];
+        std::unordered_map<std::string, size_t>::iterator k = known.find(e.file);
+        if (k != known.end() && old[k->second].fileBytes == e.fileBytes &&
+            old[k->second].modified == e.modified) {
+            e = old[k->second];
+            continue;
+        }
+        parsed++;
+        e.offset = -1;
+        Seed seed;
+        if (seed.readPath(directory + "/" + e.file)) {
+            e.format = seed.getFormat();
+            e.sizeX = seed.getSizeX();
+            e.sizeY = seed.getSizeY();
+            e.population = seed.getLength();
+            e.rule = seed.getRule();
+            if (e.rule.find_first_of("\t\r\n") != std::string::npos) {
+                e.rule = "";
+            }
+            seed.writeBinary(fresh[i]);
+        }
+    }
+    bool changed = parsed > 0 || found.size() != old.size();
+    entries.swap(found);
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!entries[i].format.empty()) {
+            patterns.push_back(static_cast<int>(i));
+        }
+    }
+    if (!changed) {
+        return true;
+    }
+
+    // build a new cache, in name order, of the cells kept and read,
+    // and write it and the index, or keep it in memory if they cannot
+    // be written
+    std::string data;
+    for (size_t i = 0; i < entries.size(); i++) {
+        Entry &e = entries[i];
+        if (e.offset < 0) {
+            e.offset = static_cast<long long>(data.size());
+            e.bytes = static_cast<long long>(fresh[i].size());
+            data.append(fresh[i]);
+        } else {
+            const char *cells = cache + e.offset;
+            e.offset = static_cast<long long>(data.size());
+            data.append(cells, static_cast<size_t>(e.bytes));
+        }
+    }
+    if (mapping != 0) {
+        munmap(mapping, mappedLength);
+        mapping = 0;
+        mappedLength = 0;
+    }
+    if (!writeFiles(data) || !mapCache() || cacheLength != data.size()) {
+        built.swap(data);
+        cache = built.data();
+        cacheLength = built.size();
+    }
+    return true;
+}
+
+// get number of patterns
+int PatternLibrary::getCount() {
+    return static_cast<int>(patterns.size());
+}
+
+// get number of files read from text by the last open, the rest came
+// from the cache
+int PatternLibrary::getParsed() {
+    return parsed;
+}
+
+// get name of the nth pattern, its file name without the extension
+std::string PatternLibrary::getName(int n) {
+    return entries[patterns.at(n)].name;
+}
+
+// get path of the nth pattern's file, including the directory
+std::string PatternLibrary::getFile(int n) {
+    return directory + "/" + entries[patterns.at(n)].file;
+}
+
+// get format of the nth pattern's file: RLE, Life 1.05, Life 1.06 or
+// plaintext
+std::string PatternLibrary::getFormat(int n) {
+    return entries[patterns.at(n)].format;
+}
+
+// get extent of the nth pattern across
+int PatternLibrary::getSizeX(int n) {
+    return entries[patterns.at(n)].sizeX;
+}
+
+// get extent of the nth pattern down
+int PatternLibrary::getSizeY(int n) {
+    return entries[patterns.at(n)].sizeY;
+}
+
+// get number of live (and dying) cells of the nth pattern
+long long PatternLibrary::getPopulation(int n) {
+    return entries[patterns.at(n)].population;
+}
+
+// get rule the nth pattern's file names, empty if none
+std::string PatternLibrary::getRule(int n) {
+    return entries[patterns.at(n)].rule;
+}
+
+// get label of the nth pattern: its name, or, if other patterns share
+// the name (g.rle and g.cells), its path below the directory
+std::string PatternLibrary::getLabel(int n) {
+    const Entry &e = entries[patterns.at(n)];
+    bool shared = (n > 0 && entries[patterns[n - 1]].name == e.name) ||
+                  (n + 1 < getCount() &&
+                   entries[patterns[n + 1]].name == e.name);
+    return shared ? e.file : e.name;
+}
+
+
+/*********************************************************************
+ ** Function: find
+ ** Description: Find a pattern by its label.
+ ** Parameters: The pattern's name, or its path below the directory.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the number of the pattern, -1 if there is
+ **   none, or AMBIGUOUS if several patterns have the name and only
+ **   their paths tell them apart.  The patterns are sorted by name, so
+ **   a name is a binary search; a path is a pass over the index.
+ *********************************************************************/
+
+int PatternLibrary::find(const std::string &label) {
+    std::vector<int>::iterator p = std::lower_bound(
+        patterns.begin(), patterns.end(), label,
+        [this](int e, const std::string &n) { return entries[e].name < n; });
+    if (p != patterns.end() && entries[*p].name == label) {
+        if (p + 1 != patterns.end() && entries[*(p + 1)].name == label) {
+            return AMBIGUOUS;
+        }
+        return static_cast<int>(p - patterns.begin());
+    }
+    for (size_t n = 0; n < patterns.size(); n++) {
+        if (entries[patterns[n]].file == label) {
+            return static_cast<int>(n);
+        }
+    }
+    return -1;
+}
+
+
+/*********************************************************************
+ ** Function: search
+ ** Description: Find patterns by part of their name and their size.
+ ** Parameters: Text the name must contain, ignoring case (empty for
+ **   any name), the most cells across and down (0 for any), and the
+ **   list to put the numbers of the patterns found in.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The list holds the patterns found, in name order.
+ **   Only the index in memory is searched; no file is read.
+ *********************************************************************/
+
+void PatternLibrary::search(const std::string &text, int maxX, int maxY,
+                            std::vector<int> &found) {
+    found.clear();
+    std::string lower = text;
+    for (size_t i = 0; i < lower.size(); i++) {
+        lower[i] = static_cast<char>(tolower(lower[i]));
+    }
+    std::string name;
+    for (size_t n = 0; n < patterns.size(); n++) {
+        const Entry &e = entries[patterns[n]];
+        if ((maxX > 0 && e.sizeX > maxX) || (maxY > 0 && e.sizeY > maxY)) {
+            continue;
+        }
+        name = e.name;
+        for (size_t i = 0; i < name.size(); i++) {
+            name[i] = static_cast<char>(tolower(name[i]));
+        }
+        if (name.find(lower) != std::string::npos) {
+            found.push_back(static_cast<int>(n));
+        }
+    }
+}
+
+
+/*********************************************************************
+ ** Function: load
+ ** Description: Read a pattern from the cache.
+ ** Parameters: Number of the pattern, and the seed to read it into.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The seed holds the pattern's cells, where reading
+ **   its file would have put them, and its rule.  Returns false, with
+ **   the reason in getError, if the number is not a pattern's or its
+ **   cells in the cache are damaged.
+ *********************************************************************/
+
+bool PatternLibrary::load(int n, Seed &seed) {
+    if (n < 0 || n >= getCount()) {
+        error = "no such pattern";
+        return false;
+    }
+    const Entry &e = entries[patterns[n]];
+    if (!seed.readBinary(cache + e.offset, static_cast<size_t>(e.bytes))) {
+        error = directory + "/" + CACHE_FILE + ": " + e.name + ": " +
+                seed.getError();
+        return false;
+    }
+    return true;
+}
+
+// get what went wrong with the last open or load
+std::string PatternLibrary::getError() {
+    return error;
+}
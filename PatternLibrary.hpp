@@ -0,0 +1,87 @@
+/*********************************************************************
+ ** Program Filename: PatternLibrary.hpp, PatternLibrary class
+ **   specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Library of the seed patterns in a directory and the
+ **   directories under it.  The first time a directory is opened each
+ **   pattern file is read once, and two files are left in the
+ **   directory: an index, a line of text per pattern giving its name,
+ **   file, format, dimensions, population, rule and the offset of its
+ **   cells in the cache, and the cache, the cells of every pattern in
+ **   Seed's compact binary form.  Opening the directory again reads
+ **   the index, maps the cache into memory and reads only the files
+ **   added or changed since (by size and modification time), so
+ **   choosing or loading a pattern is a lookup rather than a parse,
+ **   and finding patterns by name or size is a pass over the index in
+ **   memory.  Where the directory cannot be written the cache is kept
+ **   in memory for the run.
+ ** Input: directory of pattern files, index and cache files
+ ** Output: index and cache files, pattern names and dimensions,
+ **   patterns found by name or size, patterns read from the cache
+ *********************************************************************/
+
+#ifndef PatternLibrary_hpp
+#define PatternLibrary_hpp
+
+#include <string>   // header file for string objects
+#include <vector>   // header file for vector objects
+#include <cstddef>  // header file for size_t
+#include "Seed.hpp"
+
+class PatternLibrary {
+private:
+    struct Entry {
+        std::string name;       // file name without its extension
+        std::string file;       // path below the directory
+        std::string format;     // format of the file, empty if unreadable
+        int sizeX, sizeY;       // extent of the pattern
+        long long population;   // live and dying cells
+        std::string rule;       // rule named in the file, if any
+        long long offset;       // where the cells are in the cache
+        long long bytes;        // length of the cells in the cache
+        long long fileBytes;    // size of the file when read
+        long long modified;     // its modification time, nanoseconds
+    };
+    std::string directory;      // directory of pattern files
+    std::vector<Entry> entries; // every file, sorted by name
+    std::vector<int> patterns;  // entries that are readable patterns
+    void *mapping;              // cache file mapped into memory
+    size_t mappedLength;        // bytes of the mapping
+    std::string built;          // cache built in memory, if not written
+    const char *cache;          // cells of the patterns
+    size_t cacheLength;         // bytes of the cells
+    int parsed;                 // files read by the last open
+    std::string error;          // what went wrong, if anything
+    void close();               // forget the patterns and unmap the cache
+    void scan(const std::string &, std::vector<Entry> &); // list files
+    bool readIndex(std::vector<Entry> &);   // read the index file
+    bool mapCache();                        // map the cache file
+    bool writeFiles(const std::string &);   // write the index and cache
+    PatternLibrary(const PatternLibrary &);             // not copyable
+    PatternLibrary &operator=(const PatternLibrary &);  // not assignable
+public:
+    static const char *INDEX_FILE;  // name of the index in the directory
+    static const char *CACHE_FILE;  // name of the cache in the directory
+    static const int AMBIGUOUS = -2;    // find: several patterns of a name
+    PatternLibrary();               // constructor
+    ~PatternLibrary();              // destructor
+    bool open(const std::string &); // scan a directory
+    int getCount();                 // get number of patterns
+    int getParsed();                // get files read by the last open
+    std::string getName(int);       // get name of the nth pattern
+    std::string getLabel(int);      // get name, or path if not unique
+    std::string getFile(int);       // get its path
+    std::string getFormat(int);     // get its file format
+    int getSizeX(int);              // get its extent across
+    int getSizeY(int);              // get its extent down
+    long long getPopulation(int);   // get its number of cells
+    std::string getRule(int);       // get the rule its file names
+    int find(const std::string &);  // get number of a pattern by label
+    void search(const std::string &, int, int, std::vector<int> &); // find
+                                    // patterns by part of name and size
+    bool load(int, Seed &);         // read a pattern from the cache
+    std::string getError();         // get what went wrong
+};
+
+#endif /* PatternLibrary_hpp */
@@ -0,0 +1,178 @@
+/*********************************************************************
+ ** Program Filename: Renderer.cpp, Renderer class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Renderer class implementation, draws the visible part
+ **   of a Game of Life universe on an ANSI terminal.  Each frame is
+ **   built in one buffer and written at once, and only characters
+ **   that changed since the previous frame are redrawn.  Cells are
+ **   shown one per character, or 2 x 4 per Unicode braille character
+ **   so large boards fit on the terminal.
+ ** Input: engine, location of the screen in the universe, time step
+ ** Output: time step and visible cells drawn on the terminal
+ *********************************************************************/
+
+#include "Renderer.hpp"
+#include "Trace.hpp"
+#include <iostream> // header file for input and output stream objects
+#include <cstdio>   // header file for snprintf
+
+// bit of a braille character for the cell at column dx, row dy of the
+// 2 x 4 block it shows (Unicode dots 1-8)
+static const unsigned char DOTS[4][2] = {
+    { 0x01, 0x08 }, { 0x02, 0x10 }, { 0x04, 0x20 }, { 0x40, 0x80 }
+};
+
+
+/*********************************************************************
+ ** Function:  Renderer
+ ** Description:  Renderer class constructor
+ ** Parameters: Number of visible cells in the x and y directions and
+ **   whether to show 2 x 4 cells per braille character.
+ ** Pre-Conditions: none
+ ** Post-Conditions:  The first frame will redraw the whole screen.
+ *********************************************************************/
+
+Renderer::Renderer(int ncol, int nrow, bool b) : window(ncol, nrow) {
+    braille = b;
+    cols = braille ? (ncol + 1) / 2 : ncol;
+    rows = braille ? (nrow + 3) / 4 : nrow;
+    shown.assign(cols * rows, 0);
+    next.assign(cols * rows, 0);
+    valid = false;
+}
+
+// get x dimension of visible cells
+int Renderer::getSizeX() {
+    return window.getSizeX();
+}
+
+// get y dimension of visible cells
+int Renderer::getSizeY() {
+    return window.getSizeY();
+}
+
+// get number of hidden cells of the grid
+int Renderer::getHide() {
+    return window.getHide();
+}
+
+// redraw the whole screen next time, after other output has been
+// written to the terminal
+void Renderer::invalidate() {
+    valid = false;
+}
+
+// add cursor movement to a row and column of the screen (from 1)
+void Renderer::moveTo(int row, int col) {
+    char code[32];
+    int n = snprintf(code, sizeof(code), "\033[%d;%dH", row, col);
+    frame.append(code, n);
+}
+
+// add the text of a character code to the frame: a cell state, or the
+// dots of a braille character encoded as UTF-8
+void Renderer::addChar(unsigned char c) {
+    if (c == 0) {
+        frame += ' ';
+    } else if (!braille) {
+        frame += '@';
+    } else {
+        frame += static_cast<char>(0xE2);
+        frame += static_cast<char>(0xA0 | (c >> 6));
+        frame += static_cast<char>(0x80 | (c & 0x3F));
+    }
+}
+
+
+/*********************************************************************
+ ** Function: draw
+ ** Description: Display the time step and the visible cells of an
+ **   engine, writing only the characters that changed since the
+ **   previous frame.
+ ** Parameters: Engine, universe coordinates of the top left cell on
+ **   screen and the time step.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The screen shows the frame, with the cursor on the
+ **   line below it.
+ *********************************************************************/
+
+void Renderer::draw(Engine &engine, long long x0, long long y0,
+                    long long tick) {
+    {
+        ScopedTimer timer(RENDER_TIMER);
+        engine.exportWindow(window, x0, y0);
+    }
+    show(window, tick, "");
+}
+
+
+/*********************************************************************
+ ** Function: show
+ ** Description: Display a time step and cells already copied out of an
+ **   engine, writing only the characters that changed since the
+ **   previous frame.
+ ** Parameters: Grid holding the visible cells, as exportWindow fills
+ **   it, the time step, and a status to show after it.
+ ** Pre-Conditions: The grid has the dimensions of the screen.
+ ** Post-Conditions: The screen shows the frame, with the cursor on the
+ **   line below it.
+ *********************************************************************/
+
+void Renderer::show(Grid &cells, long long tick, const std::string &status) {
+    ScopedTimer timer(RENDER_TIMER);
+
+    // character codes of the new frame
+    int h = cells.getHide();
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            unsigned char code = 0;
+            if (!braille) {
+                code = cells.getState(h + 1 + c, h + 1 + r);
+            } else {
+                for (int dy = 0; dy < 4 && 4*r + dy < cells.getSizeY(); dy++) {
+                    for (int dx = 0; dx < 2 && 2*c + dx < cells.getSizeX(); dx++) {
+                        if (cells.getState(h + 1 + 2*c + dx, h + 1 + 4*r + dy)) {
+                            code |= DOTS[dy][dx];
+                        }
+                    }
+                }
+            }
+            next[r*cols + c] = code;
+        }
+    }
+
+    // build the frame: time step, then the changed characters, moving
+    // the cursor only where a run of changes starts
+    frame.clear();
+    if (!valid) {
+        frame += "\033[H\033[2J";
+    }
+    char text[48];
+    int n = snprintf(text, sizeof(text), "\033[1;1HTick = %lld", tick);
+    frame.append(text, n);
+    frame += status;
+    frame += "\033[K";
+    for (int r = 0; r < rows; r++) {
+        int cursor = -1;    // column the cursor is at on this row
+        for (int c = 0; c < cols; c++) {
+            unsigned char code = next[r*cols + c];
+            if (valid && code == shown[r*cols + c]) {
+                continue;
+            }
+            if (c != cursor) {
+                moveTo(r + 2, c + 1);
+            }
+            addChar(code);
+            cursor = c + 1;
+        }
+    }
+    moveTo(rows + 2, 1);
+    shown.swap(next);
+    valid = true;
+
+    // write it at once
+    std::cout.write(frame.data(), frame.size());
+    std::cout.flush();
+    Trace::count(BYTES_COUNTER, frame.size());
+}
@@ -0,0 +1,48 @@
+/*********************************************************************
+ ** Program Filename: Renderer.hpp, Renderer class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Renderer class specification, draws the visible part
+ **   of a Game of Life universe on an ANSI terminal.  Each frame is
+ **   built in one buffer and written at once, and only characters
+ **   that changed since the previous frame are redrawn.  Cells are
+ **   shown one per character, or 2 x 4 per Unicode braille character
+ **   so large boards fit on the terminal.
+ ** Input: engine, location of the screen in the universe, or cells
+ **   copied out of it, time step
+ ** Output: time step and visible cells drawn on the terminal
+ *********************************************************************/
+
+#ifndef Renderer_hpp
+#define Renderer_hpp
+
+#include <string>   // header file for string objects
+#include <vector>   // header file for vectors
+#include "Grid.hpp"
+#include "Engine.hpp"
+
+class Renderer {
+private:
+    Grid window;            // visible cells
+    bool braille;           // 2 x 4 cells per character
+    int cols, rows;         // characters used to show the cells
+    std::vector<unsigned char> shown;   // character on screen at each place
+    std::vector<unsigned char> next;    // character of the frame being built
+    bool valid;             // true if the screen holds the previous frame
+    std::string frame;      // text written to the terminal
+    void moveTo(int, int);  // add cursor movement to the frame
+    void addChar(unsigned char); // add a character to the frame
+    Renderer(const Renderer &);             // not copyable
+    Renderer &operator=(const Renderer &);  // not assignable
+public:
+    Renderer(int, int, bool);   // constructor
+    int getSizeX();             // get x dimension of visible cells
+    int getSizeY();             // get y dimension of visible cells
+    int getHide();              // get number of hidden cells of the grid
+    void invalidate();          // redraw the whole screen next time
+    void draw(Engine &, long long, long long, long long); // show a frame
+    void show(Grid &, long long, const std::string &);  // show cells
+                                                        // copied out
+};
+
+#endif /* Renderer_hpp */
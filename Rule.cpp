@@ -0,0 +1,245 @@
+/*********************************************************************
+ ** Program Filename: Rule.cpp, Rule class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Rule class implementation, the rule a Game of Life
+ **   simulation follows: birth and survival neighbor counts, number
+ **   of states and neighborhood, read from B/S, S/B or Generations
+ **   rule strings.
+ ** Input: rule string
+ ** Output: birth and survival counts, number of states, neighborhood,
+ **   next state of a cell, canonical rule string
+ *********************************************************************/
+
+#include "Rule.hpp"
+#include <vector>   // header file for vector objects
+#include <cctype>   // header file for character classes
+#include <cstdlib>  // header file for atoi
+
+
+/*********************************************************************
+ ** Function:  Rule
+ ** Description:  Rule class constructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions:  The rule is Conway's Life, B3/S23.
+ *********************************************************************/
+
+Rule::Rule() {
+    birth = 1 << 3;
+    survive = (1 << 2) | (1 << 3);
+    states = 2;
+    neighborhood = MOORE;
+}
+
+// note what is wrong with the rule being read; returns false
+bool Rule::fail(const std::string &reason) {
+    error = "rule '" + text + "': " + reason;
+    return false;
+}
+
+// read a list of neighbor counts, each a digit no more than max, into
+// the bits of counts
+bool Rule::readCounts(const std::string &digits, int max, int &counts) {
+    counts = 0;
+    for (size_t i = 0; i < digits.size(); i++) {
+        if (!isdigit(static_cast<unsigned char>(digits[i]))) {
+            return fail(std::string("unexpected character '") + digits[i] +
+                        "'");
+        }
+        int n = digits[i] - '0';
+        if (n > max) {
+            return fail(std::string("a cell has only ") +
+                        static_cast<char>('0' + max) + " neighbors");
+        }
+        counts |= 1 << n;
+    }
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: parse
+ ** Description: Read a rule string: B/S notation (B36/S23), S/B
+ **   notation (23/36), or either with a third part giving the number
+ **   of states of a Generations rule (B2/S/C3, /2/3), optionally
+ **   followed by V for the von Neumann neighborhood or H for the
+ **   hexagonal one.  Letters may be upper or lower case.
+ ** Parameters: Rule string.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false, leaving the rule unchanged, if the
+ **   string is not a rule this program can run; getError tells why.
+ *********************************************************************/
+
+bool Rule::parse(const std::string &rule) {
+    text = rule;
+    size_t first = rule.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return fail("empty rule");
+    }
+    std::string s = rule.substr(first,
+                                rule.find_last_not_of(" \t\r\n") + 1 - first);
+
+    // neighborhood suffix
+    Neighborhood n = MOORE;
+    char last = static_cast<char>(toupper(s[s.size() - 1]));
+    if (last == 'V') {
+        n = VON_NEUMANN;
+        s.erase(s.size() - 1);
+    } else if (last == 'H') {
+        n = HEXAGONAL;
+        s.erase(s.size() - 1);
+    }
+    int max = n == MOORE ? 8 : (n == VON_NEUMANN ? 4 : 6);
+
+    // parts between slashes, each named by its letter or its place
+    std::vector<std::string> parts;
+    size_t start = 0;
+    for (size_t slash; (slash = s.find('/', start)) != std::string::npos;
+         start = slash + 1) {
+        parts.push_back(s.substr(start, slash - start));
+    }
+    parts.push_back(s.substr(start));
+    if (parts.size() < 2 || parts.size() > 3) {
+        return fail("expected B/S, S/B or Generations notation");
+    }
+    int b = -1, sv = -1, c = -1;
+    for (size_t i = 0; i < parts.size(); i++) {
+        std::string part = parts[i];
+        char k = part.empty() ? 0 : static_cast<char>(toupper(part[0]));
+        if (k == 'B' || k == 'S' || k == 'C' || k == 'G') {
+            part.erase(0, 1);
+        } else {
+            k = "SBC"[i];
+        }
+        int *field = k == 'B' ? &b : (k == 'S' ? &sv : &c);
+        if (*field >= 0) {
+            return fail(std::string("more than one ") + k + " part");
+        }
+        if (k == 'B' || k == 'S') {
+            if (!readCounts(part, max, *field)) {
+                return false;
+            }
+        } else {
+            if (part.empty() ||
+                part.find_first_not_of("0123456789") != std::string::npos) {
+                return fail("the number of states must be a number");
+            }
+            *field = part.size() > 3 ? MAX_STATES + 1 : atoi(part.c_str());
+            if (*field < 2 || *field > MAX_STATES) {
+                return fail("the number of states must be 2 to 256");
+            }
+        }
+    }
+    if (b < 0 || sv < 0) {
+        return fail("expected B/S, S/B or Generations notation");
+    }
+
+    // with B0 every dead cell far from the pattern would be born, so
+    // an unbounded universe would fill at once
+    if (b & 1) {
+        return fail("rules with B0 are not supported");
+    }
+
+    birth = b;
+    survive = sv;
+    states = c < 0 ? 2 : c;
+    neighborhood = n;
+    error = "";
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: getName
+ ** Description: Get the rule in B/S notation.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the rule as B, the birth counts, /S, the
+ **   survival counts, then /C and the number of states for a
+ **   Generations rule and V or H for the von Neumann or hexagonal
+ **   neighborhood, e.g. B3/S23, B2/S/C3 or B2/S34H.
+ *********************************************************************/
+
+std::string Rule::getName() {
+    std::string name = "B";
+    for (int n = 0; n <= 8; n++) {
+        if (birth & (1 << n)) {
+            name += static_cast<char>('0' + n);
+        }
+    }
+    name += "/S";
+    for (int n = 0; n <= 8; n++) {
+        if (survive & (1 << n)) {
+            name += static_cast<char>('0' + n);
+        }
+    }
+    if (states > 2) {
+        name += "/C" + std::to_string(states);
+    }
+    if (neighborhood == VON_NEUMANN) {
+        name += 'V';
+    } else if (neighborhood == HEXAGONAL) {
+        name += 'H';
+    }
+    return name;
+}
+
+// get birth counts: bit n is set if a dead cell with n live
+// neighbors is born
+int Rule::getBirth() {
+    return birth;
+}
+
+// get survival counts: bit n is set if a live cell with n live
+// neighbors survives
+int Rule::getSurvive() {
+    return survive;
+}
+
+// get number of cell states: dead, live and any dying states
+int Rule::getStates() {
+    return states;
+}
+
+// get cells counted as neighbors
+Neighborhood Rule::getNeighborhood() {
+    return neighborhood;
+}
+
+// get number of cells counted as neighbors
+int Rule::getNeighbors() {
+    return neighborhood == MOORE ? 8 : (neighborhood == VON_NEUMANN ? 4 : 6);
+}
+
+// true for Conway's Life, which the fastest kernels are written for
+bool Rule::isLife() {
+    return birth == (1 << 3) && survive == ((1 << 2) | (1 << 3)) &&
+           states == 2 && neighborhood == MOORE;
+}
+
+
+/*********************************************************************
+ ** Function: next
+ ** Description: Apply the rule to one cell.
+ ** Parameters: State of the cell (0 dead, 1 live, 2 and up dying) and
+ **   its number of live neighbors.
+ ** Pre-Conditions: The state is less than getStates() and the count
+ **   no more than getNeighbors().
+ ** Post-Conditions: Returns the state of the cell next time step.
+ *********************************************************************/
+
+int Rule::next(int state, int count) {
+    if (state == 0) {
+        return (birth >> count) & 1;
+    }
+    if (state == 1 && ((survive >> count) & 1)) {
+        return 1;
+    }
+    return state + 1 < states ? state + 1 : 0;
+}
+
+// get what was wrong with the last rule string read
+std::string Rule::getError() {
+    return error;
+}
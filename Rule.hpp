@@ -0,0 +1,54 @@
+/*********************************************************************
+ ** Program Filename: Rule.hpp, Rule class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Rule class specification, the rule a Game of Life
+ **   simulation follows.  Outer-totalistic rules are written in B/S
+ **   notation, the numbers of live neighbors for a dead cell to be
+ **   born and a live cell to survive (Conway's Life is B3/S23), or
+ **   the older S/B form (23/3).  Generations rules add a number of
+ **   states (B2/S/C3 or /2/3): a live cell that does not survive
+ **   spends the extra states dying before it is dead, and only live
+ **   cells count as neighbors.  A V suffix counts the four orthogonal
+ **   (von Neumann) neighbors and an H suffix the six neighbors of a
+ **   hexagonal grid drawn on a square one, instead of all eight.
+ ** Input: rule string
+ ** Output: birth and survival counts, number of states, neighborhood,
+ **   next state of a cell, canonical rule string
+ *********************************************************************/
+
+#ifndef Rule_hpp
+#define Rule_hpp
+
+#include <string>   // header file for string objects
+
+// cells counted as neighbors: all eight, the four orthogonal ones, or
+// all but the north-east and south-west ones (a hexagonal grid)
+enum Neighborhood { MOORE, VON_NEUMANN, HEXAGONAL };
+
+class Rule {
+private:
+    int birth;      // bit n set: a dead cell with n neighbors is born
+    int survive;    // bit n set: a live cell with n neighbors survives
+    int states;     // number of cell states, more than 2 for Generations
+    Neighborhood neighborhood;  // cells counted as neighbors
+    std::string text;           // rule string being read
+    std::string error;          // what was wrong with the last rule read
+    bool fail(const std::string &); // note what is wrong with the rule
+    bool readCounts(const std::string &, int, int &); // read counts
+public:
+    static const int MAX_STATES = 256;  // most states of a cell
+    Rule();                         // constructor, Conway's Life
+    bool parse(const std::string &); // read a rule string
+    std::string getName();          // get rule in B/S notation
+    int getBirth();                 // get birth counts as bits
+    int getSurvive();               // get survival counts as bits
+    int getStates();                // get number of cell states
+    Neighborhood getNeighborhood(); // get cells counted as neighbors
+    int getNeighbors();             // get number of neighbors
+    bool isLife();                  // true for Conway's Life
+    int next(int, int);             // next state of a cell
+    std::string getError();         // get what was wrong with a rule
+};
+
+#endif /* Rule_hpp */
@@ -9,6 +9,16 @@
  *********************************************************************/
 
 #include "Seed.hpp"
+#include "Trace.hpp"
+#include <sstream>      // header file for string streams
+#include <algorithm>    // header file for sort
+#include <stdint.h>     // header file for fixed width integer types
+#include <cstdlib>      // header file for strtol
+#include <cstring>      // header file for strncmp
+#include <fcntl.h>      // header file for open
+#include <unistd.h>     // header file for read and close
+#include <sys/mman.h>   // header file for mmap
+#include <sys/stat.h>   // header file for fstat
 
 /*********************************************************************
  ** Function:  Seed
@@ -20,9 +30,10 @@
  *********************************************************************/
 
 Seed::Seed() {
-    sizeX = 0;      // extent of pattern in the x direction
-    sizeY = 0;      // extent of pattern in the y direction
-    length = 0;     // number of live cell coordinates in the pattern
+    clear();
+    line = 0;
+    next = 0;
+    end = 0;
 }
 
 
@@ -33,62 +44,556 @@ Seed::Seed() {
  ** Pre-Conditions: The requested *.lif file must be in the same 
  **   directory as the executable.
  ** Post-Conditions:  The coordinates of the live cells in the pattern
- **   will be read into a vector.
- *********************************************************************/
-
-void Seed::readFile(std::string name) {
-        
-    // open the file
-    std::string fileName = name + "_106.lif";
-    std::ifstream inputFile;
-    inputFile.open(fileName.c_str());
-    
-    // read the header line
-    std::string header;
-    getline(inputFile,header);
-    
-    // read the coordinates from file
-    coord myCoord;
-    pattern.clear();
-    while (inputFile >> myCoord.x >> myCoord.y) {
-        pattern.push_back(myCoord);
-    }
-    inputFile.close();
-    
-    // calculate the length of the pattern and extent in x and y dimensions
-    std::sort(pattern.begin(), pattern.end(), byX);
-    sizeX = pattern.back().x - pattern.front().x + 1;
-    std::sort(pattern.begin(), pattern.end(), byY);
-    sizeY = pattern.back().y - pattern.front().y + 1;
+ **   will be read into a vector.  Returns false if the file could not
+ **   be read.
+ *********************************************************************/
+
+bool Seed::readFile(std::string name) {
+    return readPath(name + "_106.lif");
+}
+
+
+/*********************************************************************
+ ** Function: readPath
+ ** Description: Read seed pattern from a file in any of the supported
+ **   formats.  The file is mapped into memory rather than streamed.
+ ** Parameters: String with the file name, including any directory.
+ ** Pre-Conditions: none
+ ** Post-Conditions:  The coordinates of the live cells in the pattern
+ **   will be read into a vector.  Returns false, leaving an empty
+ **   pattern and a description of the problem in getError, if the
+ **   file could not be read, is malformed or has no live cells.
+ *********************************************************************/
+
+bool Seed::readPath(std::string fileName) {
+    ScopedTimer timer(READ_TIMER);
+    clear();
+    int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        error = fileName + ": cannot open file";
+        return false;
+    }
+    bool ok;
+    size_t size = static_cast<size_t>(info.st_size);
+    void *data = size > 0 ? mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                          : MAP_FAILED;
+    if (data != MAP_FAILED) {
+        ok = readText(static_cast<const char *>(data), size);
+        munmap(data, size);
+    } else {
+        // not mappable (empty, or a pipe): read it the slow way
+        std::string text;
+        char buffer[65536];
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+            text.append(buffer, n);
+        }
+        ok = readText(text.data(), text.size());
+    }
+    close(fd);
+    if (!ok) {
+        error = fileName + ": " + error;
+    }
+    return ok;
+}
+
+
+/*********************************************************************
+ ** Function: readText
+ ** Description: Read seed pattern from text in memory.  The format is
+ **   detected from the text: Life 1.06 and Life 1.05 by their header
+ **   lines, RLE by its "x = .., y = .." line after any # comments,
+ **   and plaintext by rows of '.' and 'O' after any ! comments.
+ **   Patterns without an origin of their own (RLE and plaintext) are
+ **   centered on 0, 0.
+ ** Parameters: The text and its length in bytes.
+ ** Pre-Conditions: none
+ ** Post-Conditions:  The coordinates of the live cells in the pattern
+ **   will be read into a vector, with their extent found in the same
+ **   pass.  Returns false, leaving an empty pattern and a description
+ **   of the problem, with its line number, in getError, if the text is
+ **   malformed or has no live cells.
+ *********************************************************************/
+
+bool Seed::readText(const char *text, size_t n) {
+    clear();
+    next = text;
+    end = text + n;
+    line = 1;
+
+    // find the first line that is not a comment or blank; the Life
+    // 1.05 and 1.06 headers are # lines themselves
+    const char *p = text;
+    while (p < end && !startsWith(p, "#Life") &&
+           (*p == '#' || *p == '!' || *p == '\n' || *p == '\r')) {
+        while (p < end && *p != '\n') {
+            p++;
+        }
+        if (p < end) {
+            p++;
+        }
+    }
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+
+    bool ok;
+    if (startsWith(p, "#Life 1.06")) {
+        ok = readLife106();
+        format = "Life 1.06";
+    } else if (startsWith(p, "#Life 1.05")) {
+        ok = readLife105();
+        format = "Life 1.05";
+    } else if (p < end && *p == 'x') {
+        ok = readRle();
+        format = "RLE";
+    } else if (p < end && (*p == '.' || *p == 'O' || *p == 'o' || *p == '*')) {
+        ok = readCells();
+        format = "plaintext";
+    } else {
+        ok = fail("unrecognized pattern format (expected RLE, Life 1.05, "
+                  "Life 1.06 or plaintext)");
+    }
+    if (ok && pattern.empty()) {
+        error = "pattern has no live cells";
+        ok = false;
+    }
+    if (!ok) {
+        std::string message = error;
+        clear();
+        error = message;
+        return false;
+    }
+    sizeX = maxX - minX + 1;
+    sizeY = maxY - minY + 1;
     length = static_cast<int>(pattern.size());
+    return true;
 }
 
 
 /*********************************************************************
- ** Function: byX
- ** Description:  Compares the x coordinates of two points.
- ** Parameters:  The coordinates of two points.
- ** Pre-Conditions:  The coordinates must have been initialized.
- ** Post-Conditions: Returns true if the first x coordinate is larger
- *    than the second, false otherwise.
+ ** Function: writeBinary
+ ** Description: Write the pattern in a compact binary form, which
+ **   readBinary reads back without parsing any text.
+ ** Parameters: String to append the bytes to.
+ ** Pre-Conditions: A pattern has been read.
+ ** Post-Conditions: The form is a header of 32-bit integers (cells,
+ **   top left corner, extent, whether any cell is dying and the length
+ **   of the rule), the rule, then each cell as a pair of 32-bit
+ **   offsets from the corner, row by row, and, only if a cell is
+ **   dying, a byte of state per cell.  Integers are in this machine's
+ **   byte order.
  *********************************************************************/
 
-bool Seed::byX(coord c1, coord c2) {
-    return (c1.x < c2.x);
+void Seed::writeBinary(std::string &out) {
+    std::vector<coord> cells = pattern;
+    std::sort(cells.begin(), cells.end(), [](const coord &a, const coord &b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+    bool dying = false;
+    for (size_t i = 0; i < cells.size(); i++) {
+        dying = dying || cells[i].state != 1;
+    }
+    int32_t header[7] = { static_cast<int32_t>(cells.size()), minX, minY,
+                          sizeX, sizeY, dying,
+                          static_cast<int32_t>(rule.size()) };
+    out.append(reinterpret_cast<const char *>(header), sizeof(header));
+    out.append(rule);
+    for (size_t i = 0; i < cells.size(); i++) {
+        uint32_t offset[2] = { static_cast<uint32_t>(cells[i].x - minX),
+                               static_cast<uint32_t>(cells[i].y - minY) };
+        out.append(reinterpret_cast<const char *>(offset), sizeof(offset));
+    }
+    for (size_t i = 0; dying && i < cells.size(); i++) {
+        out.push_back(static_cast<char>(cells[i].state));
+    }
 }
 
 
 /*********************************************************************
- ** Function: byY
- ** Description:  Compares the y coordinates of two points.
- ** Parameters:  The coordinates of two points.
- ** Pre-Conditions:  The coordinates must have been initialized.
- ** Post-Conditions: Returns true if the first y coordinate is larger
- *    than the second, false otherwise.
+ ** Function: readBinary
+ ** Description: Read a pattern from the binary form of writeBinary.
+ ** Parameters: The bytes and their number.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The pattern, its extent and rule are as they were
+ **   when written, and its cells are in row order.  Returns false,
+ **   leaving an empty pattern and the reason in getError, if the bytes
+ **   are not a whole binary form.
  *********************************************************************/
 
-bool Seed::byY(coord c1, coord c2) {
-    return (c1.y < c2.y);
+bool Seed::readBinary(const char *bytes, size_t n) {
+    clear();
+    int32_t header[7];
+    if (n < sizeof(header)) {
+        error = "truncated binary pattern";
+        return false;
+    }
+    memcpy(header, bytes, sizeof(header));
+    size_t count = static_cast<uint32_t>(header[0]);
+    size_t ruleLength = static_cast<uint32_t>(header[6]);
+    bool dying = header[5] != 0;
+    if (count == 0 || n != sizeof(header) + ruleLength +
+                          count * (2*sizeof(uint32_t) + (dying ? 1 : 0))) {
+        error = "truncated binary pattern";
+        return false;
+    }
+    const char *p = bytes + sizeof(header);
+    rule.assign(p, ruleLength);
+    p += ruleLength;
+    const char *states = p + count * 2*sizeof(uint32_t);
+    pattern.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t offset[2];
+        memcpy(offset, p + i * sizeof(offset), sizeof(offset));
+        pattern[i].x = header[1] + static_cast<int>(offset[0]);
+        pattern[i].y = header[2] + static_cast<int>(offset[1]);
+        pattern[i].state = dying ? static_cast<unsigned char>(states[i]) : 1;
+    }
+    minX = header[1];
+    minY = header[2];
+    sizeX = header[3];
+    sizeY = header[4];
+    maxX = minX + sizeX - 1;
+    maxY = minY + sizeY - 1;
+    length = static_cast<int>(count);
+    return true;
+}
+
+// empty the pattern, forgetting its rule and any error
+void Seed::clear() {
+    pattern.clear();
+    sizeX = 0;      // extent of pattern in the x direction
+    sizeY = 0;      // extent of pattern in the y direction
+    length = 0;     // number of live cell coordinates in the pattern
+    minX = minY = 0;
+    maxX = maxY = -1;
+    rule = "";
+    format = "";
+    error = "";
+}
+
+// add a live (or dying) cell, widening the bounds; false if it is too
+// far out
+bool Seed::addCell(long long x, long long y, int state) {
+    if (x < -LIMIT || x > LIMIT || y < -LIMIT || y > LIMIT) {
+        return fail("cell coordinates out of range");
+    }
+    coord c;
+    c.x = static_cast<int>(x);
+    c.y = static_cast<int>(y);
+    c.state = state;
+    if (pattern.empty()) {
+        minX = maxX = c.x;
+        minY = maxY = c.y;
+    } else {
+        minX = c.x < minX ? c.x : minX;
+        maxX = c.x > maxX ? c.x : maxX;
+        minY = c.y < minY ? c.y : minY;
+        maxY = c.y > maxY ? c.y : maxY;
+    }
+    pattern.push_back(c);
+    return true;
+}
+
+// note an error on the current line; always false
+bool Seed::fail(const std::string &message) {
+    std::ostringstream text;
+    text << "line " << line << ": " << message;
+    error = text.str();
+    return false;
+}
+
+// read an optionally signed integer after any spaces; false if there
+// are no digits.  Values too large for a coordinate are capped.
+bool Seed::readInt(long long &value) {
+    while (next < end && (*next == ' ' || *next == '\t')) {
+        next++;
+    }
+    bool negative = false;
+    if (next < end && (*next == '-' || *next == '+')) {
+        negative = *next == '-';
+        next++;
+    }
+    if (next == end || *next < '0' || *next > '9') {
+        return false;
+    }
+    value = 0;
+    while (next < end && *next >= '0' && *next <= '9') {
+        if (value < (1LL << 40)) {
+            value = 10*value + (*next - '0');
+        }
+        next++;
+    }
+    if (negative) {
+        value = -value;
+    }
+    return true;
+}
+
+// true if the text at p starts with a prefix
+bool Seed::startsWith(const char *p, const char *prefix) {
+    size_t n = strlen(prefix);
+    return static_cast<size_t>(end - p) >= n && strncmp(p, prefix, n) == 0;
+}
+
+// move to the start of the next line
+void Seed::skipLine() {
+    while (next < end && *next != '\n') {
+        next++;
+    }
+    if (next < end) {
+        next++;
+        line++;
+    }
+}
+
+// read Life 1.06: a header line, then one "x y" pair per line
+bool Seed::readLife106() {
+    while (next < end && !startsWith(next, "#Life")) {
+        skipLine();
+    }
+    skipLine();
+    while (next < end) {
+        while (next < end && (*next == ' ' || *next == '\t' || *next == '\r')) {
+            next++;
+        }
+        if (next < end && *next == '#') {
+            skipLine();
+            continue;
+        }
+        if (next == end || *next == '\n') {
+            skipLine();
+            continue;
+        }
+        long long x, y;
+        if (!readInt(x) || !readInt(y)) {
+            return fail("expected a pair of cell coordinates");
+        }
+        while (next < end && (*next == ' ' || *next == '\t' || *next == '\r')) {
+            next++;
+        }
+        if (next < end && *next != '\n') {
+            return fail("unexpected text after cell coordinates");
+        }
+        if (!addCell(x, y)) {
+            return false;
+        }
+        skipLine();
+    }
+    return true;
+}
+
+// read Life 1.05: a header line, # lines for the description, rule
+// (#N for the normal rule, #R for another) and the position of each
+// block of cells (#P x y), then rows of '.' and '*'
+bool Seed::readLife105() {
+    while (next < end && !startsWith(next, "#Life")) {
+        skipLine();
+    }
+    skipLine();
+    long long x0 = 0, y0 = 0, row = 0; // block position and current row
+    bool positioned = false;           // true once a #P line is read
+    while (next < end) {
+        if (*next == '#') {
+            char kind = next + 1 < end ? next[1] : 0;
+            next += 2;
+            if (kind == 'P') {
+                if (!readInt(x0) || !readInt(y0)) {
+                    return fail("expected a block position after #P");
+                }
+                row = 0;
+                positioned = true;
+            } else if (kind == 'N') {
+                rule = "23/3";
+            } else if (kind == 'R') {
+                const char *start = next;
+                while (next < end && *next != '\n' && *next != '\r') {
+                    next++;
+                }
+                rule = std::string(start, next);
+                rule.erase(0, rule.find_first_not_of(" \t"));
+            }
+            skipLine();
+            continue;
+        }
+        for (long long col = 0; next < end && *next != '\n'; next++) {
+            if (*next == '*') {
+                if (!addCell(x0 + col, y0 + row)) {
+                    return false;
+                }
+                col++;
+            } else if (*next == '.') {
+                col++;
+            } else if (*next != '\r' && *next != ' ' && *next != '\t') {
+                return fail(std::string("unexpected character '") + *next +
+                            "' in a row of cells");
+            }
+        }
+        row++;
+        skipLine();
+    }
+    if (!positioned) {
+        center();
+    }
+    return true;
+}
+
+// read plaintext: ! comment lines, then rows of '.' and 'O'
+bool Seed::readCells() {
+    long long row = 0;
+    while (next < end) {
+        if (*next == '!') {
+            skipLine();
+            continue;
+        }
+        for (long long col = 0; next < end && *next != '\n'; next++) {
+            if (*next == 'O' || *next == 'o' || *next == '*') {
+                if (!addCell(col, row)) {
+                    return false;
+                }
+                col++;
+            } else if (*next == '.') {
+                col++;
+            } else if (*next != '\r' && *next != ' ' && *next != '\t') {
+                return fail(std::string("unexpected character '") + *next +
+                            "' in a row of cells");
+            }
+        }
+        row++;
+        skipLine();
+    }
+    center();
+    return true;
+}
+
+// read RLE: # comment lines (#r gives the rule), a header line
+// "x = width, y = height, rule = rule", then runs of dead (b) and live
+// (o) cells, with $ ending a row and ! ending the pattern.  Patterns
+// of Generations rules use . for dead cells, A for live ones and B to
+// X for the dying states.
+bool Seed::readRle() {
+    while (next < end && *next != 'x') {
+        if (*next == '#' && next + 1 < end && next[1] == 'r') {
+            const char *start = next + 2;
+            skipLine();
+            rule = std::string(start, next);
+            rule.erase(0, rule.find_first_not_of(" \t"));
+            rule.erase(rule.find_last_not_of(" \t\r\n") + 1);
+        } else {
+            skipLine();
+        }
+    }
+
+    // header line, as comma separated "key = value" pairs
+    const char *start = next;
+    while (next < end && *next != '\n') {
+        next++;
+    }
+    std::stringstream header(std::string(start, next));
+    std::string item;
+    bool width = false, height = false;
+    long long limitX = LIMIT, limitY = LIMIT;  // declared size, if any
+    while (getline(header, item, ',')) {
+        size_t equals = item.find('=');
+        std::string key = item.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" :
+                            item.substr(equals + 1);
+        key.erase(0, key.find_first_not_of(" \t"));
+        key.erase(key.find_last_not_of(" \t\r") + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t\r") + 1);
+        if (key == "x" || key == "y") {
+            char *last;
+            long n = strtol(value.c_str(), &last, 10);
+            if (value.empty() || *last != 0 || n < 0) {
+                return fail("bad pattern size in RLE header");
+            }
+            (key == "x" ? width : height) = true;
+            if (n > 0) {
+                (key == "x" ? limitX : limitY) = n < LIMIT ? n : LIMIT;
+            }
+        } else if (key == "rule") {
+            rule = value;
+        }
+    }
+    if (!width || !height) {
+        return fail("expected RLE header \"x = .., y = ..\"");
+    }
+    skipLine();
+
+    // cell runs, which must stay within the declared size so a huge
+    // run count cannot spin out millions of cells; a size of 0, as
+    // some writers give, leaves only the coordinate limit
+    long long x = 0, y = 0, count = 0;
+    bool counted = false;   // true if a run count has been read
+    while (next < end) {
+        char c = *next++;
+        if (c >= '0' && c <= '9') {
+            if (count < (1LL << 40)) {
+                count = 10*count + (c - '0');
+            }
+            counted = true;
+            continue;
+        }
+        long long run = counted ? count : 1;
+        if (c == 'b' || c == '.') {
+            x += run;
+        } else if (c == 'o' || (c >= 'A' && c <= 'X')) {
+            if (x + run > limitX) {
+                return fail("run extends past pattern width");
+            }
+            if (y >= limitY) {
+                return fail("run extends past pattern height");
+            }
+            for (long long i = 0; i < run; i++) {
+                if (!addCell(x + i, y, c == 'o' ? 1 : c - 'A' + 1)) {
+                    return false;
+                }
+            }
+            x += run;
+        } else if (c == '$') {
+            if (y + run > limitY) {
+                return fail("run extends past pattern height");
+            }
+            y += run;
+            x = 0;
+        } else if (c == '!') {
+            center();
+            return true;
+        } else if (c == '\n') {
+            line++;
+            continue;
+        } else if (c == ' ' || c == '\t' || c == '\r') {
+            continue;
+        } else {
+            return fail(std::string("unexpected character '") + c +
+                        "' in RLE data");
+        }
+        count = 0;
+        counted = false;
+    }
+    return fail("RLE data ends without '!'");
+}
+
+// move the pattern so the center of its extent is at 0, 0
+void Seed::center() {
+    if (pattern.empty()) {
+        return;
+    }
+    int dx = minX + (maxX - minX + 1)/2;
+    int dy = minY + (maxY - minY + 1)/2;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        pattern[i].x -= dx;
+        pattern[i].y -= dy;
+    }
+    minX -= dx;
+    maxX -= dx;
+    minY -= dy;
+    maxY -= dy;
 }
 
 
@@ -164,3 +669,61 @@ int Seed::getX(int i) {
 int Seed::getY(int i) {
     return pattern.at(i).y;
 }
+
+
+/*********************************************************************
+ ** Function: getState
+ ** Description:  Get the state of the cell of a coordinate pair.
+ ** Parameters:  The index number of the coordinate pair.
+ ** Pre-Conditions:  The seed pattern object must exist and have read
+ **   its coordinates from a file.
+ ** Post-Conditions:  Returns 1 for a live cell, or 2 and up for a
+ **   cell in a dying state of a Generations rule.
+ *********************************************************************/
+
+int Seed::getState(int i) {
+    return pattern.at(i).state;
+}
+
+
+/*********************************************************************
+ ** Function: getRule
+ ** Description:  Get the rule named in the pattern file.
+ ** Parameters:  none
+ ** Pre-Conditions:  none
+ ** Post-Conditions:  Returns the rule as written in the file (e.g.
+ **   "B3/S23" or "23/3"), or an empty string if it named none.
+ *********************************************************************/
+
+std::string Seed::getRule() {
+    return rule;
+}
+
+
+/*********************************************************************
+ ** Function: getFormat
+ ** Description:  Get the format of the pattern file read.
+ ** Parameters:  none
+ ** Pre-Conditions:  none
+ ** Post-Conditions:  Returns "RLE", "Life 1.05", "Life 1.06" or
+ **   "plaintext", or an empty string if no file was read.
+ *********************************************************************/
+
+std::string Seed::getFormat() {
+    return format;
+}
+
+
+/*********************************************************************
+ ** Function: getError
+ ** Description:  Get what was wrong with the last pattern read.
+ ** Parameters:  none
+ ** Pre-Conditions:  none
+ ** Post-Conditions:  Returns a description of the problem, with the
+ **   file name and line number where known, or an empty string if the
+ **   last pattern was read successfully.
+ *********************************************************************/
+
+std::string Seed::getError() {
+    return error;
+}
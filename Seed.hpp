@@ -4,36 +4,67 @@
  ** Date: 2015-09-26
  ** Description: Attributes and functions of a seed pattern that can
  **   be used as the initial condition for a Game of Life simulation.
- ** Input: Reads seed pattern from a standard text file format
- ** Output: Extent and size of pattern, live cell coordinates
+ ** Input: Reads seed pattern from a standard text file format: RLE,
+ **   Life 1.05, Life 1.06 or plaintext (.cells), detected from the
+ **   contents of the file, or from the compact binary form a
+ **   PatternLibrary caches patterns in
+ ** Output: Extent and size of pattern, live cell coordinates, rule,
+ **   format, description of any error in the file, binary form
  *********************************************************************/
 
 #ifndef Seed_hpp
 #define Seed_hpp
 
-#include <fstream>
+#include <string>
 #include <vector>
-#include <algorithm>
+#include <cstddef>
 
 class Seed {
 private:
     struct coord {
         int x,y;    // x and y coordinates
+        int state;  // 1 for live, 2 and up for the dying states of a
+                    // Generations rule
     };
-    std::vector<coord> pattern; // coordinates of live cells
+    static const int LIMIT = 1 << 30;   // farthest a cell may lie from 0, 0
+    std::vector<coord> pattern; // coordinates of live and dying cells
     int sizeX;  // extent of pattern in the x direction
     int sizeY;  // extent of pattern in the y direction
     int length; // number of live cells in the pattern
-    static bool byX(coord, coord); // compares the x coordinates
-    static bool byY(coord, coord); // compares the y coordinates
+    int minX, maxX, minY, maxY; // bounds of the pattern
+    std::string rule;   // rule named in the file, if any
+    const char *format; // format of the file read, empty if none
+    std::string error;  // what was wrong with the last file read
+    int line;           // line of the file being read
+    const char *next;   // next character of the file to read
+    const char *end;    // end of the file
+    void clear();                   // empty the pattern
+    bool addCell(long long, long long, int = 1); // add a cell
+    bool fail(const std::string &); // note an error on the current line
+    bool readInt(long long &);      // read an integer
+    bool startsWith(const char *, const char *); // test the text at a place
+    void skipLine();                // move to the start of the next line
+    bool readLife106();             // read Life 1.06 coordinates
+    bool readLife105();             // read Life 1.05 cell blocks
+    bool readCells();               // read plaintext rows
+    bool readRle();                 // read run length encoded rows
+    void center();                  // put the pattern's center at 0, 0
 public:
     Seed();     // constructor
-    void readFile(std::string); // read seed pattern from file.
+    bool readFile(std::string); // read seed pattern from file.
+    bool readPath(std::string); // read seed pattern from a file path
+    bool readText(const char *, size_t); // read seed pattern from memory
+    void writeBinary(std::string &);     // append the binary form
+    bool readBinary(const char *, size_t); // read the binary form
     int getSizeX(); // get extent of pattern in the x direction
     int getSizeY(); // extent of pattern in the y direction
     int getLength(); // get the number of live cells in the pattern
     int getX(int);  // get the x coordinate of a coordinate pair
     int getY(int);  // get the y coordinate of a coordinate pair
+    int getState(int);  // get the state of the cell of a coordinate pair
+    std::string getRule();  // get the rule named in the file
+    std::string getFormat(); // get the format of the file
+    std::string getError(); // get what was wrong with the last file
 };
 
 #endif /* Seed_hpp */
@@ -0,0 +1,447 @@
+/*********************************************************************
+ ** Program Filename: Snapshot.cpp, Snapshot class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Snapshot class implementation, a copy of a
+ **   simulation's cells that can be saved to and restored from a
+ **   binary checkpoint file.  A file holds a header (dimensions,
+ **   generation, rule and checksums) and, starting on a page boundary,
+ **   a body of 64-bit words in the machine's byte order: either the
+ **   whole bit-packed grid (dense) or the 64 x 64 cell tiles holding
+ **   live cells (sparse), each tile being its x and y tile numbers
+ **   followed by its 64 rows.
+ ** Input: cells of an engine, checkpoint file
+ ** Output: checkpoint file, cells to restore into an engine
+ *********************************************************************/
+
+#include "Snapshot.hpp"
+#include "Trace.hpp"
+#include <cstring>      // header file for memcpy and strncpy
+#include <cstdio>       // header file for rename
+#include <fcntl.h>      // header file for open
+#include <unistd.h>     // header file for write, fsync and close
+#include <sys/mman.h>   // header file for mmap
+#include <sys/stat.h>   // header file for fstat
+
+static const char MAGIC[8] = { 'L', 'I', 'F', 'E', 'S', 'N', 'A', 'P' };
+static const uint32_t VERSION = 1;      // file format version
+static const uint64_t BODY_OFFSET = 4096; // body starts on a page boundary
+
+
+/*********************************************************************
+ ** Function:  Snapshot
+ ** Description:  Snapshot class constructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions:  An empty sparse snapshot at generation zero is
+ **   created.  The writer thread is started on first use.
+ *********************************************************************/
+
+Snapshot::Snapshot() {
+    mapping = 0;
+    mappedLength = 0;
+    body = 0;
+    writing = false;
+    failed = false;
+    stop = false;
+    setSparse(0);
+}
+
+
+/*********************************************************************
+ ** Function:  ~Snapshot
+ ** Description:  Snapshot class destructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions:  Any background write is completed, the writer
+ **   thread is stopped and the file mapping is dropped.
+ *********************************************************************/
+
+Snapshot::~Snapshot() {
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        stop = true;
+    }
+    signal.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+    unmap();
+}
+
+// wait until the writer thread is idle
+void Snapshot::wait() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (writing || !pending.empty()) {
+        signal.wait(guard);
+    }
+}
+
+// start a new copy of cells, once any background write is done
+void Snapshot::begin(Kind kind, long long generation) {
+    wait();
+    unmap();
+    data.clear();
+    tiles.clear();
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.kind = kind;
+    header.generation = generation;
+    strncpy(header.rule, "B3/S23", sizeof(header.rule) - 1);
+}
+
+// drop the file mapping, if any
+void Snapshot::unmap() {
+    if (mapping != 0) {
+        munmap(mapping, mappedLength);
+    }
+    mapping = 0;
+    mappedLength = 0;
+    body = 0;
+}
+
+// copy a bit-packed grid: its visible dimensions, hidden cells, words
+// per row and rows, then its buffer of words and the generation
+void Snapshot::setDense(int sizeX, int sizeY, int hide, int stride,
+                        int rows, const uint64_t *words, size_t count,
+                        long long generation) {
+    begin(DENSE, generation);
+    header.sizeX = sizeX;
+    header.sizeY = sizeY;
+    header.hide = hide;
+    header.stride = stride;
+    header.rows = rows;
+    data.assign(words, words + count);
+}
+
+// start an empty set of tiles at a generation
+void Snapshot::setSparse(long long generation) {
+    begin(SPARSE, generation);
+}
+
+// add a live cell to a sparse snapshot, adding its tile if needed
+void Snapshot::addCell(long long x, long long y) {
+    long long tx = x >= 0 ? x / TILE : (x - TILE + 1) / TILE;
+    long long ty = y >= 0 ? y / TILE : (y - TILE + 1) / TILE;
+    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(tx)) << 32) |
+                   static_cast<uint32_t>(ty);
+    std::unordered_map<uint64_t, size_t>::iterator it = tiles.find(key);
+    size_t t;
+    if (it == tiles.end()) {
+        t = data.size();
+        tiles[key] = t;
+        data.push_back(static_cast<uint64_t>(tx));
+        data.push_back(static_cast<uint64_t>(ty));
+        data.resize(t + 2 + TILE, 0);
+    } else {
+        t = it->second;
+    }
+    data[t + 2 + (y - ty*TILE)] |= uint64_t(1) << (x - tx*TILE);
+}
+
+// set the rule of the cells
+void Snapshot::setRule(const std::string &rule) {
+    memset(header.rule, 0, sizeof(header.rule));
+    strncpy(header.rule, rule.c_str(), sizeof(header.rule) - 1);
+}
+
+// set the edges of a dense grid, a Boundary (zero, the plane, unless
+// set)
+void Snapshot::setBoundary(int boundary) {
+    header.boundary = boundary;
+}
+
+// get the layout of the body
+Snapshot::Kind Snapshot::getKind() {
+    return header.kind == DENSE ? DENSE : SPARSE;
+}
+
+// get the generation of the cells
+long long Snapshot::getGeneration() {
+    return header.generation;
+}
+
+// get the visible x dimension of a dense grid
+int Snapshot::getSizeX() {
+    return header.sizeX;
+}
+
+// get the visible y dimension of a dense grid
+int Snapshot::getSizeY() {
+    return header.sizeY;
+}
+
+// get the number of hidden cells on each boundary of a dense grid
+int Snapshot::getHide() {
+    return header.hide;
+}
+
+// get the number of words per row of a dense grid
+int Snapshot::getStride() {
+    return header.stride;
+}
+
+// get the number of rows of a dense grid, boundary rows included
+int Snapshot::getRows() {
+    return header.rows;
+}
+
+// get the rule of the cells
+std::string Snapshot::getRule() {
+    return std::string(header.rule);
+}
+
+// get the edges of a dense grid, a Boundary
+int Snapshot::getBoundary() {
+    return header.boundary;
+}
+
+// get the body words: a dense grid's buffer, or the sparse tiles
+const uint64_t *Snapshot::getWords() {
+    if (mapping != 0) {
+        return body;
+    }
+    return data.empty() ? 0 : &data[0];
+}
+
+// get the number of body words
+size_t Snapshot::getWordCount() {
+    return mapping != 0 ? header.count : data.size();
+}
+
+// hand over the mapping of a file that was read: returns the body
+// words, which may be written to without changing the file, and the
+// mapping to unmap when done with them; 0 if the body is not mapped
+uint64_t *Snapshot::takeMapping(void *&base, size_t &length) {
+    if (mapping == 0) {
+        return 0;
+    }
+    uint64_t *words = const_cast<uint64_t *>(body);
+    base = mapping;
+    length = mappedLength;
+    mapping = 0;
+    mappedLength = 0;
+    body = 0;
+    return words;
+}
+
+// hash a run of 64-bit words (FNV-1a, a word at a time)
+uint64_t Snapshot::checksum(const void *p, size_t count) {
+    const uint64_t *words = static_cast<const uint64_t *>(p);
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < count; i++) {
+        h = (h ^ words[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+// write all of a buffer to a file descriptor
+static bool writeAll(int fd, const void *p, size_t n) {
+    const char *bytes = static_cast<const char *>(p);
+    while (n > 0) {
+        ssize_t done = write(fd, bytes, n < (1u << 30) ? n : (1u << 30));
+        if (done <= 0) {
+            return false;
+        }
+        bytes += done;
+        n -= done;
+    }
+    return true;
+}
+
+// write the header and body to a file.  The file is written under a
+// temporary name, flushed to disk and then renamed, so a crash while
+// writing leaves the previous checkpoint intact.
+bool Snapshot::save(const std::string &fileName) {
+    ScopedTimer timer(CHECKPOINT_TIMER);
+    Header h = header;
+    const uint64_t *words = getWords();
+    h.offset = BODY_OFFSET;
+    h.count = getWordCount();
+    h.checksum = checksum(words, h.count);
+    h.headerSum = checksum(&h, offsetof(Header, headerSum) / 8);
+
+    std::string temp = fileName + ".tmp";
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        error = temp + ": cannot create file";
+        return false;
+    }
+    std::vector<char> gap(BODY_OFFSET - sizeof(h), 0);
+    bool ok = writeAll(fd, &h, sizeof(h)) &&
+              writeAll(fd, &gap[0], gap.size()) &&
+              writeAll(fd, words, h.count * sizeof(uint64_t)) &&
+              fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(temp.c_str(), fileName.c_str()) != 0) {
+        unlink(temp.c_str());
+        error = fileName + ": cannot write file";
+        return false;
+    }
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: write
+ ** Description: Write the snapshot to a checkpoint file and wait for
+ **   it to be on disk.
+ ** Parameters: File name.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false, with the reason in getError, if the
+ **   file could not be written.  A file of the same name is replaced
+ **   only once the new one is complete.
+ *********************************************************************/
+
+bool Snapshot::write(const std::string &fileName) {
+    wait();
+    return save(fileName);
+}
+
+
+/*********************************************************************
+ ** Function: writeAsync
+ ** Description: Write the snapshot to a checkpoint file on the writer
+ **   thread, waiting first for any earlier write to finish.
+ ** Parameters: File name.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The file is being written.  The snapshot must not
+ **   be changed until the write is done; the set functions and read
+ **   wait for it themselves.  finish reports whether it succeeded.
+ *********************************************************************/
+
+void Snapshot::writeAsync(const std::string &fileName) {
+    std::unique_lock<std::mutex> guard(lock);
+    while (writing || !pending.empty()) {
+        signal.wait(guard);
+    }
+    pending = fileName;
+    if (!writer.joinable()) {
+        writer = std::thread(&Snapshot::loop, this);
+    }
+    signal.notify_all();
+}
+
+// body of the writer thread: write each file asked for
+void Snapshot::loop() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        while (!stop && pending.empty()) {
+            signal.wait(guard);
+        }
+        if (pending.empty()) {
+            return;
+        }
+        std::string fileName = pending;
+        writing = true;
+        guard.unlock();
+        bool ok = save(fileName);
+        guard.lock();
+        writing = false;
+        pending.clear();
+        failed = failed || !ok;
+        signal.notify_all();
+    }
+}
+
+
+/*********************************************************************
+ ** Function: finish
+ ** Description: Wait for background writing to finish.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false, with the reason in getError, if a
+ **   background write failed since the last call.
+ *********************************************************************/
+
+bool Snapshot::finish() {
+    wait();
+    std::unique_lock<std::mutex> guard(lock);
+    bool ok = !failed;
+    failed = false;
+    return ok;
+}
+
+
+/*********************************************************************
+ ** Function: read
+ ** Description: Read a checkpoint file by mapping it into memory.
+ **   Only the header is read straight away; the body's pages are read
+ **   as they are used.
+ ** Parameters: File name and whether to check the body's checksum,
+ **   which means reading the whole body.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns false, with the reason in getError, if the
+ **   file could not be read, is not a checkpoint file, is truncated or
+ **   damaged.
+ *********************************************************************/
+
+bool Snapshot::read(const std::string &fileName, bool verify) {
+    ScopedTimer timer(CHECKPOINT_TIMER);
+    begin(SPARSE, 0);
+    int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        error = fileName + ": cannot open file";
+        return false;
+    }
+    Header h;
+    size_t size = static_cast<size_t>(info.st_size);
+    if (pread(fd, &h, sizeof(h), 0) != sizeof(h) ||
+        memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        close(fd);
+        error = fileName + ": not a checkpoint file";
+        return false;
+    }
+    if (h.version != VERSION) {
+        close(fd);
+        error = fileName + ": unsupported checkpoint version";
+        return false;
+    }
+    if (h.headerSum != checksum(&h, offsetof(Header, headerSum) / 8) ||
+        h.kind > SPARSE || h.offset % sizeof(uint64_t) != 0) {
+        close(fd);
+        error = fileName + ": damaged header";
+        return false;
+    }
+    // a dense grid's rows, with as many padding words after them as
+    // before, must fit the body, as a loader divides by the stride
+    if (h.kind == DENSE && (h.stride <= 0 || h.rows < 0 ||
+        h.count < static_cast<uint64_t>(h.stride) * h.rows ||
+        (h.count - static_cast<uint64_t>(h.stride) * h.rows) % 2 != 0)) {
+        close(fd);
+        error = fileName + ": damaged header";
+        return false;
+    }
+    if (h.offset > size || h.count > (size - h.offset) / sizeof(uint64_t)) {
+        close(fd);
+        error = fileName + ": truncated file";
+        return false;
+    }
+    void *map = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error = fileName + ": cannot map file";
+        return false;
+    }
+    header = h;
+    mapping = map;
+    mappedLength = size;
+    body = reinterpret_cast<const uint64_t *>(
+        static_cast<const char *>(map) + h.offset);
+    if (verify && checksum(body, h.count) != h.checksum) {
+        unmap();
+        error = fileName + ": checksum mismatch, the file is damaged";
+        return false;
+    }
+    return true;
+}
+
+// get what went wrong last
+std::string Snapshot::getError() {
+    return error;
+}
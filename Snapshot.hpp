@@ -0,0 +1,101 @@
+/*********************************************************************
+ ** Program Filename: Snapshot.hpp, Snapshot class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Snapshot class specification, a copy of a simulation's
+ **   cells that can be saved to and restored from a binary checkpoint
+ **   file.  A file holds a header (dimensions, generation, rule and
+ **   checksums) and a body of 64-bit words, either the whole
+ **   bit-packed grid (dense) or the 64 x 64 cell tiles holding live
+ **   cells (sparse).  Files are written by a background thread, so a
+ **   simulation only waits for its cells to be copied, and are read
+ **   by mapping them into memory, so a dense grid can use the file's
+ **   pages directly instead of reading them.
+ ** Input: cells of an engine, checkpoint file
+ ** Output: checkpoint file, cells to restore into an engine
+ *********************************************************************/
+
+#ifndef Snapshot_hpp
+#define Snapshot_hpp
+
+#include <stdint.h>             // header file for fixed width integer types
+#include <cstddef>              // header file for size_t
+#include <string>               // header file for string objects
+#include <vector>               // header file for vector objects
+#include <unordered_map>        // header file for hash tables
+#include <thread>               // header file for thread objects
+#include <mutex>                // header file for mutual exclusion
+#include <condition_variable>   // header file for thread signalling
+
+class Snapshot {
+public:
+    enum Kind { DENSE = 0, SPARSE = 1 };    // layout of the body
+    static const int TILE = 64;             // cells per side of a tile
+private:
+    struct Header {
+        char magic[8];          // "LIFESNAP"
+        uint32_t version;       // file format version
+        uint32_t kind;          // DENSE or SPARSE
+        int64_t generation;     // generation of the cells
+        int32_t sizeX, sizeY;   // visible grid dimensions (dense)
+        int32_t hide;           // hidden cells on each boundary (dense)
+        int32_t stride;         // words per row (dense)
+        int32_t rows;           // rows, boundary rows included (dense)
+        int32_t boundary;       // edges of the grid (dense), a Boundary
+        uint64_t offset;        // byte offset of the body in the file
+        uint64_t count;         // number of words in the body
+        uint64_t checksum;      // checksum of the body words
+        char rule[32];          // rule, NUL terminated
+        uint64_t headerSum;     // checksum of the fields above
+    };
+    Header header;                      // description of the cells
+    std::vector<uint64_t> data;         // body words copied from an engine
+    const uint64_t *body;               // body words, copied or mapped
+    void *mapping;                      // file mapping holding the body
+    size_t mappedLength;                // length of the mapping in bytes
+    std::unordered_map<uint64_t, size_t> tiles; // body offset of a tile
+    std::string error;                  // what went wrong last
+    std::thread writer;                 // background writer thread
+    std::mutex lock;                    // protects the fields below
+    std::condition_variable signal;     // signals work or its end
+    std::string pending;                // file to write, empty if none
+    bool writing;                       // true while a file is written
+    bool failed;                        // a write failed since finish
+    bool stop;                          // true when shutting down
+    void wait();                        // wait for the writer to idle
+    void begin(Kind, long long);        // start a new copy of cells
+    void unmap();                       // drop the file mapping
+    bool save(const std::string &);     // write the body to a file
+    void loop();                        // body of the writer thread
+    static uint64_t checksum(const void *, size_t); // hash words
+    Snapshot(const Snapshot &);             // not copyable
+    Snapshot &operator=(const Snapshot &);  // not assignable
+public:
+    Snapshot();                         // constructor
+    ~Snapshot();                        // destructor
+    void setDense(int, int, int, int, int, const uint64_t *, size_t,
+                  long long);           // copy a bit-packed grid
+    void setSparse(long long);          // start an empty set of tiles
+    void addCell(long long, long long); // add a live cell to the tiles
+    void setRule(const std::string &);  // set the rule of the cells
+    void setBoundary(int);              // set the edges of the grid
+    Kind getKind();                     // get the layout of the body
+    long long getGeneration();          // get generation of the cells
+    int getSizeX();                     // get x dimension (dense)
+    int getSizeY();                     // get y dimension (dense)
+    int getHide();                      // get hidden cells (dense)
+    int getStride();                    // get words per row (dense)
+    int getRows();                      // get rows (dense)
+    std::string getRule();              // get the rule of the cells
+    int getBoundary();                  // get the edges of the grid
+    const uint64_t *getWords();         // get the body words
+    size_t getWordCount();              // get number of body words
+    uint64_t *takeMapping(void *&, size_t &); // hand over the mapping
+    bool write(const std::string &);    // write a file and wait
+    void writeAsync(const std::string &); // write a file in background
+    bool finish();                      // wait for background writing
+    bool read(const std::string &, bool); // map a file
+    std::string getError();             // get what went wrong last
+};
+
+#endif /* Snapshot_hpp */
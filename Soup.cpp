@@ -0,0 +1,90 @@
+/*********************************************************************
+ ** Program Filename: Soup.cpp, Soup class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Random soup, a board filled at random with live cells
+ **   to a given density, reproducible from a seed.
+ ** Input: random number seed, stream (soup number), density
+ ** Output: live cells of each row, 64 at a time
+ *********************************************************************/
+
+#include "Soup.hpp"
+
+// the splitmix64 output function: a well mixed hash of a counter
+uint64_t Soup::mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+/*********************************************************************
+ ** Function:  Soup
+ ** Description:  Soup class constructor
+ ** Parameters: Random number seed, fill from 0 (no live cells) to 1
+ **   (all live), and a stream number telling apart soups of the same
+ **   seed, such as the soups of a search.
+ ** Pre-Conditions: none
+ ** Post-Conditions:  Each cell is live with the density's chance,
+ **   rounded to a multiple of 2^-32.
+ *********************************************************************/
+
+Soup::Soup(uint64_t seed, double fill, uint64_t stream) {
+    key = mix(mix(seed + GAMMA) + stream * GAMMA);
+    density = fill;
+    double t = fill * 4294967296.0 + 0.5;
+    threshold = fill <= 0 ? 0 : t >= 4294967296.0 ? 1ULL << 32 :
+                static_cast<uint64_t>(t);
+    lowest = 0;
+    while (lowest < 32 && ((threshold >> lowest) & 1) == 0) {
+        lowest++;
+    }
+}
+
+// get fill asked for
+double Soup::getDensity() const {
+    return density;
+}
+
+// key the random numbers of row y are counted from
+uint64_t Soup::rowKey(long long y) const {
+    return mix(key ^ mix(static_cast<uint64_t>(y) * GAMMA + GAMMA));
+}
+
+
+/*********************************************************************
+ ** Function: getWord
+ ** Description: Make 64 cells of a row of the soup.
+ ** Parameters: Key of the row, from rowKey, and the number k of the
+ **   word, cells 64k to 64k+63 of the row.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the cells, cell 64k in bit 0.  Bit b of
+ **   each cell's random number is bit b of the random word numbered
+ **   31-b, so the comparison with the threshold runs from the top bit
+ **   down and stops once no cell is still equal to it; bits below the
+ **   threshold's lowest set bit cannot make a cell less.
+ *********************************************************************/
+
+uint64_t Soup::getWord(uint64_t row, long long k) const {
+    if (threshold >> 32) {
+        return ~uint64_t(0);
+    }
+    uint64_t counter = row + (static_cast<uint64_t>(k) * 32 + 1) * GAMMA;
+    uint64_t less = 0;              // cells settled below the threshold
+    uint64_t equal = ~uint64_t(0);  // cells equal to it so far
+    for (int b = 31; b >= lowest && equal != 0; b--, counter += GAMMA) {
+        uint64_t r = mix(counter);
+        if ((threshold >> b) & 1) {
+            less |= equal & ~r;
+            equal &= r;
+        } else {
+            equal &= ~r;
+        }
+    }
+    return less;
+}
+
+// a single cell of the soup, at column x of row y
+bool Soup::getCell(long long x, long long y) const {
+    return (getWord(rowKey(y), x >> 6) >> (x & 63)) & 1;
+}
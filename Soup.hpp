@@ -0,0 +1,42 @@
+/*********************************************************************
+ ** Program Filename: Soup.hpp, Soup class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Random soup, a board filled at random with live cells
+ **   to a given density, reproducible from a seed.  The random numbers
+ **   are counter based: each is a hash of the seed, the row and its
+ **   place in the row, with no state carried from one to the next, so
+ **   any row or word of a soup can be made on its own, by any thread,
+ **   and a soup is the same however many threads fill it.  A word of
+ **   64 cells is made at once: the 32-bit threshold the density gives
+ **   is compared with a 32-bit random number per cell bit by bit, the
+ **   64 cells side by side in the bits of a word, stopping once every
+ **   cell is settled, which takes one random word per 64 cells at a
+ **   density of one half and about eight at others.
+ ** Input: random number seed, stream (soup number), density
+ ** Output: live cells of each row, 64 at a time
+ *********************************************************************/
+
+#ifndef Soup_hpp
+#define Soup_hpp
+
+#include <stdint.h> // header file for fixed width integer types
+
+class Soup {
+private:
+    uint64_t key;           // hash of the seed and stream
+    uint64_t threshold;     // cells whose number is below it live, out
+                            // of 2^32
+    int lowest;             // lowest bit set in the threshold
+    double density;         // fill asked for
+public:
+    static const uint64_t GAMMA = 0x9E3779B97F4A7C15ULL; // counter step
+    static uint64_t mix(uint64_t);  // splitmix64 hash of a counter
+    Soup(uint64_t, double, uint64_t = 0); // constructor
+    double getDensity() const;      // get fill asked for
+    uint64_t rowKey(long long) const;   // key of a row's numbers
+    uint64_t getWord(uint64_t, long long) const; // cells 64k to 64k+63
+    bool getCell(long long, long long) const;    // a single cell
+};
+
+#endif /* Soup_hpp */
@@ -0,0 +1,189 @@
+/*********************************************************************
+ ** Program Filename: ThreadPool.cpp, ThreadPool class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Persistent pool of worker threads that runs a batch
+ **   of numbered tasks and waits for all of them to finish.  The
+ **   calling thread works as worker 0, so a pool of n threads starts
+ **   n-1 new threads.
+ ** Input: number of threads, batches of tasks
+ ** Output: runs every task exactly once per batch
+ *********************************************************************/
+
+#include "ThreadPool.hpp"
+
+
+/*********************************************************************
+ ** Function: ThreadPool
+ ** Description: ThreadPool class constructor
+ ** Parameters: Number of workers including the calling thread; values
+ **   below 1 use one worker per hardware thread.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The worker threads are started and wait for work.
+ *********************************************************************/
+
+ThreadPool::ThreadPool(int n) {
+    if (n < 1) {
+        n = std::thread::hardware_concurrency();
+        if (n < 1) {
+            n = 1;
+        }
+    }
+    std::vector<Queue>(n).swap(queues);
+    task = 0;
+    context = 0;
+    batch = 0;
+    busy = 0;
+    stop = false;
+    for (int w = 0; w < n; w++) {
+        queues[w].begin = 0;
+        queues[w].end = 0;
+    }
+    for (int w = 1; w < n; w++) {
+        threads.push_back(std::thread(&ThreadPool::loop, this, w));
+    }
+}
+
+
+/*********************************************************************
+ ** Function: ~ThreadPool
+ ** Description: ThreadPool class destructor
+ ** Parameters: none
+ ** Pre-Conditions: No batch may be running.
+ ** Post-Conditions: All worker threads have exited.
+ *********************************************************************/
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop = true;
+    }
+    start.notify_all();
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+}
+
+
+/*********************************************************************
+ ** Function: getThreads
+ ** Description: Get the number of workers.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the number of workers including the
+ **   calling thread.
+ *********************************************************************/
+
+int ThreadPool::getThreads() {
+    return static_cast<int>(queues.size());
+}
+
+
+/*********************************************************************
+ ** Function: run
+ ** Description: Run tasks 0 to ntasks-1 on the pool.
+ ** Parameters: Number of tasks, the task function and a context
+ **   pointer passed to every task.
+ ** Pre-Conditions: Must not be called from inside a task.
+ ** Post-Conditions: Returns once every task has finished.
+ *********************************************************************/
+
+void ThreadPool::run(int ntasks, TaskFunction fn, void *ctx) {
+    int n = getThreads();
+
+    // not worth waking the workers
+    if (n == 1 || ntasks <= 1) {
+        for (int t = 0; t < ntasks; t++) {
+            fn(ctx, t, 0);
+        }
+        return;
+    }
+
+    // deal out one contiguous block of tasks to each worker
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int w = 0; w < n; w++) {
+            std::lock_guard<std::mutex> qguard(queues[w].lock);
+            queues[w].begin = static_cast<int>((long long)ntasks * w / n);
+            queues[w].end = static_cast<int>((long long)ntasks * (w+1) / n);
+        }
+        task = fn;
+        context = ctx;
+        busy = n;
+        batch++;
+    }
+    start.notify_all();
+
+    // work as worker 0, then wait for the others
+    work(0);
+    std::unique_lock<std::mutex> guard(lock);
+    busy--;
+    while (busy > 0) {
+        finish.wait(guard);
+    }
+}
+
+
+/*********************************************************************
+ ** Function: work
+ ** Description: Run tasks from this worker's block, then take tasks
+ **   from the far end of other workers' blocks until none are left.
+ ** Parameters: Worker number.
+ ** Pre-Conditions: A batch has been dealt out.
+ ** Post-Conditions: Every task of the batch has been started.
+ *********************************************************************/
+
+void ThreadPool::work(int me) {
+    int n = getThreads();
+    while (true) {
+        int t = -1;
+        {
+            std::lock_guard<std::mutex> guard(queues[me].lock);
+            if (queues[me].begin < queues[me].end) {
+                t = queues[me].begin++;
+            }
+        }
+        for (int v = 1; t < 0 && v < n; v++) {
+            Queue &victim = queues[(me + v) % n];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.begin < victim.end) {
+                t = --victim.end;
+            }
+        }
+        if (t < 0) {
+            return;
+        }
+        task(context, t, me);
+    }
+}
+
+
+/*********************************************************************
+ ** Function: loop
+ ** Description: Body of each worker thread: wait for a batch, work on
+ **   it and report back, until the pool is destroyed.
+ ** Parameters: Worker number.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns when the pool is stopped.
+ *********************************************************************/
+
+void ThreadPool::loop(int me) {
+    long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            while (!stop && batch == seen) {
+                start.wait(guard);
+            }
+            if (stop) {
+                return;
+            }
+            seen = batch;
+        }
+        work(me);
+        std::lock_guard<std::mutex> guard(lock);
+        if (--busy == 0) {
+            finish.notify_all();
+        }
+    }
+}
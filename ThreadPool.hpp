@@ -0,0 +1,54 @@
+/*********************************************************************
+ ** Program Filename: ThreadPool.hpp, ThreadPool class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Persistent pool of worker threads that runs a batch
+ **   of numbered tasks and waits for all of them to finish.  Tasks
+ **   are dealt out in contiguous blocks, one block per worker; a
+ **   worker that runs out takes tasks from the far end of another
+ **   worker's block, so uneven tasks still balance.
+ ** Input: number of threads, batches of tasks
+ ** Output: runs every task exactly once per batch
+ *********************************************************************/
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <vector>               // header file for vector objects
+#include <thread>               // header file for thread objects
+#include <mutex>                // header file for mutual exclusion
+#include <condition_variable>   // header file for thread signalling
+
+// a task is given the batch context, its task number and the number
+// of the worker running it (0 to getThreads()-1)
+typedef void (*TaskFunction)(void *context, int task, int worker);
+
+class ThreadPool {
+private:
+    struct Queue {
+        std::mutex lock;    // protects begin and end
+        int begin, end;     // remaining task numbers [begin, end)
+        char pad[64];       // keep queues on separate cache lines
+    };
+    std::vector<std::thread> threads;   // workers 1 to n-1
+    std::vector<Queue> queues;          // one task block per worker
+    std::mutex lock;                    // protects the fields below
+    std::condition_variable start;      // signals a new batch
+    std::condition_variable finish;     // signals the end of a batch
+    TaskFunction task;                  // function for current batch
+    void *context;                      // context for current batch
+    long batch;                         // number of batches started
+    int busy;                           // workers still in this batch
+    bool stop;                          // true when shutting down
+    void work(int);                     // run tasks until none are left
+    void loop(int);                     // body of each worker thread
+    ThreadPool(const ThreadPool &);             // not copyable
+    ThreadPool &operator=(const ThreadPool &);  // not assignable
+public:
+    ThreadPool(int);                    // constructor
+    ~ThreadPool();                      // destructor
+    int getThreads();                   // get number of workers
+    void run(int, TaskFunction, void *);  // run a batch and wait
+};
+
+#endif /* ThreadPool_hpp */
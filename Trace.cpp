@@ -0,0 +1,231 @@
+/*********************************************************************
+ ** Program Filename: Trace.cpp, Trace class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Trace class implementation, measures where a run's
+ **   time goes with per thread timers and counters.
+ ** Input: timed phases and counts from the engines, renderer and
+ **   files; the file to stream to
+ ** Output: summary of time and work per phase, counter and thread;
+ **   per generation CSV rows or trace events
+ *********************************************************************/
+
+#include "Trace.hpp"
+#include <chrono>   // header file for clocks
+#include <cstdio>   // header file for snprintf
+
+bool Trace::on = false;
+bool Trace::streaming = false;
+bool Trace::chrome = false;
+bool Trace::firstEvent = true;
+uint64_t Trace::epoch = 0;
+std::vector<Trace::Totals *> Trace::threads;
+std::mutex Trace::lock;
+std::ofstream Trace::file;
+Trace::Totals Trace::last;
+
+// names of the phases and counters, for output
+static const char *TIMER_NAMES[TIMERS] = {
+    "read", "seed", "step", "tile", "render", "checkpoint", "capture",
+    "encode"
+};
+static const char *COUNTER_NAMES[COUNTERS] = {
+    "cells evaluated", "tiles stepped", "tiles skipped", "births",
+    "deaths", "bytes rendered"
+};
+static const char *COLUMN_NAMES[COUNTERS] = {
+    "cells", "tiles_stepped", "tiles_skipped", "births", "deaths",
+    "bytes_rendered"
+};
+
+// start timing and counting
+void Trace::enable() {
+    if (!on) {
+        epoch = now();
+        on = true;
+    }
+}
+
+// clock, in nanoseconds; never 0
+uint64_t Trace::now() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count()) | 1;
+}
+
+// totals of the calling thread, made on its first use.  They are kept
+// after the thread ends, for the summary.
+Trace::Totals *Trace::local() {
+    static thread_local Totals *mine = 0;
+    if (mine == 0) {
+        mine = new Totals();
+        std::lock_guard<std::mutex> hold(lock);
+        mine->thread = static_cast<int>(threads.size());
+        threads.push_back(mine);
+    }
+    return mine;
+}
+
+// add up every thread's totals, with the lock held
+void Trace::sum(Totals &total) {
+    total = Totals();
+    for (size_t i = 0; i < threads.size(); i++) {
+        for (int c = 0; c < COUNTERS; c++) {
+            total.counts[c] += threads[i]->counts[c];
+        }
+        for (int t = 0; t < TIMERS; t++) {
+            total.calls[t] += threads[i]->calls[t];
+            total.nanos[t] += threads[i]->nanos[t];
+        }
+    }
+}
+
+
+/*********************************************************************
+ ** Function: record
+ ** Description: Add a timed phase to the calling thread's totals.
+ ** Parameters: The phase and the clock at its start and end.
+ ** Pre-Conditions: Tracing is enabled.
+ ** Post-Conditions: If a Chrome trace is being streamed, the phase is
+ **   written to it as a complete event, unless it is a single tile:
+ **   there are too many of those, and the summary has their totals.
+ *********************************************************************/
+
+void Trace::record(TimerName timer, uint64_t start, uint64_t end) {
+    Totals *t = local();
+    t->calls[timer]++;
+    t->nanos[timer] += end - start;
+    if (!streaming || !chrome || timer == TILE_TIMER) {
+        return;
+    }
+    char event[160];
+    snprintf(event, sizeof(event),
+             "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+             "\"pid\":1,\"tid\":%d}",
+             TIMER_NAMES[timer], (start - epoch) / 1e3,
+             (end - start) / 1e3, t->thread);
+    std::lock_guard<std::mutex> hold(lock);
+    file << (firstEvent ? "" : ",\n") << event;
+    firstEvent = false;
+}
+
+
+/*********************************************************************
+ ** Function: stream
+ ** Description: Stream each generation's work to a file.
+ ** Parameters: File name; one ending in .json gets Chrome trace
+ **   events, anything else comma separated values.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Tracing is enabled.  Each generation an engine
+ **   steps adds a row (or a counter event) with the time spent
+ **   stepping it and the work counted since the last.  Returns false
+ **   if the file could not be created.
+ *********************************************************************/
+
+bool Trace::stream(const std::string &fileName) {
+    enable();
+    file.open(fileName.c_str());
+    if (!file) {
+        return false;
+    }
+    chrome = fileName.size() >= 5 &&
+             fileName.compare(fileName.size() - 5, 5, ".json") == 0;
+    if (chrome) {
+        file << "[\n";
+    } else {
+        file << "generation,seconds";
+        for (int c = 0; c < COUNTERS; c++) {
+            file << "," << COLUMN_NAMES[c];
+        }
+        file << "\n";
+    }
+    std::lock_guard<std::mutex> hold(lock);
+    sum(last);
+    streaming = true;
+    return true;
+}
+
+// write the work done since the last generation ended
+void Trace::writeGeneration(long long generation) {
+    std::lock_guard<std::mutex> hold(lock);
+    Totals total;
+    sum(total);
+    double seconds = (total.nanos[STEP_TIMER] - last.nanos[STEP_TIMER]) / 1e9;
+    if (chrome) {
+        file << (firstEvent ? "" : ",\n");
+        file << "{\"name\":\"work\",\"ph\":\"C\",\"ts\":";
+        file << (now() - epoch) / 1e3 << ",\"pid\":1,\"args\":{";
+        file << "\"generation\":" << generation;
+        for (int c = 0; c < COUNTERS; c++) {
+            file << ",\"" << COLUMN_NAMES[c] << "\":";
+            file << total.counts[c] - last.counts[c];
+        }
+        file << "}}";
+        firstEvent = false;
+    } else {
+        file << generation << "," << seconds;
+        for (int c = 0; c < COUNTERS; c++) {
+            file << "," << total.counts[c] - last.counts[c];
+        }
+        file << "\n";
+    }
+    last = total;
+}
+
+// end the stream; false if the file could not be written
+bool Trace::finish() {
+    std::lock_guard<std::mutex> hold(lock);
+    if (!streaming) {
+        return true;
+    }
+    streaming = false;
+    if (chrome) {
+        file << "\n]\n";
+    }
+    file.close();
+    return !file.fail();
+}
+
+
+/*********************************************************************
+ ** Function: report
+ ** Description: Print a summary of the time and work traced.
+ ** Parameters: Stream to print to.
+ ** Pre-Conditions: none
+ ** Post-Conditions: Prints the calls and seconds of each phase, the
+ **   total of each counter, and for each thread that stepped tiles
+ **   (or chunks) how many and how long it spent on them, which shows
+ **   how evenly the threads shared the work.
+ *********************************************************************/
+
+void Trace::report(std::ostream &out) {
+    std::lock_guard<std::mutex> hold(lock);
+    Totals total;
+    sum(total);
+    char line[96];
+    out << "phase              calls         seconds" << std::endl;
+    for (int t = 0; t < TIMERS; t++) {
+        snprintf(line, sizeof(line), "%-12s %11llu %15.6f", TIMER_NAMES[t],
+                 static_cast<unsigned long long>(total.calls[t]),
+                 total.nanos[t] / 1e9);
+        out << line << std::endl;
+    }
+    out << "counter                            total" << std::endl;
+    for (int c = 0; c < COUNTERS; c++) {
+        snprintf(line, sizeof(line), "%-16s %23llu", COUNTER_NAMES[c],
+                 static_cast<unsigned long long>(total.counts[c]));
+        out << line << std::endl;
+    }
+    out << "thread     tiles stepped    tile seconds" << std::endl;
+    for (size_t i = 0; i < threads.size(); i++) {
+        if (threads[i]->calls[TILE_TIMER] == 0) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%-6d %18llu %15.6f",
+                 threads[i]->thread,
+                 static_cast<unsigned long long>(
+                     threads[i]->counts[STEPPED_COUNTER]),
+                 threads[i]->nanos[TILE_TIMER] / 1e9);
+        out << line << std::endl;
+    }
+}
@@ -0,0 +1,114 @@
+/*********************************************************************
+ ** Program Filename: Trace.hpp, Trace class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Trace class specification, measures where a run's
+ **   time goes.  Timers cover the phases of a run (reading the seed,
+ **   applying it, stepping, stepping one tile, drawing, checkpoints,
+ **   capturing and encoding exported pictures)
+ **   and counters add up the work done (cells evaluated, tiles
+ **   stepped and skipped, births, deaths, bytes drawn).  Each thread
+ **   adds to totals of its own, so threads never share a counter.
+ **   Until tracing is enabled a timer or counter costs one test of a
+ **   flag.  The totals can be printed as a summary, and each
+ **   generation's work streamed to a comma separated values file or,
+ **   with the phases as well, to a Chrome trace event file.
+ ** Input: timed phases and counts from the engines, renderer and
+ **   files; the file to stream to
+ ** Output: summary of time and work per phase, counter and thread;
+ **   per generation CSV rows or trace events
+ *********************************************************************/
+
+#ifndef Trace_hpp
+#define Trace_hpp
+
+#include <stdint.h>     // header file for fixed width integer types
+#include <string>       // header file for string objects
+#include <ostream>      // header file for output streams
+#include <fstream>      // header file for file streams
+#include <vector>       // header file for vector objects
+#include <mutex>        // header file for mutual exclusion
+
+// phases of a run that are timed
+enum TimerName { READ_TIMER, SEED_TIMER, STEP_TIMER, TILE_TIMER,
+                 RENDER_TIMER, CHECKPOINT_TIMER, CAPTURE_TIMER, ENCODE_TIMER,
+                 TIMERS };
+
+// work that is counted
+enum CounterName { CELLS_COUNTER, STEPPED_COUNTER, SKIPPED_COUNTER,
+                   BIRTHS_COUNTER, DEATHS_COUNTER, BYTES_COUNTER, COUNTERS };
+
+class Trace {
+private:
+    struct Totals {
+        uint64_t counts[COUNTERS];  // work counted by each counter
+        uint64_t calls[TIMERS];     // times each phase was timed
+        uint64_t nanos[TIMERS];     // nanoseconds spent in each phase
+        int thread;                 // number of the thread, from 0
+    };
+    static bool on;             // true once tracing is enabled
+    static bool streaming;      // true while generations are streamed
+    static bool chrome;         // stream is Chrome trace events, not CSV
+    static bool firstEvent;     // no trace event written yet
+    static uint64_t epoch;      // clock when tracing was enabled
+    static std::vector<Totals *> threads;   // every thread's totals
+    static std::mutex lock;     // protects threads and the stream
+    static std::ofstream file;  // file generations are streamed to
+    static Totals last;         // totals when the last generation ended
+    static Totals *local();     // totals of the calling thread
+    static void sum(Totals &);  // add up every thread's totals,
+                                // with the lock held
+    static void writeGeneration(long long); // stream a generation
+    Trace();                    // not constructed, all static
+public:
+    static void enable();                   // start timing and counting
+    static bool stream(const std::string &); // stream generations to file
+    static bool finish();                   // end the stream
+    static void report(std::ostream &);     // print a summary
+    static uint64_t now();                  // clock, in nanoseconds
+    static void record(TimerName, uint64_t, uint64_t); // add a phase
+
+    // true once tracing is enabled
+    static bool isEnabled() {
+        return on;
+    }
+
+    // add work to a counter of the calling thread
+    static void count(CounterName c, uint64_t n) {
+        if (on) {
+            local()->counts[c] += n;
+        }
+    }
+
+    // mark the end of a generation, streaming its work if asked to
+    static void endGeneration(long long generation) {
+        if (streaming) {
+            writeGeneration(generation);
+        }
+    }
+};
+
+// times a phase from its construction to the end of its scope
+class ScopedTimer {
+private:
+    TimerName timer;    // phase being timed
+    uint64_t start;     // clock at the start, 0 if not tracing
+    ScopedTimer(const ScopedTimer &);               // not copyable
+    ScopedTimer &operator=(const ScopedTimer &);    // not assignable
+public:
+    explicit ScopedTimer(TimerName t)
+        : timer(t), start(Trace::isEnabled() ? Trace::now() : 0) {}
+    ~ScopedTimer() {
+        stop();
+    }
+
+    // end the phase before the end of the scope
+    void stop() {
+        if (start != 0) {
+            Trace::record(timer, start, Trace::now());
+            start = 0;
+        }
+    }
+};
+
+#endif /* Trace_hpp */
@@ -0,0 +1,471 @@
+/*********************************************************************
+ ** Program Filename: Universe.cpp, Universe class implementation
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Unbounded Game of Life universe made of 64 x 64 cell
+ **   chunks kept in a hash map.  Bit k of row j of chunk (cx, cy)
+ **   holds cell (64*cx + k, 64*cy + j).  Neighbor n of a chunk, for
+ **   n = 0 to 8, is the chunk at (cx + n%3 - 1, cy + n/3 - 1).
+ ** Input: cell states, number of generations to run
+ ** Output: cell states, generation count, population
+ *********************************************************************/
+
+#include "Universe.hpp"
+#include "Kernel.hpp"
+#include "Trace.hpp"
+
+static const uint64_t ZERO_ROWS[Universe::CHUNK] = { 0 }; // missing chunk
+static const uint64_t ALL_CELLS[1] = { ~uint64_t(0) };     // mask of a row
+
+// chunk coordinate of a cell coordinate, rounding toward minus infinity
+static inline long long chunkOf(long long x) {
+    return x >= 0 ? x / Universe::CHUNK
+                  : -((-x - 1) / Universe::CHUNK) - 1;
+}
+
+
+/*********************************************************************
+ ** Function: Universe
+ ** Description: Universe class constructor
+ ** Parameters: Number of threads stepping the chunks.
+ ** Pre-Conditions: none
+ ** Post-Conditions: An empty universe is created at generation zero.
+ *********************************************************************/
+
+Universe::Universe(int nthreads) : pool(nthreads) {
+    parity = 0;
+    generation = 0;
+    hashing = false;
+    hashValid = false;
+    counting = false;
+    statsValid = false;
+}
+
+
+/*********************************************************************
+ ** Function: ~Universe
+ ** Description: Universe class destructor
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: All chunks are deallocated.
+ *********************************************************************/
+
+Universe::~Universe() {
+    clear();
+}
+
+// hash map key of a chunk
+uint64_t Universe::key(long long cx, long long cy) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) |
+           static_cast<uint32_t>(cy);
+}
+
+// chunk at chunk coordinates, or null if it is not allocated
+Universe::Chunk *Universe::find(long long cx, long long cy) {
+    ChunkMap::iterator it = chunks.find(key(cx, cy));
+    return it == chunks.end() ? 0 : it->second;
+}
+
+// chunk at chunk coordinates, allocated empty if it does not exist
+Universe::Chunk *Universe::make(long long cx, long long cy) {
+    Chunk *&c = chunks[key(cx, cy)];
+    if (c == 0) {
+        c = new Chunk();
+        c->cx = cx;
+        c->cy = cy;
+        c->fresh = true;
+        c->stats.clear();
+    }
+    return c;
+}
+
+// neighbor directions (bits 0 to 8, as above) that live cells in a
+// chunk's rows are touching
+unsigned short Universe::findEdges(const uint64_t *rows) {
+    uint64_t left = 0, right = 0;
+    for (int j = 0; j < CHUNK; j++) {
+        left |= rows[j] & 1;
+        right |= rows[j] >> 63;
+    }
+    uint64_t top = rows[0], bottom = rows[CHUNK-1];
+    unsigned short e = 0;
+    e |= (top & 1) << 0;
+    e |= (top != 0) << 1;
+    e |= (top >> 63) << 2;
+    e |= left << 3;
+    e |= right << 5;
+    e |= (bottom & 1) << 6;
+    e |= (bottom != 0) << 7;
+    e |= (bottom >> 63) << 8;
+    return e;
+}
+
+// name of the engine
+const char *Universe::getName() {
+    return "universe";
+}
+
+// the universe has no edge
+bool Universe::isBounded() {
+    return false;
+}
+
+// free every chunk and restart at generation zero
+void Universe::clear() {
+    for (ChunkMap::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        delete it->second;
+    }
+    chunks.clear();
+    parity = 0;
+    generation = 0;
+    hashValid = false;
+    statsValid = false;
+}
+
+// follow a rule, which must have two states.  Chunks that were stable
+// under the old rule may not be under the new one, so the next time
+// step computes them all.
+bool Universe::setRule(const Rule &r) {
+    Rule next = r;
+    if (next.getStates() != 2) {
+        return false;
+    }
+    rule = next;
+    for (ChunkMap::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        it->second->changed = true;
+    }
+    return true;
+}
+
+// set a cell, allocating its chunk if needed
+void Universe::setCell(long long x, long long y, bool s) {
+    long long cx = chunkOf(x), cy = chunkOf(y);
+    Chunk *c = s ? make(cx, cy) : find(cx, cy);
+    if (c == 0) {
+        return;
+    }
+    uint64_t bit = uint64_t(1) << (x - cx*CHUNK);
+    uint64_t &row = c->rows[parity][y - cy*CHUNK];
+    row = s ? (row | bit) : (row & ~bit);
+    c->changed = true;
+    hashValid = false;
+    statsValid = false;
+    c->edges = findEdges(c->rows[parity]);
+}
+
+// get a cell; cells in unallocated chunks are dead
+bool Universe::getCell(long long x, long long y) {
+    long long cx = chunkOf(x), cy = chunkOf(y);
+    Chunk *c = find(cx, cy);
+    if (c == 0) {
+        return false;
+    }
+    return (c->rows[parity][y - cy*CHUNK] >> (x - cx*CHUNK)) & 1;
+}
+
+// allocate every missing chunk that live cells are touching, so all
+// cells that could be born next time step belong to a chunk
+void Universe::grow() {
+    std::vector<Chunk *> edged;
+    for (ChunkMap::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        if (it->second->edges != 0) {
+            edged.push_back(it->second);
+        }
+    }
+    for (size_t i = 0; i < edged.size(); i++) {
+        Chunk *c = edged[i];
+        for (int n = 0; n < 9; n++) {
+            if ((c->edges >> n) & 1) {
+                make(c->cx + n % 3 - 1, c->cy + n / 3 - 1);
+            }
+        }
+    }
+}
+
+// free chunks that are empty, did not change and are not touched by
+// live cells of a neighbor
+void Universe::shrink() {
+    std::vector<uint64_t> dead;
+    for (ChunkMap::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        Chunk *c = it->second;
+        bool quiet = !c->changed;
+        for (int j = 0; quiet && j < CHUNK; j++) {
+            quiet = c->rows[parity][j] == 0;
+        }
+        for (int n = 0; quiet && n < 9; n++) {
+            quiet = n == 4 || c->near[n] == 0 ||
+                    ((c->near[n]->edges >> (8 - n)) & 1) == 0;
+        }
+        if (quiet) {
+            dead.push_back(it->first);
+        }
+    }
+    for (size_t i = 0; i < dead.size(); i++) {
+        delete chunks[dead[i]];
+        chunks.erase(dead[i]);
+    }
+}
+
+// next state of the rows of a chunk from the columns of words (west,
+// middle, east) for rows -1 to CHUNK around them, using the Life
+// adder network for Conway's Life and the rule's counts otherwise.
+// Returns the bits that changed.
+template <Neighborhood N, bool LIFE>
+static uint64_t stepRows(const uint64_t col[3][Universe::CHUNK + 2],
+                         uint64_t *out, int birth, int survive) {
+    uint64_t diff = 0;
+    for (int j = 1; j <= Universe::CHUNK; j++) {
+        uint64_t a = col[1][j-1], b = col[1][j], d = col[1][j+1];
+        uint64_t aL = (a << 1) | (col[0][j-1] >> 63);
+        uint64_t aR = (a >> 1) | (col[2][j-1] << 63);
+        uint64_t bL = (b << 1) | (col[0][j] >> 63);
+        uint64_t bR = (b >> 1) | (col[2][j] << 63);
+        uint64_t dL = (d << 1) | (col[0][j+1] >> 63);
+        uint64_t dR = (d >> 1) | (col[2][j+1] << 63);
+        uint64_t next = LIFE ? lifeWord(aL, a, aR, bL, b, bR, dL, d, dR)
+                             : ruleWord<N>(birth, survive, aL, a, aR,
+                                           bL, b, bR, dL, d, dR);
+        out[j-1] = next;
+        diff |= next ^ b;
+    }
+    return diff;
+}
+
+// hash of a chunk's rows, each word hashed at its place in the universe
+uint64_t Universe::hashRows(const Chunk *c, const uint64_t *rows) {
+    uint64_t place = key(c->cx, c->cy) * 0xD6E8FEB86659FD93ULL;
+    uint64_t hash = 0;
+    for (int j = 0; j < CHUNK; j++) {
+        if (rows[j] != 0) {
+            hash ^= hashCells(place + j, rows[j]);
+        }
+    }
+    return hash;
+}
+
+// statistics of a chunk's rows, with the births and deaths since the
+// rows before (none if null)
+CellStats Universe::countRows(const Chunk *c, const uint64_t *rows,
+                              const uint64_t *before) {
+    CellStats stats;
+    stats.clear();
+    getCountKernel()(rows, before, ALL_CELLS, 1, 0, CHUNK - 1, 0, 1, stats);
+    if (!stats.isEmpty()) {
+        stats.minX += c->cx*CHUNK;
+        stats.maxX += c->cx*CHUNK;
+        stats.minY += c->cy*CHUNK;
+        stats.maxY += c->cy*CHUNK;
+    }
+    return stats;
+}
+
+// thread pool task: step the n-th chunk in the list, if it needs it
+void Universe::stepChunk(void *context, int n, int) {
+    Universe *u = static_cast<Universe *>(context);
+    Chunk *c = u->list[n];
+    if (!c->computed) {
+        Trace::count(SKIPPED_COUNTER, 1);
+        return;
+    }
+    ScopedTimer timer(TILE_TIMER);
+
+    // current rows of the 3x3 neighborhood, missing chunks all dead
+    const uint64_t *src[9];
+    for (int k = 0; k < 9; k++) {
+        src[k] = c->near[k] ? c->near[k]->rows[u->parity] : ZERO_ROWS;
+    }
+
+    // column of words (west, middle, east) for rows -1 to CHUNK
+    uint64_t col[3][CHUNK + 2];
+    for (int x = 0; x < 3; x++) {
+        col[x][0] = src[x][CHUNK-1];
+        for (int j = 0; j < CHUNK; j++) {
+            col[x][j+1] = src[3 + x][j];
+        }
+        col[x][CHUNK+1] = src[6 + x][0];
+    }
+
+    uint64_t *out = c->rows[1 - u->parity];
+    Rule &rule = u->rule;
+    int birth = rule.getBirth(), survive = rule.getSurvive();
+    uint64_t diff;
+    if (rule.isLife()) {
+        diff = stepRows<MOORE, true>(col, out, birth, survive);
+    } else if (rule.getNeighborhood() == VON_NEUMANN) {
+        diff = stepRows<VON_NEUMANN, false>(col, out, birth, survive);
+    } else if (rule.getNeighborhood() == HEXAGONAL) {
+        diff = stepRows<HEXAGONAL, false>(col, out, birth, survive);
+    } else {
+        diff = stepRows<MOORE, false>(col, out, birth, survive);
+    }
+    c->nextChanged = diff != 0;
+    c->nextEdges = findEdges(out);
+    Trace::count(STEPPED_COUNTER, 1);
+    Trace::count(CELLS_COUNTER, CHUNK * CHUNK);
+    if ((u->counting || Trace::isEnabled()) && c->nextChanged) {
+        c->nextStats = countRows(c, out, src[4]);
+        Trace::count(BIRTHS_COUNTER, c->nextStats.births);
+        Trace::count(DEATHS_COUNTER, c->nextStats.deaths);
+    }
+    if (u->hashing) {
+        c->hash[1 - u->parity] = c->nextChanged ? hashRows(c, out)
+                                                : c->hash[u->parity];
+    }
+}
+
+
+// advance one generation
+void Universe::stepOnce() {
+    ScopedTimer timer(STEP_TIMER);
+    grow();
+    list.clear();
+    for (ChunkMap::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        list.push_back(it->second);
+    }
+    for (size_t i = 0; i < list.size(); i++) {
+        Chunk *c = list[i];
+        c->computed = c->fresh;
+        for (int k = 0; k < 9; k++) {
+            c->near[k] = find(c->cx + k % 3 - 1, c->cy + k / 3 - 1);
+            c->computed = c->computed || (c->near[k] && c->near[k]->changed);
+        }
+    }
+    pool.run(static_cast<int>(list.size()), stepChunk, this);
+    for (size_t i = 0; i < list.size(); i++) {
+        Chunk *c = list[i];
+        c->changed = c->computed && c->nextChanged;
+        if (c->changed && counting) {
+            c->stats = c->nextStats;
+        } else {
+            c->stats.births = 0;
+            c->stats.deaths = 0;
+        }
+        if (c->computed) {
+            c->edges = c->nextEdges;
+        } else if (hashing) {
+            c->hash[1 - parity] = c->hash[parity];
+        }
+        c->fresh = false;
+    }
+    parity = 1 - parity;
+    generation++;
+    shrink();
+}
+
+
+/*********************************************************************
+ ** Function: step
+ ** Description: Advance the universe n generations.
+ ** Parameters: Number of generations.
+ ** Pre-Conditions: none
+ ** Post-Conditions: The universe holds generation getGeneration()+n.
+ **   A chunk is only recomputed if it or a neighbor changed in the
+ **   previous time step; any other chunk is stable and its old state
+ **   is still in its other row buffer.
+ *********************************************************************/
+
+void Universe::step(long long n) {
+    for (long long t = 0; t < n; t++) {
+        stepOnce();
+        Trace::endGeneration(generation);
+    }
+}
+
+// number of generations run since the last clear
+long long Universe::getGeneration() {
+    return generation;
+}
+
+// set the generation count, keeping the cells
+void Universe::setGeneration(long long n) {
+    generation = n;
+}
+
+// number of live cells
+long long Universe::getPopulation() {
+    long long n = 0;
+    for (ChunkMap::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        for (int j = 0; j < CHUNK; j++) {
+            n += __builtin_popcountll(it->second->rows[parity][j]);
+        }
+    }
+    return n;
+}
+
+
+
+/*********************************************************************
+ ** Function: getHash
+ ** Description: Hash the live cells of the universe.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the XOR of the chunk hashes.  The first
+ **   call hashes every chunk and turns on hashing, after which each
+ **   time step rehashes only the chunks it changed.  Empty chunks hash
+ **   to zero, so allocating and freeing them leaves the hash alone.
+ *********************************************************************/
+
+uint64_t Universe::getHash() {
+    uint64_t hash = 0;
+    for (ChunkMap::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        Chunk *c = it->second;
+        if (!hashing || !hashValid) {
+            c->hash[parity] = hashRows(c, c->rows[parity]);
+        }
+        hash ^= c->hash[parity];
+    }
+    hashing = true;
+    hashValid = true;
+    return hash;
+}
+
+// the chunks update their hashes as they step
+bool Universe::tracksHash() {
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: getStats
+ ** Description: Get the statistics of the live cells of the universe.
+ ** Parameters: none
+ ** Pre-Conditions: none
+ ** Post-Conditions: Returns the sum of the chunk statistics.  As with
+ **   getHash, the first call counts every chunk, with no births or
+ **   deaths, and turns on counting, after which each time step counts
+ **   only the chunks it changed.
+ *********************************************************************/
+
+CellStats Universe::getStats() {
+    CellStats stats;
+    stats.clear();
+    for (ChunkMap::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        Chunk *c = it->second;
+        if (!counting || !statsValid) {
+            c->stats = countRows(c, c->rows[parity], 0);
+        }
+        stats.add(c->stats);
+    }
+    counting = true;
+    statsValid = true;
+    return stats;
+}
+
+// call a function with the coordinates of every live cell
+void Universe::forEachCell(CellFunction fn, void *context) {
+    for (ChunkMap::iterator it = chunks.begin(); it != chunks.end(); ++it) {
+        Chunk *c = it->second;
+        for (int j = 0; j < CHUNK; j++) {
+            uint64_t bits = c->rows[parity][j];
+            for (; bits != 0; bits &= bits - 1) {
+                fn(context, c->cx*CHUNK + __builtin_ctzll(bits),
+                   c->cy*CHUNK + j);
+            }
+        }
+    }
+}
+
+// number of allocated chunks
+size_t Universe::getChunks() {
+    return chunks.size();
+}
@@ -0,0 +1,87 @@
+/*********************************************************************
+ ** Program Filename: Universe.hpp, Universe class specification
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description:  Unbounded Game of Life universe made of 64 x 64 cell
+ **   chunks kept in a hash map.  A chunk is allocated when live cells
+ **   reach its edge and freed once it is empty and quiet again, so
+ **   memory follows the live population instead of the board size,
+ **   and only chunks near last time step's changes are recomputed.
+ **   Once asked for, a hash of the cells is kept per chunk and
+ **   updated only for chunks that change, and so are the statistics
+ **   of the cells.
+ ** Input: cell states, number of generations to run
+ ** Output: cell states, generation count, population
+ *********************************************************************/
+
+#ifndef Universe_hpp
+#define Universe_hpp
+
+#include <vector>           // header file for vector objects
+#include <unordered_map>    // header file for hash maps
+#include <stdint.h>         // header file for fixed width integer types
+#include "Engine.hpp"
+#include "ThreadPool.hpp"
+
+class Universe : public Engine {
+public:
+    static const int CHUNK = 64;    // cells on a side of each chunk
+private:
+    struct Chunk {
+        long long cx, cy;           // chunk coordinates (cell / CHUNK)
+        uint64_t rows[2][CHUNK];    // even and odd time step, one word a row
+        Chunk *near[9];             // 3x3 neighborhood, self in middle
+        bool changed;               // changed by the last time step
+        bool computed;              // stepped this time step
+        bool fresh;                 // allocated since the last time step
+        unsigned short edges;       // neighbors its live cells touch
+        unsigned short nextEdges;   // edges after this time step
+        bool nextChanged;           // changed by this time step
+        uint64_t hash[2];           // hash of the rows of each time step
+        CellStats stats;            // statistics of the current rows
+        CellStats nextStats;        // statistics after this time step
+    };
+    typedef std::unordered_map<uint64_t, Chunk *> ChunkMap;
+    ChunkMap chunks;                // every allocated chunk
+    std::vector<Chunk *> list;      // chunks being stepped
+    ThreadPool pool;                // worker threads
+    int parity;                     // rows[parity] is the current state
+    long long generation;           // generations run since last clear
+    bool hashing;                   // keep chunk hashes up to date
+    bool hashValid;                 // chunk hashes match the cells
+    bool counting;                  // keep chunk statistics up to date
+    bool statsValid;                // chunk statistics match the cells
+    static uint64_t key(long long, long long); // hash map key of a chunk
+    Chunk *find(long long, long long);  // chunk or null
+    Chunk *make(long long, long long);  // chunk, allocated if missing
+    static unsigned short findEdges(const uint64_t *); // live edge bits
+    static uint64_t hashRows(const Chunk *, const uint64_t *); // hash rows
+    static CellStats countRows(const Chunk *, const uint64_t *,
+                               const uint64_t *); // statistics of rows
+    static void stepChunk(void *, int, int);  // thread pool task
+    void grow();                    // allocate chunks edges reach
+    void shrink();                  // free quiet empty chunks
+    void stepOnce();                // advance one generation
+    Universe(const Universe &);             // not copyable
+    Universe &operator=(const Universe &);  // not assignable
+public:
+    Universe(int);                  // constructor
+    ~Universe();                    // destructor
+    const char *getName();
+    bool isBounded();
+    void clear();
+    bool setRule(const Rule &);
+    void setCell(long long, long long, bool);
+    bool getCell(long long, long long);
+    void step(long long);
+    long long getGeneration();
+    void setGeneration(long long);
+    long long getPopulation();
+    void forEachCell(CellFunction, void *);
+    uint64_t getHash();
+    bool tracksHash();
+    CellStats getStats();
+    size_t getChunks();             // get number of allocated chunks
+};
+
+#endif /* Universe_hpp */
@@ -0,0 +1,882 @@
+/*********************************************************************
+ ** Program Filename: bench.cpp
+ ** Author: Diana Bacon
+ ** Date: 2015-09-26
+ ** Description: Benchmark for the Game of Life engines.  Runs a matrix
+ **         of board sizes and workloads (random soups at several fill
+ **         densities and the bundled seed patterns) on every engine
+ **         and thread count, each case in its own process so its peak
+ **         memory use can be measured.  Engines simulating the same
+ **         kind of board (bounded or unbounded) must end with the same
+ **         population, so a wrong engine shows up as a mismatch.
+ ** Input:  Optional arguments, lists are separated by commas:
+ **           --sizes=256,1024,4096  board widths (boards are square)
+ **           --densities=0.25,0.5  fill of the random soups
+ **           --seeds=FILE,...  seed patterns (default the bundled ones)
+ **             (an empty list, e.g. --seeds=, leaves out a workload)
+ **           --engines=bool,packed,universe,hashlife,domain  engines
+ **             to run
+ **           --rules=B3/S23,...  rules to run (default B3/S23); an
+ **             engine is left out of rules it cannot run
+ **           --boundary=plane|dead|torus|klein  edges of the bounded
+ **             engines' boards (default plane); other than plane, the
+ **             unbounded engines are left out
+ **           --threads=1,N  thread counts of the packed grid and
+ **             universe, and process counts of the domain engine
+ **             (default 1 and the number of cores)
+ **           --gens=N  generations per case (default by board size)
+ **           --block=K  generations the packed grid steps per pass over
+ **             the board (default 1); the other engines step one
+ **           --rng=N  random number seed of the soups
+ **           --simd=auto|scalar|sse2|avx2|avx512  packed grid kernel;
+ **             --simd=all instead runs the matrix on the packed grid
+ **             with every kernel the CPU supports, and each thread
+ **             count, and checks that they end with the same cells
+ **           --format=csv|json  output format (default csv)
+ **           --grids=N  instead of the matrix, count the memory
+ **             allocations of N board reuses (a grid made, moved,
+ **             swapped, resized and dropped, and a packed grid resized
+ **             up and down) and of N generations of a soup on each
+ **             bounded engine, after a warm-up
+ **           --fill=N  instead of the matrix, time N fills of each
+ **             board with each soup on every engine and thread count
+ ** Output: One line of results per case: rule, generations/second, cell
+ **         updates/second, nanoseconds per cell update, final
+ **         population, peak resident memory and whether the population
+ **         matches the first engine run on the same case.  Returns 1
+ **         if any case failed or did not match.  With --grids, one
+ **         line per engine and size: heap and grid pool allocations,
+ **         in all and per board reuse or generation.  With --fill, one
+ **         line per engine, thread count, size and fill: seconds per
+ **         fill, cells filled per second and population, which must
+ **         match the first engine's.  With --simd=all, one line per
+ **         kernel, thread count and case: time, population and a hash
+ **         of the cells, which must match the scalar kernel's.
+ *********************************************************************/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <utility>
+#include <new>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "Engine.hpp"
+#include "Kernel.hpp"
+#include "GridPool.hpp"
+#include "PackedGrid.hpp"
+#include "Soup.hpp"
+
+// heap allocations made by this process, counted by the operator new
+// below for the --grids benchmark
+static std::atomic<long long> heapAllocations(0);
+
+// allocate from the heap, counting the allocation
+void *operator new(size_t n) {
+    heapAllocations++;
+    void *p = malloc(n > 0 ? n : 1);
+    if (p == 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+// free memory from operator new
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+// one benchmark case
+struct Case {
+    Backend backend;        // engine
+    int threads;            // worker threads
+    int size;               // board width and height
+    double density;         // fill of a random soup
+    std::string seedFile;   // seed pattern, or empty for a soup
+    std::string rule;       // rule the cells follow
+    Boundary boundary;      // edges of a bounded board
+    long long gens;         // generations to run
+    uint64_t rng;           // random number seed of a soup
+    int block;              // generations per pass over the board
+};
+
+// measurements of a case, passed back from the process running it
+struct Result {
+    int ok;                 // 1 if the case ran
+    double seconds;         // time to run the generations
+    long long population;   // live cells at the end
+};
+
+// split a comma separated list
+static std::vector<std::string> split(const std::string &list) {
+    std::vector<std::string> items;
+    std::stringstream in(list);
+    std::string item;
+    while (getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// fill the visible board with a random soup or a centered seed pattern
+static bool loadWorkload(Engine *engine, const Case &c) {
+    long long origin = Grid(1, 1).getHide() + 1;
+    if (!c.seedFile.empty()) {
+        Seed seed;
+        if (!seed.readPath(c.seedFile)) {
+            return false;
+        }
+        engine->loadSeed(seed, origin + c.size/2, origin + c.size/2);
+        return true;
+    }
+    engine->loadSoup(Soup(c.rng, c.density), origin, origin, c.size, c.size);
+    return true;
+}
+
+// run a case in this process
+static Result runCase(const Case &c) {
+    Result r;
+    r.ok = 0;
+    r.seconds = 0;
+    r.population = 0;
+    Engine *engine = Engine::create(c.backend, c.size, c.size, c.threads);
+    Rule rule;
+    if (rule.parse(c.rule) && engine->setRule(rule) &&
+        engine->setBoundary(c.boundary) && loadWorkload(engine, c)) {
+        engine->setBlock(c.block);
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        engine->step(c.gens);
+        r.seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        r.population = engine->getPopulation();
+        r.ok = 1;
+    }
+    delete engine;
+    return r;
+}
+
+// run a case in a child process; peakKB is the child's peak memory use
+static Result forkCase(const Case &c, long &peakKB) {
+    Result r;
+    r.ok = 0;
+    r.seconds = 0;
+    r.population = 0;
+    peakKB = 0;
+    int fd[2];
+    if (pipe(fd) != 0) {
+        return r;
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fd[0]);
+        Result child = runCase(c);
+        ssize_t n = write(fd[1], &child, sizeof(child));
+        _exit(n == sizeof(child) ? 0 : 1);
+    }
+    close(fd[1]);
+    if (pid > 0) {
+        if (read(fd[0], &r, sizeof(r)) != sizeof(r)) {
+            r.ok = 0;
+        }
+        int status;
+        struct rusage usage;
+        if (wait4(pid, &status, 0, &usage) == pid) {
+            peakKB = usage.ru_maxrss;
+        }
+    }
+    close(fd[0]);
+    return r;
+}
+
+// allocations counted by the --grids benchmark: from the heap and
+// from the system by the grid pool
+struct Allocations {
+    long long heap;         // calls of operator new
+    long long pool;         // blocks the grid pool allocated
+
+    // the allocations made so far
+    static Allocations now() {
+        Allocations a;
+        a.heap = heapAllocations;
+        a.pool = GridPool::shared().getAllocations();
+        return a;
+    }
+};
+
+// make, move, swap, resize and drop a board as a service reusing its
+// boards would
+static void reuseBoard(int size) {
+    Grid current(size, size);
+    Grid future(size/2 + 1, size/2 + 1);
+    future.resize(size, size);
+    current.setState(1, 1, 1);
+    current.swap(future);
+    Grid moved(std::move(future));
+    moved.resize(size/2 + 1, size);
+    current = std::move(moved);
+}
+
+// resize a packed board up and back down, as a service reusing it for
+// boards of several sizes would
+static void reusePackedBoard(PackedGrid &board, int size) {
+    board.resize(size, size);
+    board.setState(1, 1, true);
+    board.resize(size/2 + 1, size);
+}
+
+// allocations made by rounds board reuses or generations since before
+static void printAllocations(const std::string &kind, const std::string &name,
+                             int threads, int size, long long rounds,
+                             const Allocations &before, bool json, bool last) {
+    Allocations after = Allocations::now();
+    long long heap = after.heap - before.heap;
+    long long pool = after.pool - before.pool;
+    double perRound = static_cast<double>(heap + pool) / rounds;
+    char line[512];
+    if (json) {
+        snprintf(line, sizeof(line),
+                 "  {\"kind\": \"%s\", \"engine\": \"%s\", "
+                 "\"threads\": %d, \"size\": %d, \"rounds\": %lld, "
+                 "\"heap_allocations\": %lld, \"pool_allocations\": %lld, "
+                 "\"allocations_per_round\": %.6g}%s",
+                 kind.c_str(), name.c_str(), threads, size, rounds,
+                 heap, pool, perRound, last ? "" : ",");
+    } else {
+        snprintf(line, sizeof(line), "%s,%s,%d,%d,%lld,%lld,%lld,%.6g",
+                 kind.c_str(), name.c_str(), threads, size, rounds,
+                 heap, pool, perRound);
+    }
+    std::cout << line << std::endl;
+}
+
+
+/*********************************************************************
+ ** Function: countAllocations
+ ** Description: Count the memory allocations of reusing a board and
+ **   of stepping the bounded engines.
+ ** Parameters: Rounds to count, board widths, engines, thread counts,
+ **   edges of the boards, random number seed of the soups, and
+ **   whether to output JSON.
+ ** Pre-Conditions: none
+ ** Post-Conditions: For each board width, prints the allocations of
+ **   rounds reuses of a grid and of a packed grid, then of rounds
+ **   generations of a half full soup on each bounded engine and thread
+ **   count.  Each is counted after one round or generation of
+ **   warm-up, which fills the grid pool and the engines' buffers.
+ **   Returns true if every engine could run.
+ *********************************************************************/
+
+static bool countAllocations(long long rounds, const std::vector<int> &sizes,
+                             const std::vector<Backend> &backends,
+                             const std::vector<int> &threads,
+                             Boundary boundary, uint64_t rng, bool json) {
+
+    // list what to count: board reuse, then each bounded engine
+    std::vector<Case> cases;
+    for (size_t s = 0; s < sizes.size(); s++) {
+        Case c = Case();
+        c.backend = BOOL_BACKEND;
+        c.threads = 0;
+        c.size = sizes[s];
+        cases.push_back(c);
+        for (size_t b = 0; b < backends.size(); b++) {
+            Engine *engine = Engine::create(backends[b], 1, 1, 1);
+            bool bounded = engine->isBounded();
+            delete engine;
+            if (!bounded) {
+                continue;
+            }
+            bool threaded = backends[b] != BOOL_BACKEND;
+            for (size_t t = 0; t < (threaded ? threads.size() : 1); t++) {
+                c.backend = backends[b];
+                c.threads = threaded ? threads[t] : 1;
+                c.density = 0.5;
+                c.rule = "B3/S23";
+                c.boundary = boundary;
+                c.rng = rng;
+                cases.push_back(c);
+            }
+        }
+    }
+
+    if (json) {
+        std::cout << "[" << std::endl;
+    } else {
+        std::cout << "kind,engine,threads,size,rounds,heap_allocations,"
+                     "pool_allocations,allocations_per_round" << std::endl;
+    }
+    bool ok = true;
+    for (size_t i = 0; i < cases.size(); i++) {
+        const Case &c = cases[i];
+        bool last = i + 1 == cases.size();
+        if (c.threads == 0) {
+            reuseBoard(c.size);
+            Allocations before = Allocations::now();
+            for (long long r = 0; r < rounds; r++) {
+                reuseBoard(c.size);
+            }
+            printAllocations("board", "grid", 1, c.size, rounds,
+                             before, json, false);
+            PackedGrid board(c.size/2 + 1, c.size);
+            reusePackedBoard(board, c.size);
+            before = Allocations::now();
+            for (long long r = 0; r < rounds; r++) {
+                reusePackedBoard(board, c.size);
+            }
+            printAllocations("board", "packed", 1, c.size, rounds,
+                             before, json, last);
+            continue;
+        }
+        Engine *engine = Engine::create(c.backend, c.size, c.size, c.threads);
+        if (!engine->setBoundary(c.boundary) || !loadWorkload(engine, c)) {
+            ok = false;
+            delete engine;
+            continue;
+        }
+        engine->step(1);
+        Allocations before = Allocations::now();
+        for (long long r = 0; r < rounds; r++) {
+            engine->step(1);
+        }
+        printAllocations("generation", engine->getName(), c.threads, c.size,
+                         rounds, before, json, last);
+        delete engine;
+    }
+    if (json) {
+        std::cout << "]" << std::endl;
+    }
+    return ok;
+}
+
+
+
+/*********************************************************************
+ ** Function: timeFills
+ ** Description: Time filling the boards of the engines with soups.
+ ** Parameters: Fills to time, board widths, soup fills, engines,
+ **   thread counts, edges of the boards, random number seed of the
+ **   soups, and whether to output JSON.
+ ** Pre-Conditions: none
+ ** Post-Conditions: For each board width and fill, prints the time
+ **   each engine and thread count takes to fill the visible board with
+ **   the soup, and the population it ends with, which must match the
+ **   first engine's: a soup does not depend on the engine or on the
+ **   number of threads filling it.  Returns true if every engine
+ **   could run and every population matched.
+ *********************************************************************/
+
+static bool timeFills(long long fills, const std::vector<int> &sizes,
+                      const std::vector<double> &densities,
+                      const std::vector<Backend> &backends,
+                      const std::vector<int> &threads,
+                      Boundary boundary, uint64_t rng, bool json) {
+    if (json) {
+        std::cout << "[" << std::endl;
+    } else {
+        std::cout << "engine,threads,size,density,fills,seconds,"
+                     "cells_per_sec,population,match" << std::endl;
+    }
+    bool ok = true;
+    bool first = true;
+    long long origin = Grid(1, 1).getHide() + 1;
+    for (size_t s = 0; s < sizes.size(); s++) {
+        for (size_t d = 0; d < densities.size(); d++) {
+            long long reference = -1;   // population of the first engine
+            for (size_t b = 0; b < backends.size(); b++) {
+                bool threaded = backends[b] == PACKED_BACKEND ||
+                                backends[b] == UNIVERSE_BACKEND ||
+                                backends[b] == DOMAIN_BACKEND;
+                for (size_t t = 0; t < (threaded ? threads.size() : 1); t++) {
+                    int n = threaded ? threads[t] : 1;
+                    Engine *engine = Engine::create(backends[b], sizes[s],
+                                                    sizes[s], n);
+                    if (!engine->setBoundary(boundary)) {
+                        delete engine;
+                        continue;
+                    }
+                    Soup soup(rng, densities[d]);
+                    std::chrono::steady_clock::time_point start =
+                        std::chrono::steady_clock::now();
+                    for (long long f = 0; f < fills; f++) {
+                        engine->loadSoup(soup, origin, origin,
+                                         sizes[s], sizes[s]);
+                    }
+                    double seconds = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count()
+                        / fills;
+                    long long population = engine->getPopulation();
+                    const char *match = "-";
+                    if (reference < 0) {
+                        reference = population;
+                    } else if (population == reference) {
+                        match = "yes";
+                    } else {
+                        match = "no";
+                        ok = false;
+                    }
+                    double cells = static_cast<double>(sizes[s]) * sizes[s];
+                    double cellsPerSec = seconds > 0 ? cells / seconds : 0;
+                    char line[512];
+                    if (json) {
+                        snprintf(line, sizeof(line),
+                                 "%s  {\"engine\": \"%s\", \"threads\": %d, "
+                                 "\"size\": %d, \"density\": %g, "
+                                 "\"fills\": %lld, \"seconds\": %.6f, "
+                                 "\"cells_per_sec\": %.6g, "
+                                 "\"population\": %lld, \"match\": \"%s\"}",
+                                 first ? "" : ",\n", engine->getName(), n,
+                                 sizes[s], densities[d], fills, seconds,
+                                 cellsPerSec, population, match);
+                        std::cout << line;
+                    } else {
+                        snprintf(line, sizeof(line),
+                                 "%s,%d,%d,%g,%lld,%.6f,%.6g,%lld,%s",
+                                 engine->getName(), n, sizes[s],
+                                 densities[d], fills, seconds, cellsPerSec,
+                                 population, match);
+                        std::cout << line << std::endl;
+                    }
+                    first = false;
+                    delete engine;
+                }
+            }
+        }
+    }
+    if (json) {
+        std::cout << (first ? "" : "\n") << "]" << std::endl;
+    }
+    return ok;
+}
+
+// default generations: fewer on larger boards, at least 8
+static long long defaultGens(int size) {
+    long long gens = (1LL << 26) / (static_cast<long long>(size) * size);
+    return gens < 8 ? 8 : gens > 1000 ? 1000 : gens;
+}
+
+// value of a "--name=value" argument; false if arg is not the option
+static bool option(const std::string &arg, const char *name,
+                   std::string &value) {
+    std::string prefix = std::string("--") + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+
+/*********************************************************************
+ ** Function: compareKernels
+ ** Description: Check that every packed grid kernel this CPU runs
+ **   computes the same cells.
+ ** Parameters: Board widths, soup fills, seed patterns, rules, thread
+ **   counts, edges of the boards, generations (0 for the default),
+ **   random number seed of the soups, generations per pass, and
+ **   whether to output JSON.
+ ** Pre-Conditions: none
+ ** Post-Conditions: For each board width, workload and rule the packed
+ **   grid can run, prints the time, population and a hash of the live
+ **   cells each kernel (scalar up to the widest supported) and thread
+ **   count ends with.  The hash is taken cell by cell, not by the
+ **   kernels' own hash, and must match the first run's, as must the
+ **   population and the kernel's hash.  Leaves the widest kernel
+ **   selected.  Returns true if every run could start and matched.
+ *********************************************************************/
+
+static bool compareKernels(const std::vector<int> &sizes,
+                           const std::vector<double> &densities,
+                           const std::vector<std::string> &seeds,
+                           const std::vector<std::string> &rules,
+                           const std::vector<int> &threads,
+                           Boundary boundary, long long gens, uint64_t rng,
+                           int block, bool json) {
+    if (json) {
+        std::cout << "[" << std::endl;
+    } else {
+        std::cout << "simd,threads,size,workload,rule,generations,seconds,"
+                     "population,cells_hash,match" << std::endl;
+    }
+    bool ok = true;
+    bool first = true;
+    SimdLevel best = detectSimd();
+    for (size_t s = 0; s < sizes.size(); s++) {
+        for (size_t w = 0; w < densities.size() + seeds.size(); w++) {
+            for (size_t k = 0; k < rules.size(); k++) {
+                Case c;
+                c.backend = PACKED_BACKEND;
+                c.size = sizes[s];
+                c.density = w < densities.size() ? densities[w] : 0;
+                c.seedFile = w < densities.size() ? "" :
+                             seeds[w - densities.size()];
+                c.rule = rules[k];
+                c.boundary = boundary;
+                c.gens = gens > 0 ? gens : defaultGens(sizes[s]);
+                c.rng = rng;
+                c.block = block;
+                char workload[64];
+                if (c.seedFile.empty()) {
+                    snprintf(workload, sizeof(workload), "soup%g", c.density);
+                } else {
+                    snprintf(workload, sizeof(workload), "%.63s",
+                             c.seedFile.c_str());
+                }
+                bool reference = false;     // first run's results kept
+                long long population = 0;
+                uint64_t cells = 0, kernelHash = 0;
+                for (int level = SIMD_SCALAR; level <= best; level++) {
+                    setSimdLevel(static_cast<SimdLevel>(level));
+                    for (size_t t = 0; t < threads.size(); t++) {
+                        c.threads = threads[t];
+                        Engine *engine = Engine::create(c.backend, c.size,
+                                                        c.size, c.threads);
+                        Rule rule;
+                        if (!rule.parse(c.rule) || !engine->setRule(rule)) {
+                            delete engine;
+                            break;
+                        }
+                        const char *match = "failed";
+                        double seconds = 0;
+                        long long p = 0;
+                        uint64_t h = 0;
+                        if (engine->setBoundary(c.boundary) &&
+                            engine->setBlock(c.block) &&
+                            loadWorkload(engine, c)) {
+                            std::chrono::steady_clock::time_point start =
+                                std::chrono::steady_clock::now();
+                            engine->step(c.gens);
+                            seconds = std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+                            p = engine->getPopulation();
+                            h = engine->Engine::getHash();
+                            uint64_t kh = engine->getHash();
+                            if (!reference) {
+                                reference = true;
+                                population = p;
+                                cells = h;
+                                kernelHash = kh;
+                                match = "-";
+                            } else if (p == population && h == cells &&
+                                       kh == kernelHash) {
+                                match = "yes";
+                            } else {
+                                match = "no";
+                            }
+                        }
+                        ok = ok && strcmp(match, "no") != 0 &&
+                             strcmp(match, "failed") != 0;
+                        const char *name =
+                            simdName(static_cast<SimdLevel>(level));
+                        char line[512];
+                        if (json) {
+                            snprintf(line, sizeof(line),
+                                     "%s  {\"simd\": \"%s\", "
+                                     "\"threads\": %d, \"size\": %d, "
+                                     "\"workload\": \"%s\", "
+                                     "\"rule\": \"%s\", "
+                                     "\"generations\": %lld, "
+                                     "\"seconds\": %.6f, "
+                                     "\"population\": %lld, "
+                                     "\"cells_hash\": \"%016llx\", "
+                                     "\"match\": \"%s\"}",
+                                     first ? "" : ",\n", name, c.threads,
+                                     c.size, workload, c.rule.c_str(), c.gens,
+                                     seconds, p,
+                                     static_cast<unsigned long long>(h),
+                                     match);
+                            std::cout << line;
+                        } else {
+                            snprintf(line, sizeof(line),
+                                     "%s,%d,%d,%s,%s,%lld,%.6f,%lld,%016llx,%s",
+                                     name, c.threads, c.size, workload,
+                                     c.rule.c_str(), c.gens, seconds, p,
+                                     static_cast<unsigned long long>(h),
+                                     match);
+                            std::cout << line << std::endl;
+                        }
+                        first = false;
+                        delete engine;
+                    }
+                }
+            }
+        }
+    }
+    setSimdLevel(SIMD_AUTO);
+    if (json) {
+        std::cout << (first ? "" : "\n") << "]" << std::endl;
+    }
+    return ok;
+}
+
+
+int main(int argc, const char * argv[]) {
+
+    std::vector<int> sizes;             // board widths
+    std::vector<double> densities;      // soup fills
+    std::vector<std::string> seeds;     // seed pattern files
+    std::vector<Backend> backends;      // engines
+    std::vector<std::string> rules;     // rule strings
+    std::vector<int> threads;           // thread counts
+    Boundary boundary = PLANE_BOUNDARY; // edges of the bounded boards
+    long long gens = 0;                 // generations, 0 for default
+    uint64_t rng = 1;                   // random number seed
+    int block = 1;                      // generations per pass
+    long long grids = 0;                // board reuses to count, if any
+    long long fills = 0;                // soup fills to time, if any
+    bool json = false;                  // output JSON instead of CSV
+    bool allKernels = false;            // compare every packed kernel
+
+    // defaults, replaced by the lists given as options
+    int sizeList[] = { 256, 1024, 4096 };
+    sizes.assign(sizeList, sizeList + 3);
+    densities.push_back(0.25);
+    densities.push_back(0.5);
+    seeds.push_back("glider_106.lif");
+    seeds.push_back("blinker_106.lif");
+    seeds.push_back("gosperglidergun_106.lif");
+    backends.push_back(BOOL_BACKEND);
+    backends.push_back(PACKED_BACKEND);
+    backends.push_back(UNIVERSE_BACKEND);
+    backends.push_back(HASHLIFE_BACKEND);
+    backends.push_back(DOMAIN_BACKEND);
+    rules.push_back("B3/S23");
+    threads.push_back(1);
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores > 1) {
+        threads.push_back(cores);
+    }
+
+    // read command line options
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        std::string value;
+        bool ok = true;
+        if (option(arg, "sizes", value)) {
+            std::vector<std::string> items = split(value);
+            sizes.clear();
+            for (size_t i = 0; i < items.size(); i++) {
+                sizes.push_back(atoi(items[i].c_str()));
+                ok = ok && sizes.back() > 0;
+            }
+        } else if (option(arg, "densities", value)) {
+            std::vector<std::string> items = split(value);
+            densities.clear();
+            for (size_t i = 0; i < items.size(); i++) {
+                densities.push_back(atof(items[i].c_str()));
+                ok = ok && densities.back() >= 0 && densities.back() <= 1;
+            }
+        } else if (option(arg, "seeds", value)) {
+            seeds = split(value);
+        } else if (option(arg, "engines", value)) {
+            std::vector<std::string> items = split(value);
+            backends.clear();
+            for (size_t i = 0; i < items.size(); i++) {
+                Backend b;
+                ok = ok && Engine::parseBackend(items[i], b);
+                backends.push_back(b);
+            }
+        } else if (option(arg, "rules", value)) {
+            rules = split(value);
+            for (size_t i = 0; i < rules.size(); i++) {
+                Rule rule;
+                ok = ok && rule.parse(rules[i]);
+            }
+        } else if (option(arg, "block", value)) {
+            block = atoi(value.c_str());
+            ok = block > 0;
+        } else if (option(arg, "boundary", value)) {
+            ok = Engine::parseBoundary(value, boundary);
+        } else if (option(arg, "threads", value)) {
+            std::vector<std::string> items = split(value);
+            threads.clear();
+            for (size_t i = 0; i < items.size(); i++) {
+                threads.push_back(atoi(items[i].c_str()));
+                ok = ok && threads.back() > 0;
+            }
+        } else if (option(arg, "gens", value)) {
+            gens = atoll(value.c_str());
+            ok = gens > 0;
+        } else if (option(arg, "rng", value)) {
+            rng = strtoull(value.c_str(), NULL, 10);
+        } else if (option(arg, "simd", value)) {
+            SimdLevel simd;
+            allKernels = value == "all";
+            ok = allKernels || (parseSimd(value, simd) && setSimdLevel(simd));
+        } else if (option(arg, "format", value)) {
+            ok = value == "csv" || value == "json";
+            json = value == "json";
+        } else if (option(arg, "grids", value)) {
+            grids = atoll(value.c_str());
+            ok = grids > 0;
+        } else if (option(arg, "fill", value)) {
+            fills = atoll(value.c_str());
+            ok = fills > 0;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "usage: lifebench [--sizes=N,...] [--densities=F,...]";
+            std::cerr << " [--seeds=FILE,...]" << std::endl;
+            std::cerr << "                 [--engines=bool,packed,universe,hashlife,domain]";
+            std::cerr << " [--rules=RULE,...]" << std::endl;
+            std::cerr << "                 [--boundary=plane|dead|torus|klein]";
+            std::cerr << std::endl;
+            std::cerr << "                 [--threads=N,...] [--gens=N]";
+            std::cerr << " [--block=K] [--rng=N]" << std::endl;
+            std::cerr << "                 [--simd=auto|all|scalar|sse2|avx2|avx512]";
+            std::cerr << " [--format=csv|json]" << std::endl;
+            std::cerr << "                 [--grids=N] [--fill=N]" << std::endl;
+            return 1;
+        }
+    }
+
+    // count allocations instead of timing the matrix
+    if (grids > 0) {
+        return countAllocations(grids, sizes, backends, threads, boundary,
+                                rng, json) ? 0 : 1;
+    }
+
+    // time filling the boards with soups instead of stepping them
+    if (fills > 0) {
+        return timeFills(fills, sizes, densities, backends, threads,
+                         boundary, rng, json) ? 0 : 1;
+    }
+
+    // check the packed grid's kernels against each other instead
+    if (allKernels) {
+        return compareKernels(sizes, densities, seeds, rules, threads,
+                              boundary, gens, rng, block, json) ? 0 : 1;
+    }
+
+    // list the cases: each workload of each size under each rule on
+    // each engine that can run the rule
+    std::vector<Case> cases;
+    for (size_t s = 0; s < sizes.size(); s++) {
+        for (size_t w = 0; w < densities.size() + seeds.size(); w++) {
+            for (size_t k = 0; k < rules.size(); k++) {
+                for (size_t b = 0; b < backends.size(); b++) {
+                    Rule rule;
+                    rule.parse(rules[k]);
+                    Engine *engine = Engine::create(backends[b], 1, 1, 1);
+                    bool runs = engine->setRule(rule) &&
+                                engine->setBoundary(boundary);
+                    delete engine;
+                    if (!runs) {
+                        continue;
+                    }
+                    bool threaded = backends[b] == PACKED_BACKEND ||
+                                    backends[b] == UNIVERSE_BACKEND ||
+                                    backends[b] == DOMAIN_BACKEND;
+                    for (size_t t = 0; t < (threaded ? threads.size() : 1); t++) {
+                        Case c;
+                        c.backend = backends[b];
+                        c.rule = rule.getName();
+                        c.boundary = boundary;
+                        c.threads = threaded ? threads[t] : 1;
+                        c.size = sizes[s];
+                        c.density = w < densities.size() ? densities[w] : 0;
+                        c.seedFile = w < densities.size() ? "" :
+                                     seeds[w - densities.size()];
+                        c.gens = gens > 0 ? gens : defaultGens(sizes[s]);
+                        c.rng = rng;
+                        c.block = block;
+                        cases.push_back(c);
+                    }
+                }
+            }
+        }
+    }
+
+    // run the cases
+    std::map<std::string, long long> reference; // population per case
+    bool failed = false;
+    if (json) {
+        std::cout << "[" << std::endl;
+    } else {
+        std::cout << "engine,threads,size,workload,rule,generations,seconds,"
+                     "gens_per_sec,cell_updates_per_sec,ns_per_cell,"
+                     "population,peak_rss_kb,match" << std::endl;
+    }
+    for (size_t i = 0; i < cases.size(); i++) {
+        const Case &c = cases[i];
+        long peakKB;
+        Result r = forkCase(c, peakKB);
+
+        // describe the workload
+        Engine *engine = Engine::create(c.backend, 1, 1, 1);
+        std::string name = engine->getName();
+        bool bounded = engine->isBounded();
+        delete engine;
+        char workload[64];
+        if (c.seedFile.empty()) {
+            snprintf(workload, sizeof(workload), "soup%g", c.density);
+        } else {
+            snprintf(workload, sizeof(workload), "%.63s", c.seedFile.c_str());
+        }
+
+        // compare with the first engine of the same kind on this case
+        std::ostringstream key;
+        key << c.size << " " << workload << " " << c.rule << " " << bounded;
+        const char *match = "-";
+        if (!r.ok) {
+            match = "failed";
+            failed = true;
+        } else if (reference.count(key.str()) == 0) {
+            reference[key.str()] = r.population;
+        } else if (reference[key.str()] == r.population) {
+            match = "yes";
+        } else {
+            match = "no";
+            failed = true;
+        }
+
+        double cells = static_cast<double>(c.size) * c.size * c.gens;
+        double gensPerSec = r.seconds > 0 ? c.gens / r.seconds : 0;
+        double cellsPerSec = r.seconds > 0 ? cells / r.seconds : 0;
+        double nsPerCell = 1e9 * r.seconds / cells;
+        char line[512];
+        if (json) {
+            snprintf(line, sizeof(line),
+                     "  {\"engine\": \"%s\", \"threads\": %d, \"size\": %d, "
+                     "\"workload\": \"%s\", \"rule\": \"%s\", "
+                     "\"generations\": %lld, "
+                     "\"seconds\": %.6f, \"gens_per_sec\": %.6g, "
+                     "\"cell_updates_per_sec\": %.6g, \"ns_per_cell\": %.6g, "
+                     "\"population\": %lld, \"peak_rss_kb\": %ld, "
+                     "\"match\": \"%s\"}%s",
+                     name.c_str(), c.threads, c.size, workload,
+                     c.rule.c_str(), c.gens,
+                     r.seconds, gensPerSec, cellsPerSec, nsPerCell,
+                     r.population, peakKB, match,
+                     i + 1 < cases.size() ? "," : "");
+        } else {
+            snprintf(line, sizeof(line),
+                     "%s,%d,%d,%s,%s,%lld,%.6f,%.6g,%.6g,%.6g,%lld,%ld,%s",
+                     name.c_str(), c.threads, c.size, workload,
+                     c.rule.c_str(), c.gens,
+                     r.seconds, gensPerSec, cellsPerSec, nsPerCell,
+                     r.population, peakKB, match);
+        }
+        std::cout << line << std::endl;
+    }
+    if (json) {
+        std::cout << "]" << std::endl;
+    }
+
+    return failed ? 1 : 0;
+}
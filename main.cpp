@@ -5,20 +5,428 @@
  ** Description: Main program for Game of Life
  ** Input:  The user chooses from a menu of starting patterns and
  **         specifies the starting location and number of time steps.
+ **         Optional arguments:
+ **           --backend=universe|bool|packed|hashlife|domain  simulation
+ **             engine (default universe)
+ **           --simd=auto|scalar|sse2|avx2|avx512  instruction set used
+ **             to step the packed grid
+ **           --threads N  threads stepping the packed grid or universe,
+ **             or processes stepping the domain engine's bands
+ **           --block K  step the packed grid K generations (at most 32)
+ **             per pass over memory, on a plane or dead edges, while
+ **             no statistics are kept (default 1)
+ **           --width W --height H  number of cells shown on screen, and
+ **             grid size of the bounded engines (default 40 x 20)
+ **           --boundary=plane|dead|torus|klein  edges of the grid of
+ **             the bounded engines: a hidden margin past the screen,
+ **             dead cells at the screen's edge, or wrapping around it,
+ **             as a torus or a Klein bottle (default plane)
+ **           --soups N  run a soup search instead: N random soups,
+ **             each on its own board, until the board repeats, with a
+ **             census of the objects they leave (the board is 256 x
+ **             256, a torus and packed unless chosen with --width,
+ **             --height, --boundary and --backend; the search runs on
+ **             every core unless --threads is given); --soup-size S
+ **             and --density F give the soups' size and fill (default
+ **             16 x 16, 0.5), --rng N the random number seed they are
+ **             filled from, --max-gens N when to give up on one
+ **             (default 100000) and --out FILE a file for the census
+ **           --braille  show 2 x 4 cells per braille character
+ **           --every N  draw every Nth time step
+ **           --fps F  frames per second; with --every, frames are paced
+ **             to this rate, otherwise the simulation runs flat out and
+ **             the latest time step is drawn at this rate (default a
+ **             frame every time step, ten per second)
+ **           --library DIR  offer the patterns in DIR and the
+ **             directories below it in the menu instead of the bundled
+ **             ones, indexed and cached in DIR on first use
+ **           --pattern NAME  run without display from the --library
+ **             pattern of that name, or of that path below DIR where
+ **             several patterns share a name
+ **           --fill F  run without display from a random soup filling
+ **             the grid, each cell live with chance F, from the random
+ **             number seed --rng N (default 1); the soup is the same on
+ **             every engine and number of threads
+ **           --rule RULE  rule in B/S notation, e.g. B36/S23, with /C
+ **             and a number of states for a Generations rule and a V or
+ **             H suffix for the von Neumann or hexagonal neighborhood
+ **             (default the seed file's rule, or Conway's Life B3/S23)
+ **           --restore FILE  run without display from a checkpoint
+ **             instead of a seed; --verify checks the cells' checksum
+ **           --checkpoint FILE  save a checkpoint at the end of a run
+ **             without display, and every N generations with
+ **             --checkpoint-every N
+ **           --cycle=auto|skip|stop|off  on finding that the board
+ **             repeats (died out, still life or oscillator), skip ahead
+ **             whole periods, stop, or do not look; auto skips with the
+ **             packed grid and universe, which hash boards cheaply, and
+ **             does not look with the others (default auto)
+ **           --history FILE  write each generation's population,
+ **             births, deaths and the box around its live cells to
+ **             FILE (or a named pipe) as comma separated values, in a
+ **             run without display
+ **           --export FILE  write pictures of the cells on screen in a
+ **             run without display: a PGM or PNG file per picture, the
+ **             generation added to FILE's name, or the frames of an
+ **             animated GIF, chosen by FILE's extension, with --fps
+ **             frames per second; every N generations with
+ **             --export-every N, a pixel for each K x K cells with
+ **             --export-scale K, shaded by how many are alive, and each
+ **             pixel drawn Z x Z with --export-zoom Z
+ **           --stats  time each phase of the run and count the work
+ **             done (cells evaluated, tiles stepped and skipped,
+ **             births, deaths, bytes drawn), printing a summary at exit
+ **           --trace FILE  also write each generation's time and work
+ **             to FILE, as comma separated values, or as Chrome trace
+ **             events if FILE ends in .json
  ** Output: Animation showing the evolution of the pattern with time.
  *********************************************************************/
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
 #include "Game.hpp"
+#include "Batch.hpp"
+#include "Ensemble.hpp"
+#include "PatternLibrary.hpp"
+#include "Kernel.hpp"
+#include "Trace.hpp"
 
+// value of a "--name=value" or "--name value" argument; advances a
+// past a separate value and returns false if arg is not the option
+static bool option(const std::string &arg, const char *name, int argc,
+                   const char *argv[], int &a, std::string &value) {
+    std::string prefix = std::string("--") + name;
+    if (arg == prefix && a + 1 < argc) {
+        value = argv[++a];
+        return true;
+    }
+    if (arg.compare(0, prefix.size() + 1, prefix + "=") == 0) {
+        value = arg.substr(prefix.size() + 1);
+        return true;
+    }
+    return false;
+}
+
+// end tracing, printing the summary if asked to; returns the program's
+// status, failing if the trace file could not be written
+static int endTrace(int status, bool stats, const std::string &traceFile) {
+    if (!Trace::finish()) {
+        std::cerr << "Could not write " << traceFile << std::endl;
+        status = 1;
+    }
+    if (stats) {
+        Trace::report(std::cerr);
+    }
+    return status;
+}
 
 int main(int argc, const char * argv[]) {
     
     int nticks; // number of time steps (ticks)
     char again; // Loop again? Y or N
+    Backend backend = UNIVERSE_BACKEND; // simulation engine
+    SimdLevel simd = SIMD_AUTO;       // packed grid kernel
+    int nthreads = 1;                 // threads stepping the packed grid
+    int block = 1;                    // generations per pass over memory
+    
+    std::string seedFile;             // batch mode seed pattern
+    std::string libraryDir;           // directory of the pattern library
+    std::string patternName;          // batch mode library pattern
+    std::string outFile;              // batch mode output file
+    std::string restoreFile;          // batch mode checkpoint to resume
+    std::string checkpointFile;       // batch mode checkpoint to save
+    long long checkpointEvery = 0;    // generations between checkpoints
+    bool verify = false;              // check restored cells' checksum
+    std::string ruleName;             // rule, empty for the default
+    long long ngens = 100;            // batch mode generations
+    long long x = 20, y = 10;         // batch mode pattern location
+    int width = 40, height = 20;      // cells on screen, grid size
+    int every = -1;                   // time steps per frame
+    double fps = -1;                  // frames per second
+    bool braille = false;             // 2 x 4 cells per character
+    CycleAction cycle = CYCLE_AUTO;   // what a repeating board does
+    Boundary boundary = PLANE_BOUNDARY; // edges of a bounded grid
+    long long nsoups = 0;             // soups to search, 0 for none
+    int soupSize = 16;                // width and height of a soup
+    double density = 0.5;             // fill of a soup
+    unsigned long long rng = 1;       // random number seed of the soups
+    double fill = -1;                 // batch mode soup fill, -1 for none
+    long long maxGens = 100000;       // generations a soup may run
+    bool given[4] = { false, false, false, false }; // backend, size,
+                                      // boundary and threads chosen
+    bool stats = false;               // print time and work at exit
+    std::string traceFile;            // file each generation is traced to
+    std::string historyFile;          // batch mode statistics file
+    std::string exportFile;           // batch mode picture file
+    long long exportEvery = 1;        // generations between pictures
+    int exportScale = 1;              // cells per side of a pixel
+    int exportZoom = 1;               // pixels per side of a pixel
+    
+    // read command line options
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        std::string value;
+        bool ok = true;
+        if (option(arg, "backend", argc, argv, a, value)) {
+            ok = Engine::parseBackend(value, backend);
+            given[0] = true;
+        } else if (option(arg, "simd", argc, argv, a, value)) {
+            ok = parseSimd(value, simd);
+            if (ok && !setSimdLevel(simd)) {
+                std::cerr << "This CPU does not support --simd=";
+                std::cerr << simdName(simd) << std::endl;
+                return 1;
+            }
+        } else if (option(arg, "threads", argc, argv, a, value)) {
+            nthreads = atoi(value.c_str());
+            given[3] = true;
+        } else if (option(arg, "block", argc, argv, a, value)) {
+            block = atoi(value.c_str());
+            ok = block > 0;
+        } else if (option(arg, "seed", argc, argv, a, value)) {
+            seedFile = value;
+        } else if (option(arg, "library", argc, argv, a, value)) {
+            libraryDir = value;
+        } else if (option(arg, "pattern", argc, argv, a, value)) {
+            patternName = value;
+        } else if (option(arg, "out", argc, argv, a, value)) {
+            outFile = value;
+        } else if (option(arg, "rule", argc, argv, a, value)) {
+            ruleName = value;
+        } else if (option(arg, "restore", argc, argv, a, value)) {
+            restoreFile = value;
+        } else if (option(arg, "checkpoint", argc, argv, a, value)) {
+            checkpointFile = value;
+        } else if (option(arg, "checkpoint-every", argc, argv, a, value)) {
+            checkpointEvery = atoll(value.c_str());
+            ok = checkpointEvery > 0;
+        } else if (arg == "--verify") {
+            verify = true;
+        } else if (option(arg, "gens", argc, argv, a, value)) {
+            ngens = atoll(value.c_str());
+        } else if (option(arg, "x", argc, argv, a, value)) {
+            x = atoll(value.c_str());
+        } else if (option(arg, "y", argc, argv, a, value)) {
+            y = atoll(value.c_str());
+        } else if (option(arg, "width", argc, argv, a, value)) {
+            width = atoi(value.c_str());
+            given[1] = true;
+        } else if (option(arg, "height", argc, argv, a, value)) {
+            height = atoi(value.c_str());
+            given[1] = true;
+        } else if (option(arg, "every", argc, argv, a, value)) {
+            every = atoi(value.c_str());
+            ok = every > 0;
+        } else if (option(arg, "fps", argc, argv, a, value)) {
+            fps = atof(value.c_str());
+            ok = fps > 0;
+        } else if (option(arg, "cycle", argc, argv, a, value)) {
+            ok = CycleDetector::parseAction(value, cycle);
+        } else if (option(arg, "boundary", argc, argv, a, value)) {
+            ok = Engine::parseBoundary(value, boundary);
+            given[2] = true;
+        } else if (option(arg, "soups", argc, argv, a, value)) {
+            nsoups = atoll(value.c_str());
+            ok = nsoups > 0;
+        } else if (option(arg, "soup-size", argc, argv, a, value)) {
+            soupSize = atoi(value.c_str());
+            ok = soupSize > 0;
+        } else if (option(arg, "density", argc, argv, a, value)) {
+            density = atof(value.c_str());
+            ok = density >= 0 && density <= 1;
+        } else if (option(arg, "fill", argc, argv, a, value)) {
+            fill = atof(value.c_str());
+            ok = fill >= 0 && fill <= 1;
+        } else if (option(arg, "rng", argc, argv, a, value)) {
+            rng = strtoull(value.c_str(), NULL, 10);
+        } else if (option(arg, "max-gens", argc, argv, a, value)) {
+            maxGens = atoll(value.c_str());
+            ok = maxGens > 0;
+        } else if (arg == "--braille") {
+            braille = true;
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (option(arg, "trace", argc, argv, a, value)) {
+            traceFile = value;
+        } else if (option(arg, "history", argc, argv, a, value)) {
+            historyFile = value;
+        } else if (option(arg, "export", argc, argv, a, value)) {
+            exportFile = value;
+        } else if (option(arg, "export-every", argc, argv, a, value)) {
+            exportEvery = atoll(value.c_str());
+            ok = exportEvery > 0;
+        } else if (option(arg, "export-scale", argc, argv, a, value)) {
+            exportScale = atoi(value.c_str());
+            ok = exportScale > 0;
+        } else if (option(arg, "export-zoom", argc, argv, a, value)) {
+            exportZoom = atoi(value.c_str());
+            ok = exportZoom > 0;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "usage: life";
+            std::cerr << " [--backend=universe|bool|packed|hashlife|domain]";
+            std::cerr << " [--simd=auto|scalar|sse2|avx2|avx512]";
+            std::cerr << " [--threads N]" << std::endl;
+            std::cerr << "            [--block K] [--library DIR] [--pattern NAME]";
+            std::cerr << " [--fill F [--rng N]]" << std::endl;
+            std::cerr << "            [--seed FILE [--gens N] [--x X] [--y Y]";
+            std::cerr << " [--out FILE] [--history FILE]" << std::endl;
+            std::cerr << "             [--export FILE [--export-every N]";
+            std::cerr << " [--export-scale K] [--export-zoom Z]]]";
+            std::cerr << std::endl;
+            std::cerr << "            [--restore FILE [--verify]]";
+            std::cerr << " [--checkpoint FILE [--checkpoint-every N]]";
+            std::cerr << std::endl;
+            std::cerr << "            [--cycle=auto|skip|stop|off]";
+            std::cerr << " [--boundary=plane|dead|torus|klein]" << std::endl;
+            std::cerr << "            [--soups N [--soup-size S] [--density F]";
+            std::cerr << " [--rng N] [--max-gens N] [--out FILE]]" << std::endl;
+            std::cerr << "            [--width W] [--height H] [--braille]";
+            std::cerr << " [--every N] [--fps F] [--rule RULE]" << std::endl;
+            std::cerr << "            [--stats] [--trace FILE]" << std::endl;
+            return 1;
+        }
+    }
+    
+    if (width < 1 || height < 1) {
+        std::cerr << "Grid size must be positive" << std::endl;
+        return 1;
+    }
+    Rule rule;
+    if (!ruleName.empty() && !rule.parse(ruleName)) {
+        std::cerr << rule.getError() << std::endl;
+        return 1;
+    }
+    if (stats) {
+        Trace::enable();
+    }
+    if (!traceFile.empty() && !Trace::stream(traceFile)) {
+        std::cerr << "Could not create " << traceFile << std::endl;
+        return 1;
+    }
+    
+    // search soups when asked to, on bounded boards that wrap
+    if (nsoups > 0) {
+        Ensemble ensemble(given[0] ? backend : PACKED_BACKEND,
+                          given[1] ? width : 256, given[1] ? height : 256,
+                          given[3] ? nthreads : 0);
+        if (!ensemble.setRule(rule)) {
+            std::cerr << "Soup searches cannot run " << rule.getName();
+            std::cerr << " on the chosen engine; they need a rule without";
+            std::cerr << " dying states" << std::endl;
+            return 1;
+        }
+        if (!ensemble.setBoundary(given[2] ? boundary : TORUS_BOUNDARY)) {
+            std::cerr << "Soup searches need --boundary=torus or dead and";
+            std::cerr << " --backend=packed or bool" << std::endl;
+            return 1;
+        }
+        ensemble.setSoup(soupSize, density, rng);
+        ensemble.setMaxGens(maxGens);
+        return endTrace(ensemble.run(nsoups, outFile), stats, traceFile);
+    }
+    
+    // run without display when a seed or checkpoint file, a library
+    // pattern or a soup fill is given
+    if (!seedFile.empty() || !restoreFile.empty() || !patternName.empty() ||
+        fill >= 0) {
+        if (ngens < 0) {
+            std::cerr << "Generations must not be negative" << std::endl;
+            return 1;
+        }
+        if (!seedFile.empty() + !restoreFile.empty() + !patternName.empty() +
+            (fill >= 0) > 1) {
+            std::cerr << "Give only one of --seed, --restore, --pattern and";
+            std::cerr << " --fill" << std::endl;
+            return 1;
+        }
+        Batch batch(backend, width, height, nthreads);
+        batch.setRule(ruleName);
+        if (!batch.setBoundary(boundary) || !batch.setBlock(block)) {
+            return 1;
+        }
+        if (!restoreFile.empty() && !batch.restore(restoreFile, verify)) {
+            return 1;
+        }
+        if (!patternName.empty() && libraryDir.empty()) {
+            std::cerr << "--pattern needs --library DIR" << std::endl;
+            return 1;
+        }
+        if (!patternName.empty()) {
+            PatternLibrary library;
+            Seed seed;
+            if (!library.open(libraryDir)) {
+                std::cerr << library.getError() << std::endl;
+                return 1;
+            }
+            int n = library.find(patternName);
+            if (n == PatternLibrary::AMBIGUOUS) {
+                std::vector<int> found;
+                library.search(patternName, 0, 0, found);
+                std::cerr << "Several patterns are named " << patternName;
+                std::cerr << "; give one of:";
+                for (size_t i = 0; i < found.size(); i++) {
+                    if (library.getName(found[i]) == patternName) {
+                        std::cerr << " " << library.getLabel(found[i]);
+                    }
+                }
+                std::cerr << std::endl;
+                return 1;
+            }
+            if (n < 0) {
+                std::cerr << "No pattern named " << patternName << " in ";
+                std::cerr << libraryDir << std::endl;
+                return 1;
+            }
+            if (!library.load(n, seed)) {
+                std::cerr << library.getError() << std::endl;
+                return 1;
+            }
+            batch.setPattern(seed);
+        }
+        if (fill >= 0) {
+            batch.setSoup(fill, rng);
+        }
+        batch.setCheckpoint(checkpointFile, checkpointEvery);
+        batch.setCycleAction(cycle);
+        batch.setHistory(historyFile);
+        if (!exportFile.empty() &&
+            !batch.setExport(exportFile, exportEvery, exportScale, exportZoom,
+                             fps > 0 ? static_cast<int>(100 / fps + 0.5) : 10)) {
+            return 1;
+        }
+        return endTrace(batch.run(seedFile, ngens, x, y, outFile), stats,
+                        traceFile);
+    }
     
     // create a new game
-    Game myGame;
+    Game myGame(backend, nthreads, width, height, braille);
+    if (!myGame.setRule(rule)) {
+        std::cerr << "The chosen engine cannot run " << rule.getName();
+        std::cerr << "; try --backend=bool" << std::endl;
+        return 1;
+    }
+    if (!myGame.setBoundary(boundary)) {
+        std::cerr << "The chosen engine has no edges; try --backend=packed";
+        std::cerr << std::endl;
+        return 1;
+    }
+    if (!myGame.setBlock(block)) {
+        std::cerr << "Only --backend=packed steps several generations per";
+        std::cerr << " pass" << std::endl;
+        return 1;
+    }
+    if (!libraryDir.empty() && !myGame.setLibrary(libraryDir)) {
+        return 1;
+    }
+    myGame.setCycleAction(cycle);
+    if (every > 0 || fps > 0) {
+        myGame.setFrameRate(every > 0 ? every : 0, fps > 0 ? fps : 0);
+    }
     std::cout << "*** Welcome to the Game of Life ***" << std::endl;
     std::cout << std::endl;
     
@@ -30,14 +438,12 @@ int main(int argc, const char * argv[]) {
         myGame.setSeed();
         
         // run for specified number of time steps (ticks)
-        for (int t = 0; t < nticks; t++) {
-            myGame.calcTick();
-        }
+        myGame.run(nticks);
         
         std::cout << "Do you want to try another pattern? (Y/N) ";
         std::cin >> again;
         
     } while (again == 'Y' || again == 'y');
     
-    return 0;
+    return endTrace(0, stats, traceFile);
 }